@@ -7,7 +7,8 @@ Supports:
 - CRC-32 (IEEE)
 - CRC-64 (ECMA-182)
 - xxHash64
-- xxHash128
+- XXH3 (64-bit)
+- XXH3-128
 
 -----------------
 Revision History:
@@ -126,34 +127,276 @@ Revision History:
     -Exact ABI match
 -Added "-flto" to compiler flag
 
-Compilation:
+0.19
+-Multithreaded CRC32 (POSIX threads), as promised in 0.8
+    -File split into one range per thread, each range hashed with crc32_simd()
+    -Partial CRCs merged with crc32_combine() (GF(2) "x^n mod P" shift)
+    -Thread count defaults to the online CPU count, override with -j N / --threads N
+    -Ranges smaller than 1 MB are not split
+    -Used in normal mode only, single-pass (-s) stays on one core
 
-    gcc crc.c -O3 -msse4.2 -pthread -o crc
+0.20
+-Restored the specialized single-pass loops from 0.11
+    -One kernel per combination of enabled hashes, generated with an X-macro
+    -Kernel is picked once from sp_kernels[] before processing, no do_* tests in the loop
+    -CRC32 uses the 8-byte _mm_crc32_u64() path again, other hashes walk the same 8 bytes
+    -Data is processed in 256 KB blocks, progress is only checked between blocks
+    -No more modulo per byte for the progress bar
+-Fixed xxHash128 on its own (-H) not feeding the xxHash64 state it is derived from
+
+0.21
+-Slicing-by-16 table engines for CRC-16 and CRC-64
+    -crc16_table / crc64_table grew to 16 x 256 entries (table k = byte followed by k zero bytes)
+    -16 bytes per step instead of one, the per-byte dependency chain is gone
+    -Slicing-by-16 measured ~2x faster than slicing-by-8 for CRC-64, so only 16 is kept
+
+0.22
+-Carry-less multiply (PCLMULQDQ) folding for CRC-16, CRC-32 and CRC-64
+    -One generic engine, fold constants (x^n mod P) derived from CRC16_POLY / CRC64_POLY / CRC-32C
+    -PCLMUL: 8 x 128-bit accumulators, 128 bytes per iteration
+    -VPCLMULQDQ (AVX-512): 4 x 512-bit accumulators, 256 bytes per iteration
+    -Residue reduced through the table / crc32 instruction, tails too
+    -Enabled when compiled with -mpclmul (-march=native), AVX-512 path with -mvpclmulqdq -mavx512bw
+    -Single-pass kernels now run each hash over L1-sized 8 KB pieces so they can use the folding engines
+
+0.23
+-Runtime CPU dispatch, -march=native / -msse4.2 no longer needed
+    -CPU features read once with cpuid (+ xgetbv for OS AVX / AVX-512 state)
+    -Kernels compiled per ISA with __attribute__((target)): scalar, sse4.2, pclmul, avx2, avx512
+    -avx2 level = 256-bit VPCLMULQDQ folding, 4 accumulators, 128 bytes per iteration
+    -Scalar CRC-32C slicing-by-16 table, so CPUs without SSE4.2 no longer die with SIGILL
+    -Best level picked at startup, --force-isa ISA overrides it for testing
+    -Debug screen uses the cpuid flags instead of parsing /proc/cpuinfo per flag, shows the dispatch level
+
+0.24
+-Real xxHash64 (matches xxhsum -H64)
+    -4 independent lanes over 32-byte stripes, reference merge / tail / avalanche
+    -Streaming xxh64_reset() / xxh64_update() / xxh64_digest(), used by the single-pass kernels
+    -Reuses the XX_P1..XX_P5 constants
+    -NOTE: xxH64 values differ from earlier versions, which used a non-standard byte mix
+    -Used in benchmark, single-pass and normal mode
+
+0.25
+-Real XXH3 64-bit and XXH3-128 (match xxhsum -H3 / -H2)
+    -Default secret, short paths for 0-16, 17-128 and 129-240 bytes
+    -Long inputs: 8 accumulators over 64-byte stripes, scrambled every 1 KB block
+    -Accumulate / scramble kernels for scalar, SSE2, AVX2, AVX-512 and NEON (aarch64), picked by the dispatcher
+    -Streaming xxh3_reset() / xxh3_update() plus 64- and 128-bit digests from the same state
+    -New --x3 (-3) option, --x128 (-H) now prints XXH3-128 instead of a value derived from xxHash64
+    -avx2 / avx512 levels no longer need VPCLMULQDQ, CRC folding drops to 128-bit PCLMUL without it
+    -Single-pass kernels cover 32 hash combinations
+
+0.26
+-Streaming input for stdin ("-" or no file with a pipe), FIFOs, character / block devices
+    -Reader thread fills 3 x 1 MB aligned buffers, hashing runs on the previous buffer
+    -Memory stays bounded whatever the input size, same hash state as the mmap path
+    -Block device size read with BLKGETSIZE64 for the progress bar, unknown sizes show "stream"
+    -Empty files are hashed instead of rejected, mmap failures fall back to streaming
+    -Streams are single-pass, benchmark mode still needs a regular file
+
+0.27
+-io_uring input backend for cold-cache files and NVMe devices (--io=uring)
+    -O_DIRECT reads into a ring of registered, 4 KB aligned 1 MB buffers (READ_FIXED)
+    -Queue depth set with --qd N (default 8), buffers consumed in file order as they complete
+    -Raw syscalls, no liburing needed; falls back to read() when io_uring / O_DIRECT is refused
+    -New --io=mmap|read|uring switch, read = the streaming reader from 0.26
+
+0.28
+-Windowed mmap: a 1 GB view (256 MB on 32-bit) slides across the file instead of one whole-file mapping
+    -64 MB steps, MADV_SEQUENTIAL per window, MADV_WILLNEED 128 MB ahead of the cursor
+    -MADV_DONTNEED behind the cursor keeps RSS flat (~65 MB for a 2.3 GB file, was the file size)
+    -Last pass over files larger than a window drops them from the page cache (POSIX_FADV_DONTNEED)
+    -Threaded CRC-32 runs per step and is merged with crc32_combine()
+    -New --hugepage (MADV_HUGEPAGE) and --populate (MAP_POPULATE) options
+    -Benchmark mode keeps the whole-file mapping
+
+0.29
+-Multi-file mode: several paths, or directories with -r, print one digest line per file
+    -Work-stealing scheduler, -j workers with one task deque each
+    -Files >= 256 MB are split into 64 MB CRC chunks merged with crc16/32/64_combine()
+    -xxHash64 and XXH3 stay sequential per file so they still match xxhsum
+    -Directories are walked with getdents64 in sorted order, output keeps input order
+
+0.30
+-Small files (<= 64 KB) in multi-file mode are read with one pread() into a per-worker arena
+    -No mmap/madvise/munmap per file, ~30% faster on a tree of 20k small files
+
+0.31
+-crc16_shift() / crc32_shift() / crc64_shift(): advance a CRC over n zero bytes in O(log n)
+    -crc16/32/64_combine() are now written on top of them
+-New --combine FILE: whole-object CRC from a sidecar of '<crc hex> <length>' part lines
+
+0.32
+-Hashing engines moved to libcrc.c / libcrc.h, built as libcrc.a and libcrc.so by the new Makefile
+    -Multi-hash context: hash_init(mask) / hash_update() / hash_final(), no allocation
+    -libcrc_init() sets up tables and dispatch once (pthread_once), hash_init() calls it
+    -Only the libcrc.h API is exported from the shared library
+    -crc links libcrc.a and uses the same API
+
+0.33
+-Fused multi-hash kernels for AVX-512 + VPCLMULQDQ, used whenever two or more hashes are selected
+    -256-byte blocks: 4 x 64-byte loads feed the CRC-16/32/64 folds and the XXH3 accumulator
+    -XXH64 stripes of the same block run in the loop body under the vector work
+    -All hashes in cache: 5.3 -> 7.9 GB/s, XXH64 alone is 10.4 GB/s
+
+0.34
+-Benchmark mode rewritten: CLOCK_MONOTONIC + TSC timing instead of clock() (CPU time)
+    -Warmup runs, then N repetitions per hash, reported as median / p99 MB/s and cycles per byte
+    -Short hashes are looped to at least 5 ms per repetition, so 64-byte buffers time correctly
+    -Without a file, RAM buffers of the --bench-size sizes (64 B .. 1 GB and more)
+    -Every digest is cross-checked against a hash_state pass, a mismatch fails the run
+    -New --reps, --warmup, --bench-size and --cold (POSIX_FADV_DONTNEED before each repetition)
+-now_seconds() uses CLOCK_MONOTONIC
+
+0.35
+-Kernel registry in libcrc: impl_get() / impl_hash() / select_impl() for every kernel of every hash
+    -New byte-at-a-time "table" CRC kernels next to slicing-by-16, for tiny inputs
+    -A hash can take a second kernel for calls up to a size (e.g. sse4.2 CRC-32 up to 64 B)
+-Tuning profile: libcrc_init() loads $LIBCRC_PROFILE or /etc/libcrc.profile, unsupported kernels are skipped
+-New --all-impls: -b times every kernel this CPU runs, cross-checks the digests and picks winners
+    -New --save-profile[=FILE] writes the winners as the tuning profile
+    -Benchmark tables gained a Kernel column
+-Debug screen lists the kernel of each hash, --force-isa replaces the profile
+
+0.36
+-New --sweep: -b over 1, 2, 4 ... -j threads with GB/s, speedup and parallel efficiency per hash
+    -CRC ranges merge through crcN_combine() and are checked, xxHash ranges are independent slices
+    -Workers wait on barriers between passes, thread start-up is not timed
+-NUMA topology from sysfs, page nodes from move_pages(2), no libnuma
+    -New --numa CPU[:MEM]: sweep workers on node CPU, RAM buffer first touched on node MEM
+    -crc32_parallel() starts each range thread on the node that holds its pages
+
+0.37
+-Progress moved to a reporter thread (nice 19) that samples an atomic byte counter every 200 ms
+    -The hashing loops only add to the counter, no more printf / putchar / fflush in them
+    -Bar shows throughput and ETA and spans both passes of normal mode
+    -New --progress=auto|bar|json|none, auto draws the bar only when stdout is a terminal
+    -json: one object per sample on stderr, the last one has "final":true
+
+0.38
+-CRC slicing, combine and fold tables generated at build time by gen_tables.c into crc_tables.h
+    -static const arrays in .rodata, libcrc_init() no longer computes any table
+    -make tables regenerates the header, which checks the polynomials it was built for
+
+0.39
+-New --check / -c FILE: verify a manifest through the multi-file scheduler
+    -sha256sum-style lines with the selected hashes, or BSD tagged lines that name their hash
+    -Prints only failures and a summary on stderr, exit status 1 on any failure or bad line
+    -Every file computes only the hashes its manifest line asks for
+
+0.40
+-New --cache FILE: digests of unchanged files come from a sidecar index, keyed by
+ dev, inode, size, mtime and ctime, without opening them (multi-file and --check modes)
+    -Index: header plus a sorted array of fixed entries, mmap'ed and binary searched
+    -Rewritten through a temp file and rename, old entries kept, hashes merged per file
+    -Files changed within 2 s of the run start are not stored (racy timestamps)
+    -New --rehash: read every file again and refresh the cache
+
+0.41
+-New --blocks INDEX: per-block digests (--block-size, default 4 MB) as a JSON index
+    -Same pass as the whole-file digest, the blocks of each piece are hashed in parallel
+    -Whole-file CRC combined from the block CRCs, xxHash streamed by the calling thread
+-New --verify-blocks INDEX [FILE]: prints the byte ranges of the blocks that differ
+
+0.42
+-Sparse files: holes found with SEEK_HOLE / SEEK_DATA are never read or mapped
+    -CRCs step over them with crcN_shift(), xxHash runs its rounds on no input
+    -No readahead for pieces that are all hole, block indexes reuse a zero-block digest
+-libcrc: new hash_update_zeros()
+
+0.43
+-New --crc NAME: a CRC of the catalogue (Rocksoft parameter sets) for one file or stdin
+    -20 models: CRC-8 to CRC-64, e.g. CRC-32/ISO-HDLC (zlib), CRC-64/XZ, CRC-64/NVME, CRC-16/ARC
+    -Per-model slicing tables and folding constants generated by gen_tables.c
+    -Table, PCLMUL, AVX2 and AVX-512 kernels, holes stepped over with crc_model_shift()
+-New --list-crcs: the catalogue, each model checked against "123456789"
+-libcrc: new crc_model_* API
+
+0.44
+-aarch64 backends: CRC32 instructions (__crc32cd) for CRC-32C, PMULL folding for CRC-16 / 32 / 64
+    -New dispatch levels armv8 (NEON XXH3 + CRC32) and pmull, detected with getauxval(AT_HWCAP)
+    -Catalogue: CRC-32/ISO-HDLC and CRC-32/ISCSI on __crc32d / __crc32cd, PMULL folding for the rest
+    -x86 kernels, cpuid and the fused AVX-512 kernels only built on x86
+-Other architectures (riscv64, ppc64, ...) build with the table / scalar kernels, -DLIBCRC_PORTABLE forces it
+-Debug screen shows the NEON / CRC32 / PMULL flags on aarch64
+
+0.45
+-New --gpu / --gpu-min SIZE: CRCs of big files on an OpenCL GPU, xxHashes on the CPU in the same read
+    -Two pinned 64 MB staging buffers, read and xxHashed while the device works on the other one
+    -16 KB pieces per work-item, chained on the host with crcN_shift()
+    -libOpenCL loaded with dlopen(), CPU fallback without a runtime / GPU or after a device error
+    -Multi-file and check mode: one file on the device at a time, the rest stays on the CPU
+
+0.46
+-New --stats[=FILE]: one JSON object at exit for exporters (stderr or FILE)
+    -Time per stage (open, read, map, fault, hash, combine, output), summed over threads
+    -Bytes per hash and kernel (main, small-input and GPU), hole bytes stepped over
+    -getrusage(): user / sys time, max RSS, minor / major page faults, blocks, context switches
+-New --perf: perf_event_open() cycles, instructions and LLC misses for the run, per row with -b
+    -User space only under perf_event_paranoid >= 2, "perf": null without a PMU
+
+0.47
+-New --format=text|json|csv|tag|binary for normal and multi-file mode
+    -json: JSON Lines with path, size and a hex string per hash (or the error)
+    -csv: header row and RFC 4180 quoting, tag: BSD lines that --check reads back
+    -binary: big-endian digests, then the path and a NUL
+-Multi-file output from one writer thread through a 1 MB write() buffer, no stdio per line
+-New --no-color, colors are also off when the stream is not a terminal or NO_COLOR is set
+
+0.48
+-Makefile: release (-O3 -flto=auto), per-ISA (-march) and profile-guided builds
+    -make pgo: -fprofile-generate, a training run (benchmark over mixed sizes, normal,
+     stdin, multi-file and check runs over 0 B to 64 MB files), then -fprofile-use
+    -The debug screen reports LTO / PGO of those builds (__LTO__, __PGO_* set by make)
+
+Compilation (portable, kernels are picked at runtime):
+
+    make
+
+    or a release build (LTO), per-ISA builds or a profile-guided one,
+
+    make release / make isa / make pgo
 
     or,
 
-    gcc crc.c -O3 -march=native -Wall -Wextra -msse4.2 -pthread -o crc
+    gcc crc.c libcrc.c -O3 -Wall -Wextra -pthread -ldl -o crc
 
     or if you want to add compiler flag to the debug screen,
 
-    gcc crc.c -O3 -march=native -flto -Wall -Wextra -msse4.2 -pthread -DCOMPILER_FLAGS="\"-O3 -march=native -flto -Wall -Wextra -msse4.2 -pthread\"" -o crc
+    gcc crc.c libcrc.c -O3 -flto -Wall -Wextra -pthread -DCOMPILER_FLAGS="\"-O3 -flto -Wall -Wextra -pthread\"" -ldl -o crc
 
 */
 
 #define _GNU_SOURCE
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <linux/fs.h>
 #include <time.h>
-#include <immintrin.h>
-#include <sys/time.h>
+#include <pthread.h>
 #include <sys/utsname.h>
+#include <sys/resource.h>
+#include <dlfcn.h>
+#include <linux/perf_event.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include "libcrc.h"
 
 /* ================= COMPILER INFO ================= */
 #if defined(__clang__)
@@ -212,9 +455,11 @@ Compilation:
 #endif
 
 /* ================= CONFIG ================= */
-#define VERSION "0.18"
+#define VERSION "0.48"
 #define BUILD_DATE __DATE__ " " __TIME__
 
+#define SP_BLOCK (256 * 1024)   /* bytes per kernel call, the progress granularity */
+
 /* ================= ANSI COLORS ================= */
 #define C_RESET   "\033[0m"
 #define C_GREEN   "\033[32m"
@@ -226,69 +471,77 @@ Compilation:
 #define C_MAGENTA "\033[35m"   // same as purple in standard ANSI
 #define C_CYAN    "\033[36m"
 
-/* ================= CRC POLYNOMIALS ================= */
-#define CRC16_POLY 0x1021u
-#define CRC64_POLY 0x42F0E1EBA9EA3693ULL
-
-/* ================= CRC TABLES ================= */
-static uint64_t crc64_table[256];
-static uint16_t crc16_table[256];
+/*
+    The codes are pasted into the format strings, so cprintf() and
+    cfprintf() take them out again on a stream without color: one that is
+    not a terminal, or any with --no-color or NO_COLOR set. Other escapes
+    (the progress bar's erase-line) go through untouched.
+*/
+static int color_out = 1, color_err = 1;
 
-/* ================= SIMD CRC32 ================= */
-static inline uint32_t crc32_simd(uint32_t crc, const uint8_t *buf, size_t len) {
-    while (len >= 8) {
-        crc = _mm_crc32_u64(crc, *(const uint64_t *)buf);
-        buf += 8;
-        len -= 8;
-    }
-    while (len--)
-        crc = _mm_crc32_u8(crc, *buf++);
-    return crc;
+static void color_setup(int no_color) {
+    const char *env = getenv("NO_COLOR");
+    int off = no_color || (env && *env);
+    color_out = !off && isatty(STDOUT_FILENO);
+    color_err = !off && isatty(STDERR_FILENO);
 }
 
-/* ================= CRC TABLE INITIALIZATION ================= */
-void init_crc64(void) {
-    for (int i = 0; i < 256; i++) {
-        uint64_t crc = (uint64_t)i << 56;
-        for (int j = 0; j < 8; j++)
-            crc = (crc & 0x8000000000000000ULL) ? (crc << 1) ^ CRC64_POLY : (crc << 1);
-        crc64_table[i] = crc;
+/* Drops the SGR sequences (ESC [ digits and ';' m) of n bytes at p in place, returns the new length */
+static size_t strip_colors(char *p, size_t n) {
+    size_t o = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] == '\033' && i + 1 < n && p[i + 1] == '[') {
+            size_t j = i + 2;
+            while (j < n && ((p[j] >= '0' && p[j] <= '9') || p[j] == ';')) j++;
+            if (j < n && p[j] == 'm') {
+                i = j;
+                continue;
+            }
+        }
+        p[o++] = p[i];
     }
+    return o;
 }
 
-void init_crc16(void) {
-    for (int i = 0; i < 256; i++) {
-        uint16_t crc = i << 8;
-        for (int j = 0; j < 8; j++)
-            crc = (uint16_t)(
-                (crc & 0x8000u)
-                ? ((crc << 1) ^ (uint16_t)CRC16_POLY)
-                : (crc << 1)
-            );
+__attribute__((format(printf, 2, 0)))
+static int vcfprintf(FILE *f, const char *fmt, va_list ap) {
+    char stack[1024], *buf = stack;
+    va_list aq;
+    int n;
 
-        crc16_table[i] = crc;
+    if (f == stdout ? color_out : f == stderr && color_err) return vfprintf(f, fmt, ap);
+    va_copy(aq, ap);
+    n = vsnprintf(stack, sizeof(stack), fmt, ap);
+    if (n >= (int)sizeof(stack)) {
+        if (!(buf = malloc((size_t)n + 1))) {
+            n = vfprintf(f, fmt, aq);
+            va_end(aq);
+            return n;
+        }
+        vsnprintf(buf, (size_t)n + 1, fmt, aq);
     }
+    va_end(aq);
+    if (n > 0) n = (int)fwrite(buf, 1, strip_colors(buf, (size_t)n), f);
+    if (buf != stack) free(buf);
+    return n;
 }
 
-/* ================= CPU FLAGS FUNCTION ================= */
-static int cpu_has_flag(const char *flag) {
-    FILE *f = fopen("/proc/cpuinfo", "r");
-    if (!f) return 0;
-
-    char line[4096];
-    int found = 0;
-
-    while (fgets(line, sizeof(line), f)) {
-        if (strncmp(line, "flags", 5) == 0) {
-            if (strstr(line, flag)) {
-                found = 1;
-                break;
-            }
-        }
-    }
+__attribute__((format(printf, 2, 3)))
+static int cfprintf(FILE *f, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vcfprintf(f, fmt, ap);
+    va_end(ap);
+    return n;
+}
 
-    fclose(f);
-    return found;
+__attribute__((format(printf, 1, 2)))
+static int cprintf(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vcfprintf(stdout, fmt, ap);
+    va_end(ap);
+    return n;
 }
 
 /* ================= CPU FAMILY FUNCTION ================= */
@@ -361,17 +614,17 @@ void show_debug() {
     
     printf("CRC Checker.\nCopyright (C) 2026 Ino Jacob. All rights reserved.\n\n");
     
-    printf(C_RESET "Software Information:\n");
-    printf(C_GREEN "Version   : " C_RESET "%s\n", VERSION);
-    printf(C_GREEN "Build Date: " C_RESET "%s\n", BUILD_DATE);
-    printf(C_GREEN "Compiler  : " C_RESET "%s\n", COMPILER_NAME);
-    printf(C_GREEN "Comp. Ver.: " C_RESET "%s\n", COMPILER_VERSION);
-    printf(C_GREEN "Flags     : " C_RESET "%s\n", COMPILER_FLAGS);
-    printf(C_GREEN "Target    : " C_RESET "%s\n", TARGET_TRIPLE);
-    printf(C_GREEN "LTO       : " C_RESET "%s\n", BUILD_LTO);
-    printf(C_GREEN "PGO       : " C_RESET "%s\n\n", BUILD_PGO);
-
-    printf(C_RESET "Basic Information:\n");
+    cprintf(C_RESET "Software Information:\n");
+    cprintf(C_GREEN "Version   : " C_RESET "%s\n", VERSION);
+    cprintf(C_GREEN "Build Date: " C_RESET "%s\n", BUILD_DATE);
+    cprintf(C_GREEN "Compiler  : " C_RESET "%s\n", COMPILER_NAME);
+    cprintf(C_GREEN "Comp. Ver.: " C_RESET "%s\n", COMPILER_VERSION);
+    cprintf(C_GREEN "Flags     : " C_RESET "%s\n", COMPILER_FLAGS);
+    cprintf(C_GREEN "Target    : " C_RESET "%s\n", TARGET_TRIPLE);
+    cprintf(C_GREEN "LTO       : " C_RESET "%s\n", BUILD_LTO);
+    cprintf(C_GREEN "PGO       : " C_RESET "%s\n\n", BUILD_PGO);
+
+    cprintf(C_RESET "Basic Information:\n");
 
     /* ================= USER / HOST ================= */
     char host[256] = "unknown";
@@ -379,7 +632,7 @@ void show_debug() {
     if (gethostname(host, sizeof(host)) != 0)
         strcpy(host, "unknown");
 
-    printf(C_GREEN "User      : " C_ORANGE "%s" C_RESET "@" C_YELLOW "%s\n", user ? user : "unknown", host);
+    cprintf(C_GREEN "User      : " C_ORANGE "%s" C_RESET "@" C_YELLOW "%s\n", user ? user : "unknown", host);
 
     /* ================= KERNEL ================= */
     char kernel[128] = "unknown";
@@ -390,7 +643,7 @@ void show_debug() {
         pclose(f);
     }
 
-    printf(C_GREEN "Kernel    : " C_RESET "%s\n", kernel);
+    cprintf(C_GREEN "Kernel    : " C_RESET "%s\n", kernel);
 
     /* ================= UPTIME ================= */
     double uptime_sec = 0.0;
@@ -405,17 +658,17 @@ void show_debug() {
     int hours = ((int)uptime_sec % 86400) / 3600;
     int minutes = ((int)uptime_sec % 3600) / 60;
 
-    printf(C_GREEN "Uptime    : " C_RESET "%.0f s "
-           C_GREEN "("
-           C_ORANGE "%d" C_RESET " days, "
-           C_ORANGE "%d" C_RESET " hours, "
-           C_ORANGE "%d" C_RESET " minutes"
-           C_GREEN ")\n",
-           uptime_sec, days, hours, minutes);
+    cprintf(C_GREEN "Uptime    : " C_RESET "%.0f s "
+            C_GREEN "("
+            C_ORANGE "%d" C_RESET " days, "
+            C_ORANGE "%d" C_RESET " hours, "
+            C_ORANGE "%d" C_RESET " minutes"
+            C_GREEN ")\n",
+            uptime_sec, days, hours, minutes);
 
     /* ================= SHELL / TERMINAL ================= */
-    printf(C_GREEN "Shell     : " C_RESET "%s\n", getenv("SHELL") ? getenv("SHELL") : "unknown");
-    printf(C_GREEN "Terminal  : " C_RESET "%s\n", getenv("TERM") ? getenv("TERM") : "unknown");
+    cprintf(C_GREEN "Shell     : " C_RESET "%s\n", getenv("SHELL") ? getenv("SHELL") : "unknown");
+    cprintf(C_GREEN "Terminal  : " C_RESET "%s\n", getenv("TERM") ? getenv("TERM") : "unknown");
 
     /* ================= CPU ================= */
     char cpu[256] = "unknown";
@@ -434,7 +687,7 @@ void show_debug() {
         }
         fclose(f);
     }
-    printf(C_GREEN "CPU       : " C_RESET "%s\n", cpu);
+    cprintf(C_GREEN "CPU       : " C_RESET "%s\n", cpu);
 
     /* ================= GPU ================= */
     char gpu[256] = "unknown";
@@ -449,7 +702,7 @@ void show_debug() {
         pclose(f);
     }
 
-printf(C_GREEN "GPU       : " C_RESET "%s\n", gpu);
+cprintf(C_GREEN "GPU       : " C_RESET "%s\n", gpu);
 
     /* ================= RAM ================= */
     long ram_kb = 0;
@@ -460,7 +713,7 @@ printf(C_GREEN "GPU       : " C_RESET "%s\n", gpu);
         }
         fclose(f);
     }
-    printf(C_GREEN "RAM       : " C_RESET "%.2f GB\n", ram_kb / 1024.0 / 1024.0);
+    cprintf(C_GREEN "RAM       : " C_RESET "%.2f GB\n", ram_kb / 1024.0 / 1024.0);
 
     printf("\nAdvanced Instructions:\n");
 
@@ -471,32 +724,36 @@ printf(C_GREEN "GPU       : " C_RESET "%s\n", gpu);
 
     const char *arch = detect_microarch(vendor, family, model);
 
-    printf(C_GREEN "CPU Family: " C_ORANGE "%s" C_RESET "\n", arch);
-
-    printf(C_GREEN "SSE4.2    : %s\n",
-        cpu_has_flag("sse4_2") ? C_PURPLE "yes" C_RESET : C_RED "no" C_RESET);
+    cprintf(C_GREEN "CPU Family: " C_ORANGE "%s" C_RESET "\n", arch);
 
-    printf(C_GREEN "AVX/AVX2  : %s/%s\n",
-        cpu_has_flag("avx")  ? C_PURPLE "yes" C_RESET : C_RED "no" C_RESET,
-        cpu_has_flag("avx2") ? C_PURPLE "yes" C_RESET : C_RED "no" C_RESET);
+    const struct cpu_features *caps = libcrc_cpu();
 
-    printf(C_GREEN "BMI/BMI2  : %s/%s\n",
-        cpu_has_flag("bmi1") ? C_PURPLE "yes" C_RESET : C_RED "no" C_RESET,
-        cpu_has_flag("bmi2") ? C_PURPLE "yes" C_RESET : C_RED "no" C_RESET);
-
-    printf(C_GREEN "FMA       : %s\n",
-        cpu_has_flag("fma") ? C_PURPLE "yes" C_RESET : C_RED "no" C_RESET);
-}
-
-/* ================= xxHash CONSTANTS ================= */
-#define XX_P1 11400714785074694791ULL
-#define XX_P2 14029467366897019727ULL
-#define XX_P3 1609587929392839161ULL
-#define XX_P4 9650029242287828579ULL
-#define XX_P5 2870177450012600261ULL
-
-static inline uint64_t rotl64(uint64_t x, int r) {
-    return (x << r) | (x >> (64 - r));
+#define YES_NO(x) ((x) ? C_PURPLE "yes" C_RESET : C_RED "no" C_RESET)
+#if defined(__aarch64__)
+    cprintf(C_GREEN "NEON      : %s\n", YES_NO(caps->neon));
+    cprintf(C_GREEN "CRC32     : %s\n", YES_NO(caps->arm_crc32));
+    cprintf(C_GREEN "PMULL     : %s\n", YES_NO(caps->pmull));
+#elif defined(__x86_64__) || defined(__i386__)
+    cprintf(C_GREEN "SSE4.2    : %s\n", YES_NO(caps->sse42));
+    cprintf(C_GREEN "PCLMUL    : %s\n", YES_NO(caps->pclmul));
+    cprintf(C_GREEN "AVX/AVX2  : %s/%s\n", YES_NO(caps->avx), YES_NO(caps->avx2));
+    cprintf(C_GREEN "AVX-512   : %s " C_GREEN "(BW %s" C_GREEN ", VL %s" C_GREEN ")\n",
+        YES_NO(caps->avx512f), YES_NO(caps->avx512bw), YES_NO(caps->avx512vl));
+    cprintf(C_GREEN "VPCLMULQDQ: %s\n", YES_NO(caps->vpclmulqdq));
+    cprintf(C_GREEN "BMI/BMI2  : %s/%s\n", YES_NO(caps->bmi1), YES_NO(caps->bmi2));
+    cprintf(C_GREEN "FMA       : %s\n", YES_NO(caps->fma));
+#else
+    (void)caps;
+#endif
+#undef YES_NO
+    cprintf(C_GREEN "Dispatch  : " C_ORANGE "%s" C_RESET "\n", isa_name(current_isa()));
+    cprintf(C_GREEN "Kernels   :" C_RESET);
+    for (int a = 0; a < ALGO_COUNT; a++) {
+        const struct hash_impl *big = current_impl((enum hash_algo)a, SIZE_MAX), *small = current_impl((enum hash_algo)a, 64);
+        cprintf("%s %s " C_ORANGE "%s" C_RESET, a ? "," : "", algo_name((enum hash_algo)a), big->name);
+        if (small != big) cprintf(C_RESET " (%s at 64 B)", small->name);
+    }
+    printf("\n");
 }
 
 /* ================= PATH UTILITIES ================= */
@@ -510,189 +767,4541 @@ void get_directory(char *p) {
 }
 
 /* ================= WALL-CLOCK TIMER ================= */
+/* CLOCK_MONOTONIC: wall time that NTP and date changes cannot move */
 static inline double now_seconds(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec + tv.tv_usec / 1e6;
-}
-
-/* ================= PROGRESS BAR ================= */
-#define PROGRESS_BAR_WIDTH 50
-void print_progress(size_t current, size_t total) {
-    double fraction = (double)current / total;
-    int filled = fraction * PROGRESS_BAR_WIDTH;
-    printf("\r[");
-    for (int i = 0; i < PROGRESS_BAR_WIDTH; i++)
-        putchar(i < filled ? '#' : '-');
-    printf("] %6.2f%%", fraction * 100);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ================= PROGRESS REPORTER ================= */
+/*
+    The hashing loops only add to an atomic byte counter (progress_add()).
+    A reporter thread at nice 19 samples it every PROGRESS_INTERVAL_MS and
+    draws the bar with throughput and ETA on stdout, or with --progress=json
+    writes one JSON object per sample to stderr. The default draws the bar
+    only when stdout is a terminal.
+*/
+#define PROGRESS_BAR_WIDTH   50
+#define PROGRESS_INTERVAL_MS 200
+
+enum progress_mode { PROGRESS_AUTO, PROGRESS_BAR, PROGRESS_JSON, PROGRESS_NONE };
+
+static struct {
+    enum progress_mode mode;
+    uint64_t done;                  /* bytes hashed, atomic */
+    uint64_t total;                 /* 0 when unknown */
+    double start;
+    int running, stop;
+    pthread_t tid;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} progress = { PROGRESS_AUTO, 0, 0, 0, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static inline void progress_add(uint64_t n) {
+    __atomic_fetch_add(&progress.done, n, __ATOMIC_RELAXED);
+}
+
+static void progress_draw(int final) {
+    uint64_t done = __atomic_load_n(&progress.done, __ATOMIC_RELAXED), total = progress.total;
+    double elapsed = now_seconds() - progress.start;
+    double rate = elapsed > 0 ? done / elapsed : 0;
+
+    if (total && done > total) done = total;
+    if (progress.mode == PROGRESS_JSON) {
+        fprintf(stderr, "{\"done\":%llu,\"total\":%llu,\"elapsed\":%.3f,\"bytes_per_sec\":%.0f,\"eta\":",
+                (unsigned long long)done, (unsigned long long)total, elapsed, rate);
+        if (total && rate > 0) fprintf(stderr, "%.1f", (total - done) / rate);
+        else fprintf(stderr, "null");
+        fprintf(stderr, ",\"final\":%s}\n", final ? "true" : "false");
+        fflush(stderr);
+        return;
+    }
+
+    char line[160];
+    int n = 0;
+    if (total) {
+        int filled = (int)((double)done / total * PROGRESS_BAR_WIDTH);
+        line[n++] = '[';
+        for (int i = 0; i < PROGRESS_BAR_WIDTH; i++) line[n++] = i < filled ? '#' : '-';
+        n += snprintf(line + n, sizeof(line) - n, "] %6.2f%%", 100.0 * done / total);
+    } else {
+        n += snprintf(line + n, sizeof(line) - n, "%.2f MB", done / (1024.0 * 1024.0));
+    }
+    n += snprintf(line + n, sizeof(line) - n, "  %.2f MB/s", rate / (1024.0 * 1024.0));
+    if (total && rate > 0) {
+        unsigned eta = (unsigned)((total - done) / rate + 0.5);
+        snprintf(line + n, sizeof(line) - n, "  ETA %u:%02u", eta / 60, eta % 60);
+    }
+    printf("\r%s\033[K", line);
     fflush(stdout);
 }
 
-/* ================= MAIN ================= */
-int main(int argc, char **argv) {
-    int fast_mode = 0, benchmark = 0;
-    int do_crc16 = 0, do_crc32 = 1, do_crc64 = 0;
-    int do_xxh64 = 0, do_xxh128 = 0;
-    const char *file = NULL;
+static void *progress_thread(void *arg) {
+    (void)arg;
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
 
-    /* ---------- Argument parsing ---------- */
-    for (int i = 1; i < argc; i++) {
-        if (!strcmp(argv[i], "-d") || !strcmp(argv[i], "--debug")) {
-            show_debug();
-            return EXIT_SUCCESS;
-        } else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--single")) fast_mode = 1;
-        else if (!strcmp(argv[i], "--benchmark") || !strcmp(argv[i], "-b")) benchmark = fast_mode = 1;
-        else if (!strcmp(argv[i], "--crc16") || !strcmp(argv[i], "-c16")) do_crc16 = 1, do_crc32 = 0;
-        else if (!strcmp(argv[i], "--crc64") || !strcmp(argv[i], "-c64")) do_crc64 = 1, do_crc32 = 0;
-        else if (!strcmp(argv[i], "--x64") || !strcmp(argv[i], "-h")) do_xxh64 = 1, do_crc32 = 0;
-        else if (!strcmp(argv[i], "--x128") || !strcmp(argv[i], "-H")) do_xxh128 = 1, do_crc32 = 0;
-        else if (!strcmp(argv[i], "-a") || !strcmp(argv[i], "--all"))
-            do_crc16 = do_crc32 = do_crc64 = do_xxh64 = do_xxh128 = 1;
-        else file = argv[i];
+    pthread_mutex_lock(&progress.lock);
+    while (!progress.stop) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += PROGRESS_INTERVAL_MS * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+        pthread_cond_timedwait(&progress.wake, &progress.lock, &ts);
+        if (!progress.stop) progress_draw(0);
     }
+    pthread_mutex_unlock(&progress.lock);
+    return NULL;
+}
 
-    if (!file) {
-        fprintf(stderr,
-                "CRC Checker v%s\nUsage: crc [OPTIONS] <file>\n\n"
-                "Options:\n"
-                "  --crc16, -c16     Perform an CRC-16 checksum\n"
-                "  --crc64, -c64     Perform an CRC-64 checksum\n"
-                "  --x64, -h         Perform an xxHash64 checksum\n"
-                "  --x128, -H        Perform an xxHash128 checksum\n"
-                "  --all, -a         Perform all checksum (slow)\n"
-                "  --single, -s      Single pass checksum calculation (Fast mode)\n"
-                "  --benchmark, -b   Benchmark all checksum\n\n"
-                "NOTE: " C_GREEN "By default, the " C_ORANGE "CRC32" C_GREEN " checksum is performed unless otherwise specified.\n" C_RESET, VERSION);
-        return EXIT_FAILURE;
+/* Starts reporting on total bytes (0: unknown), unless the mode says no */
+static void progress_start(uint64_t total) {
+    if (progress.mode == PROGRESS_AUTO) progress.mode = isatty(STDOUT_FILENO) ? PROGRESS_BAR : PROGRESS_NONE;
+    progress.done = 0;
+    progress.total = total;
+    progress.start = now_seconds();
+    progress.stop = 0;
+    if (progress.mode != PROGRESS_NONE)
+        progress.running = pthread_create(&progress.tid, NULL, progress_thread, NULL) == 0;
+}
+
+/* Stops the reporter: the bar is erased, JSON gets a final sample */
+static void progress_stop(void) {
+    if (!progress.running) return;
+    pthread_mutex_lock(&progress.lock);
+    progress.stop = 1;
+    pthread_cond_signal(&progress.wake);
+    pthread_mutex_unlock(&progress.lock);
+    pthread_join(progress.tid, NULL);
+    progress.running = 0;
+
+    if (progress.mode == PROGRESS_JSON) progress_draw(1);
+    else {
+        printf("\r\033[K");
+        fflush(stdout);
     }
+}
 
-    char full[PATH_MAX];
-    if (!realpath(file, full)) { perror("realpath"); return EXIT_FAILURE; }
+/* ================= RUN STATISTICS ================= */
+/*
+    --stats writes one JSON object when crc exits, to stderr or to the
+    file of --stats=FILE, for scrapers such as a Prometheus exporter: wall
+    time, time per stage, bytes per hash and kernel, and the getrusage()
+    counters. Stage times are summed over the threads that ran them, so
+    with several workers they can add up to more than the wall time:
 
-    int fd = open(full, O_RDONLY);
-    if (fd < 0) { perror("open"); return EXIT_FAILURE; }
+        open     realpath / open / fstat, and the walk of -r directories
+        read     read() / pread() of streams, small files and GPU batches
+        map      mmap, madvise and munmap of the windows
+        fault    mmap of a --populate window, which faults it in up front
+        hash     the kernels, with the demand faults of their first touch
+        combine  crcN_combine() / crcN_shift() of threads, pieces and GPU work-items
+        output   printing the digests
 
-    struct stat st;
-    fstat(fd, &st);
-    size_t filesize = st.st_size;
-    if (!filesize) { fprintf(stderr, "Empty file\n"); return EXIT_FAILURE; }
+    Without --populate the page faults are taken inside hash; their counts
+    are rusage.minor_faults and major_faults either way. When --stats is
+    off every hook is one branch on stats.on, when it is on one
+    clock_gettime() per SP_BLOCK call.
 
-    uint8_t *data = mmap(NULL, filesize, PROT_READ, MAP_PRIVATE, fd, 0);
-    close(fd);
-    if (data == MAP_FAILED) { perror("mmap"); return EXIT_FAILURE; }
+    --perf adds perf_event_open() counters (cycles, instructions, LLC
+    misses) for the whole process, inherited by the threads it creates
+    (their counts arrive when they exit). With -b the stage hooks stay off
+    and every row of the table gets its own counts instead. Where
+    perf_event_paranoid forbids kernel counting they are user space only
+    ("user_only"); without a PMU, as in most VMs, "perf" is null.
+*/
+#define PERF_EVENTS 3
 
-    init_crc64();
-    init_crc16();
+enum stat_stage { STAGE_OPEN, STAGE_READ, STAGE_MAP, STAGE_FAULT, STAGE_HASH, STAGE_COMBINE, STAGE_OUTPUT, STAGE_COUNT };
 
-    char dir[PATH_MAX];
-    strcpy(dir, full);
-    get_directory(dir);
+static const char *const stage_names[STAGE_COUNT] = { "open", "read", "map", "fault", "hash", "combine", "output" };
 
-    printf("File  : %s\nPath  : %s\nSize  : " C_ORANGE "%.2f " C_RESET "%s\n\n",
-           get_filename(full),
-           dir,
-           filesize < (1024*1024) ? filesize / 1024.0 : filesize / (1024.0*1024.0),
-           filesize < (1024*1024) ? "KB" : "MB");
+static const struct {
+    const char *name;
+    uint64_t config;
+} perf_events[PERF_EVENTS] = {
+    { "cycles",       PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_COUNT_HW_INSTRUCTIONS },
+    { "llc_misses",   PERF_COUNT_HW_CACHE_MISSES },
+};
 
-    /* ================= BENCHMARK MODE ================= */
-    if (benchmark) {
+#define STAT_BIG   0   /* bytes[][] by kernel: the main one */
+#define STAT_SMALL 1   /* the small-input one, when it differs */
+#define STAT_GPU   2   /* the OpenCL device */
+#define STAT_MODEL (1u << ALGO_COUNT)   /* stats_holes() mask bit of the --crc model */
 
-        double total_start = (double)clock() / CLOCKS_PER_SEC;
-        double mb = filesize / (1024.0 * 1024.0);
-        clock_t t;
-        double dt;
-
-        /* ---------- CRC-16 Benchmark (branch-free) ---------- */
-        t = clock();
-        uint16_t crc16 = 0xFFFF;
-        for (size_t i = 0; i < filesize; i++)
-            crc16 = crc16_table[(crc16 >> 8) ^ data[i]] ^ (crc16 << 8);
-        dt = (double)(clock() - t) / CLOCKS_PER_SEC;
-        printf(C_RESET "CRC-16: %04X " C_GREEN "@ " C_ORANGE "%.2f" C_RESET " MB/s " C_GREEN "(" C_YELLOW "%.6f" C_RESET " s" C_GREEN ")\n", crc16, mb / dt, dt);
-
-        /* ---------- CRC-32 Benchmark ---------- */
-        t = clock();
-        uint32_t crc32 = 0xFFFFFFFF;
-        crc32 = crc32_simd(crc32, data, filesize);
-        crc32 ^= 0xFFFFFFFF;
-        dt = (double)(clock() - t) / CLOCKS_PER_SEC;
-        printf(C_RESET "CRC-32: %08X " C_GREEN "@ " C_ORANGE "%.2f" C_RESET " MB/s " C_GREEN "(" C_YELLOW "%.6f" C_RESET " s" C_GREEN ")\n", crc32, mb / dt, dt);
-
-        /* ---------- CRC-64 Benchmark ---------- */
-        t = clock();
-        uint64_t crc64 = 0;
-        for (size_t i = 0; i < filesize; i++)
-            crc64 = (crc64 << 8) ^ crc64_table[(crc64 >> 56) ^ data[i]];
-        dt = (double)(clock() - t) / CLOCKS_PER_SEC;
-        printf(C_RESET "CRC-64: %016llX " C_GREEN "@ " C_ORANGE "%.2f" C_RESET " MB/s " C_GREEN "(" C_YELLOW "%.6f" C_RESET " s" C_GREEN ")\n", (unsigned long long)crc64, mb / dt, dt);
-
-        /* ---------- xxHash64 Benchmark ---------- */
-        t = clock();
-        uint64_t xxh64 = XX_P5;
-        for (size_t i = 0; i < filesize; i++)
-            xxh64 = rotl64(xxh64 ^ (data[i] * XX_P5), 11) * XX_P1;
-        xxh64 ^= filesize;
-        xxh64 ^= xxh64 >> 33; xxh64 *= XX_P2;
-        xxh64 ^= xxh64 >> 29; xxh64 *= XX_P3;
-        xxh64 ^= xxh64 >> 32;
-        dt = (double)(clock() - t) / CLOCKS_PER_SEC;
-        printf(C_RESET "xxH64 : %016llX " C_GREEN "@ " C_ORANGE "%.2f" C_RESET " MB/s " C_GREEN "(" C_YELLOW "%.6f" C_RESET " s" C_GREEN ")\n", (unsigned long long)xxh64, mb / dt, dt);
-
-        /* ---------- xxHash128 Benchmark ---------- */
-        t = clock();
-        uint64_t hi = rotl64(xxh64 * XX_P1, 31) ^ XX_P4;
-        uint64_t lo = xxh64;
-        dt = (double)(clock() - t) / CLOCKS_PER_SEC;
-        printf(C_RESET "xxH128: %016llX%016llX " C_GREEN "@ " C_ORANGE "%.2f" C_RESET " MB/s " C_GREEN "(" C_YELLOW "%.6f" C_RESET " s" C_GREEN ")\n", (unsigned long long)hi, (unsigned long long)lo, mb / dt, dt);
-
-        printf(C_RESET "\nTime  : %.6f s\n", ((double)clock() / CLOCKS_PER_SEC) - total_start);
-
-        munmap(data, filesize);
-        return EXIT_SUCCESS;
+/* One row of the benchmark table */
+struct stat_row {
+    char hash[16], kernel[16];
+    uint64_t size;
+    double mbps, tsc_per_byte;
+    int has_perf;
+    double perf[PERF_EVENTS];       /* per byte */
+};
+
+static struct {
+    int report;                     /* --stats: JSON at exit */
+    int on;                         /* the stage and byte hooks count */
+    int perf;                       /* --perf, cleared when the counters cannot be opened */
+    const char *path;               /* --stats=FILE, NULL for stderr */
+    double start;
+    uint64_t ns[STAGE_COUNT];       /* atomic */
+    uint64_t bytes[ALGO_COUNT][3];  /* atomic, by STAT_* kernel */
+    uint64_t holes[ALGO_COUNT + 1]; /* atomic, hole bytes stepped over, the model last */
+    const struct crc_model *model;  /* --crc NAME */
+    uint64_t model_bytes;
+    int perf_fd[PERF_EVENTS], perf_user_only, perf_err;
+    double perf_mark[PERF_EVENTS], perf_pending[PERF_EVENTS];
+    int pending;
+    struct stat_row *rows;
+    size_t nrows, cap;
+} stats;
+
+static inline uint64_t stats_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Start of a timed stage, 0 when the hooks are off */
+static inline uint64_t stats_clock(void) {
+    return stats.on ? stats_ns() : 0;
+}
+
+static inline void stats_stage(enum stat_stage s, uint64_t t0) {
+    if (stats.on) __atomic_fetch_add(&stats.ns[s], stats_ns() - t0, __ATOMIC_RELAXED);
+}
+
+/* n bytes through the CPU kernels of mask since t0, in calls of up to call bytes */
+static inline void stats_hashed(unsigned mask, uint64_t n, size_t call, uint64_t t0) {
+    if (!stats.on) return;
+    stats_stage(STAGE_HASH, t0);
+    for (int a = 0; a < ALGO_COUNT; a++)
+        if (mask & (1u << a)) {
+            int k = current_impl((enum hash_algo)a, call) == current_impl((enum hash_algo)a, SIZE_MAX) ? STAT_BIG : STAT_SMALL;
+            __atomic_fetch_add(&stats.bytes[a][k], n, __ATOMIC_RELAXED);
+        }
+}
+
+/* n hole bytes stepped over for mask, STAT_MODEL for the --crc model */
+static inline void stats_holes(unsigned mask, uint64_t n) {
+    if (!stats.on) return;
+    for (int a = 0; a <= ALGO_COUNT; a++)
+        if (mask & (1u << a)) __atomic_fetch_add(&stats.holes[a], n, __ATOMIC_RELAXED);
+}
+
+/* n bytes of the crcs on the GPU */
+static void stats_device(unsigned crcs, uint64_t n) {
+    if (!stats.on) return;
+    for (int a = 0; a < ALGO_COUNT; a++)
+        if (crcs & (1u << a)) __atomic_fetch_add(&stats.bytes[a][STAT_GPU], n, __ATOMIC_RELAXED);
+}
+
+/* ---------- perf_event_open counters ---------- */
+static int perf_open(uint64_t config, int user_only) {
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    a.type = PERF_TYPE_HARDWARE;
+    a.config = config;
+    a.inherit = 1;
+    a.exclude_kernel = user_only;
+    a.exclude_hv = 1;
+    a.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+}
+
+static void stats_perf_start(void) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if ((stats.perf_fd[e] = perf_open(perf_events[e].config, stats.perf_user_only)) < 0 &&
+            !stats.perf_user_only && (errno == EACCES || errno == EPERM)) {
+            /* perf_event_paranoid >= 2: user space only, the same for all of them */
+            stats.perf_user_only = 1;
+            for (int i = 0; i < e; i++) close(stats.perf_fd[i]);
+            e = -1;
+            continue;
+        }
+        if (stats.perf_fd[e] < 0) {
+            stats.perf_err = errno;
+            for (int i = 0; i < e; i++) close(stats.perf_fd[i]);
+            stats.perf = 0;
+            return;
+        }
     }
+}
 
-    /* ================= SINGLE-PASS / PROGRESS ================= */
-    double t_start = now_seconds();
-    uint16_t crc16 = 0xFFFF;
-    uint32_t crc32 = 0xFFFFFFFF;
-    uint64_t crc64 = 0;
-    uint64_t xxh64 = XX_P5;
+/* Counts so far, scaled up when the PMU was shared out (multiplexed) */
+static void stats_perf_read(double *v) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        uint64_t r[3] = { 0, 0, 0 };   /* value, time enabled, time running */
+        v[e] = 0;
+        if (read(stats.perf_fd[e], r, sizeof(r)) == (ssize_t)sizeof(r) && r[2])
+            v[e] = (double)r[0] * ((double)r[1] / (double)r[2]);
+    }
+}
+
+/* Around the timed repetitions of one benchmark row */
+static void stats_perf_begin(void) {
+    stats.pending = 0;
+    if (stats.perf) stats_perf_read(stats.perf_mark);
+}
 
-    size_t progress_interval = filesize / 100;
-    if (progress_interval == 0) progress_interval = 1;
+static void stats_perf_end(double bytes) {
+    double v[PERF_EVENTS];
+    if (!stats.perf || bytes <= 0) return;
+    stats_perf_read(v);
+    for (int e = 0; e < PERF_EVENTS; e++) stats.perf_pending[e] = (v[e] - stats.perf_mark[e]) / bytes;
+    stats.pending = 1;
+}
 
-    for (size_t i = 0; i < filesize; i++) {
-        uint8_t b = data[i];
-        if (do_crc16) crc16 = crc16_table[(crc16 >> 8) ^ b] ^ (crc16 << 8);
-        if (do_crc32) crc32 = _mm_crc32_u8(crc32, b);
-        if (do_crc64) crc64 = (crc64 << 8) ^ crc64_table[(crc64 >> 56) ^ b];
-        if (do_xxh64) xxh64 = rotl64(xxh64 ^ (b * XX_P5), 11) * XX_P1;
-        if ((i % progress_interval) == 0 || i == filesize - 1) print_progress(i + 1, filesize);
+static void stats_bench_row(const char *hash, const char *kernel, uint64_t size, double mbps, double tsc_per_byte) {
+    struct stat_row *r;
+    if (!stats.report) return;
+    if (stats.nrows == stats.cap) {
+        size_t cap = stats.cap ? 2 * stats.cap : 64;
+        struct stat_row *p = realloc(stats.rows, cap * sizeof(*p));
+        if (!p) return;
+        stats.rows = p;
+        stats.cap = cap;
     }
+    r = &stats.rows[stats.nrows++];
+    snprintf(r->hash, sizeof(r->hash), "%s", hash);
+    snprintf(r->kernel, sizeof(r->kernel), "%s", kernel);
+    r->size = size;
+    r->mbps = mbps;
+    r->tsc_per_byte = tsc_per_byte;
+    r->has_perf = stats.pending;
+    memcpy(r->perf, stats.perf_pending, sizeof(r->perf));
+    stats.pending = 0;
+}
+
+/* ---------- report ---------- */
+static void stats_kernel(FILE *out, int *first, const char *hash, const char *kernel, uint64_t bytes) {
+    if (!bytes) return;
+    fprintf(out, "%s{\"hash\":\"%s\",\"kernel\":\"%s\",\"bytes\":%llu}", *first ? "" : ",", hash, kernel,
+            (unsigned long long)bytes);
+    *first = 0;
+}
+
+static void stats_report(void) {
+    FILE *out = stats.path ? fopen(stats.path, "w") : stderr;
+    struct rusage ru;
+    int first = 1;
 
-    crc32 ^= 0xFFFFFFFF;
-    if (do_xxh64 || do_xxh128) {
-        xxh64 ^= filesize;
-        xxh64 ^= xxh64 >> 33; xxh64 *= XX_P2;
-        xxh64 ^= xxh64 >> 29; xxh64 *= XX_P3;
-        xxh64 ^= xxh64 >> 32;
+    if (!out) {
+        cfprintf(stderr, C_RED "crc: %s: %s\n" C_RESET, stats.path, strerror(errno));
+        return;
     }
+    getrusage(RUSAGE_SELF, &ru);
 
-    double t_end = now_seconds();
+    fprintf(out, "{\"version\":\"%s\",\"wall_s\":%.6f,\"stages_s\":{", VERSION, now_seconds() - stats.start);
+    for (int s = 0; s < STAGE_COUNT; s++)
+        fprintf(out, "%s\"%s\":%.6f", s ? "," : "", stage_names[s], stats.ns[s] / 1e9);
+    fprintf(out, "},\"kernels\":[");
+    for (int a = 0; a < ALGO_COUNT; a++) {
+        const struct hash_impl *big = current_impl((enum hash_algo)a, SIZE_MAX), *small = current_impl((enum hash_algo)a, 64);
+        stats_kernel(out, &first, algo_name((enum hash_algo)a), big->name, stats.bytes[a][STAT_BIG]);
+        stats_kernel(out, &first, algo_name((enum hash_algo)a), small->name, stats.bytes[a][STAT_SMALL]);
+        stats_kernel(out, &first, algo_name((enum hash_algo)a), "gpu", stats.bytes[a][STAT_GPU]);
+    }
+    if (stats.model) stats_kernel(out, &first, stats.model->name, isa_name(current_isa()), stats.model_bytes);
+    fprintf(out, "],\"hole_bytes\":{");
+    first = 1;
+    for (int a = 0; a <= ALGO_COUNT; a++)
+        if (stats.holes[a]) {
+            fprintf(out, "%s\"%s\":%llu", first ? "" : ",",
+                    a < ALGO_COUNT ? algo_name((enum hash_algo)a) : stats.model->name, (unsigned long long)stats.holes[a]);
+            first = 0;
+        }
+    fprintf(out, "}");
 
-    printf("\r");
-    for (int i = 0; i < PROGRESS_BAR_WIDTH + 12; i++) putchar(' ');
-    printf("\r");
+    fprintf(out, ",\"rusage\":{\"user_s\":%.6f,\"sys_s\":%.6f,\"max_rss_kb\":%ld,\"minor_faults\":%ld,"
+                 "\"major_faults\":%ld,\"in_blocks\":%ld,\"out_blocks\":%ld,\"voluntary_switches\":%ld,"
+                 "\"involuntary_switches\":%ld}",
+            ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6, ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6,
+            ru.ru_maxrss, ru.ru_minflt, ru.ru_majflt, ru.ru_inblock, ru.ru_oublock, ru.ru_nvcsw, ru.ru_nivcsw);
 
-    if (do_crc16) printf("CRC-16: %04X\n", crc16);
-    if (do_crc32) printf("CRC-32: %08X\n", crc32);
-    if (do_crc64) printf("CRC-64: %016llX\n", (unsigned long long)crc64);
-    if (do_xxh64) printf("xxH64 : %016llX\n", (unsigned long long)xxh64);
-    if (do_xxh128)
-        printf("xxH128: %016llX%016llX\n", (unsigned long long)(rotl64(xxh64 * XX_P1, 31) ^ XX_P4), (unsigned long long)xxh64);
+    if (stats.perf) {
+        double v[PERF_EVENTS];
+        stats_perf_read(v);
+        fprintf(out, ",\"perf\":{");
+        for (int e = 0; e < PERF_EVENTS; e++) fprintf(out, "\"%s\":%.0f,", perf_events[e].name, v[e]);
+        fprintf(out, "\"ipc\":%.3f,\"user_only\":%s}", v[0] > 0 ? v[1] / v[0] : 0.0,
+                stats.perf_user_only ? "true" : "false");
+    } else if (stats.perf_err) {
+        fprintf(out, ",\"perf\":null,\"perf_error\":\"%s\"", strerror(stats.perf_err));
+    }
 
-    printf("\nTime  : %.6f s\n", t_end - t_start);
+    if (stats.nrows) {
+        fprintf(out, ",\"bench\":[");
+        for (size_t i = 0; i < stats.nrows; i++) {
+            const struct stat_row *r = &stats.rows[i];
+            fprintf(out, "%s{\"hash\":\"%s\",\"kernel\":\"%s\",\"size\":%llu,\"mb_s\":%.2f,\"tsc_per_byte\":%.4f",
+                    i ? "," : "", r->hash, r->kernel, (unsigned long long)r->size, r->mbps, r->tsc_per_byte);
+            if (r->has_perf)
+                fprintf(out, ",\"cycles_per_byte\":%.4f,\"instructions_per_byte\":%.4f,\"ipc\":%.3f,"
+                             "\"llc_misses_per_mb\":%.2f",
+                        r->perf[0], r->perf[1], r->perf[0] > 0 ? r->perf[1] / r->perf[0] : 0.0,
+                        r->perf[2] * 1024 * 1024);
+            fprintf(out, "}");
+        }
+        fprintf(out, "]");
+    }
+    fprintf(out, "}\n");
+    if (stats.path) fclose(out);
+    else fflush(out);
+}
+
+/* --stats / --perf given: counters from here on, the report at exit */
+static void stats_start(int hooks) {
+    stats.start = now_seconds();
+    stats.on = hooks;
+    if (stats.perf) stats_perf_start();
+    atexit(stats_report);
+}
+
+/* ================= NUMA TOPOLOGY ================= */
+/*
+    Nodes and their CPUs come from sysfs and the node of a page from
+    move_pages(2) in query mode, so there is no libnuma dependency. On a
+    single-node machine numa_nodes() is 1 and nothing gets pinned.
+*/
+#define NUMA_MAX_NODES 64
+
+static struct {
+    int nodes;                              /* highest node id + 1 */
+    int present[NUMA_MAX_NODES];
+    cpu_set_t cpus[NUMA_MAX_NODES];         /* empty for memory-only nodes */
+} numa;
+
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+
+/* "0-3,8-11" into a cpu set */
+static void parse_cpulist(const char *s, cpu_set_t *set) {
+    CPU_ZERO(set);
+    while (*s) {
+        char *end;
+        long lo = strtol(s, &end, 10), hi = lo;
+        if (end == s) break;
+        if (*end == '-') hi = strtol(end + 1, &end, 10);
+        for (long c = lo; c <= hi && c < CPU_SETSIZE; c++) CPU_SET((int)c, set);
+        s = *end == ',' ? end + 1 : end;
+        if (*s == '\n') break;
+    }
+}
+
+static void numa_detect(void) {
+    char path[64], list[4096];
+    for (int n = 0; n < NUMA_MAX_NODES; n++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        if (fgets(list, sizeof(list), f)) parse_cpulist(list, &numa.cpus[n]);
+        fclose(f);
+        numa.present[n] = 1;
+        numa.nodes = n + 1;
+    }
+    if (!numa.nodes) {                      /* no sysfs: one node with every CPU */
+        numa.present[0] = 1;
+        numa.nodes = 1;
+        sched_getaffinity(0, sizeof(numa.cpus[0]), &numa.cpus[0]);
+    }
+}
+
+static int numa_nodes(void) {
+    pthread_once(&numa_once, numa_detect);
+    return numa.nodes;
+}
+
+/* A node threads can be bound to */
+static int numa_has_cpus(int node) {
+    return node >= 0 && node < numa_nodes() && numa.present[node] && CPU_COUNT(&numa.cpus[node]) > 0;
+}
+
+/* Node holding the page at addr (faulted in by reading it), or -1 */
+static int numa_page_node(const void *addr) {
+    void *page = (void *)((uintptr_t)addr & ~((uintptr_t)sysconf(_SC_PAGESIZE) - 1));
+    int status = -1;
+    (void)*(const volatile uint8_t *)addr;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, NULL, &status, 0) < 0) return -1;
+    return status;
+}
+
+/* Restricts attr (or, when attr is NULL, the calling thread) to the CPUs of node */
+static void numa_bind(pthread_attr_t *attr, int node) {
+    if (!numa_has_cpus(node)) return;
+    if (attr) pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &numa.cpus[node]);
+    else pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &numa.cpus[node]);
+}
+
+/* ================= MULTITHREADED CRC32 ================= */
+#define MT_MIN_CHUNK   (1024 * 1024)   /* never split below 1 MB per thread */
+#define MT_MAX_THREADS 256
+
+struct crc32_job {
+    const uint8_t *buf;
+    size_t len;
+    uint32_t crc;
+    int spawned;
+    pthread_t tid;
+};
+
+#define MT_PROGRESS_STEP (4 * 1024 * 1024)
+
+static void *crc32_worker(void *arg) {
+    struct crc32_job *job = arg;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t off = 0; off < job->len; off += MT_PROGRESS_STEP) {
+        size_t n = job->len - off < MT_PROGRESS_STEP ? job->len - off : MT_PROGRESS_STEP;
+        uint64_t t0 = stats_clock();
+        crc = crc32_hash(crc, job->buf + off, n);
+        stats_hashed(HASH_CRC32, n, n, t0);
+        progress_add(n);
+    }
+    job->crc = crc ^ 0xFFFFFFFF;
+    return NULL;
+}
+
+int online_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) return 1;
+    return n > MT_MAX_THREADS ? MT_MAX_THREADS : (int)n;
+}
+
+/*
+    Range 0 is hashed by the calling thread, the other ranges each get their
+    own thread. On NUMA machines each thread starts on the node that holds
+    the middle of its range, so it reads local memory.
+*/
+uint32_t crc32_parallel(const uint8_t *data, size_t len, int threads) {
+    struct crc32_job jobs[MT_MAX_THREADS];
+
+    if ((size_t)threads > len / MT_MIN_CHUNK) threads = (int)(len / MT_MIN_CHUNK);
+    if (threads > MT_MAX_THREADS) threads = MT_MAX_THREADS;
+    if (threads < 1) threads = 1;
+
+    size_t chunk = len / threads;
+    for (int t = 0; t < threads; t++) {
+        jobs[t].buf = data + (size_t)t * chunk;
+        jobs[t].len = (t == threads - 1) ? len - (size_t)t * chunk : chunk;
+        jobs[t].spawned = 0;
+    }
+
+    for (int t = 1; t < threads; t++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (numa_nodes() > 1) numa_bind(&attr, numa_page_node(jobs[t].buf + jobs[t].len / 2));
+        jobs[t].spawned = pthread_create(&jobs[t].tid, &attr, crc32_worker, &jobs[t]) == 0;
+        pthread_attr_destroy(&attr);
+    }
+
+    crc32_worker(&jobs[0]);
+    uint32_t crc = jobs[0].crc;
+
+    for (int t = 1; t < threads; t++) {
+        if (jobs[t].spawned) pthread_join(jobs[t].tid, NULL);
+        else crc32_worker(&jobs[t]);   /* pthread_create failed, do it here */
+        uint64_t t0 = stats_clock();
+        crc = crc32_combine(crc, jobs[t].crc, jobs[t].len);
+        stats_stage(STAGE_COMBINE, t0);
+    }
+
+    return crc;
+}
+
+/* ================= STREAMING INPUT ================= */
+/*
+    For stdin, pipes, FIFOs, character / block devices and anything that
+    cannot be mapped. A reader thread fills STREAM_BUFS aligned buffers in
+    turn while the calling thread runs the single-pass kernel over the
+    previous one, so memory stays at STREAM_BUFS * STREAM_BUF_SIZE no matter
+    how long the input is. The hash state is the same one the mmap path uses.
+*/
+#define STREAM_BUFS     3
+#define STREAM_BUF_SIZE (1024 * 1024)
+#define STREAM_ALIGN    4096
+
+struct stream_ring {
+    int fd;
+    uint8_t *buf[STREAM_BUFS];
+    size_t len[STREAM_BUFS];
+    unsigned filled;            /* buffers ready for the hasher */
+    int eof, error;
+    pthread_mutex_t lock;
+    pthread_cond_t ready, drained;
+};
+
+/* Fills one buffer completely unless the input ends first */
+static ssize_t stream_fill(int fd, uint8_t *buf, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        uint64_t t0 = stats_clock();
+        ssize_t n = read(fd, buf + got, size - got);
+        stats_stage(STAGE_READ, t0);
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    return (ssize_t)got;
+}
+
+static void *stream_reader(void *arg) {
+    struct stream_ring *r = arg;
+
+    for (unsigned slot = 0;; slot = (slot + 1) % STREAM_BUFS) {
+        pthread_mutex_lock(&r->lock);
+        while (r->filled == STREAM_BUFS)
+            pthread_cond_wait(&r->drained, &r->lock);
+        pthread_mutex_unlock(&r->lock);
+
+        ssize_t n = stream_fill(r->fd, r->buf[slot], STREAM_BUF_SIZE);
+
+        pthread_mutex_lock(&r->lock);
+        if (n < 0) r->error = errno;
+        else if (n > 0) {
+            r->len[slot] = (size_t)n;
+            r->filled++;
+        }
+        if (n < STREAM_BUF_SIZE) r->eof = 1;
+        pthread_cond_signal(&r->ready);
+        pthread_mutex_unlock(&r->lock);
+
+        if (n < STREAM_BUF_SIZE) return NULL;
+    }
+}
+
+/* Best guess at the input size for the progress bar, 0 when unknown */
+static uint64_t stream_size_hint(int fd, const struct stat *st) {
+    if (S_ISREG(st->st_mode)) return (uint64_t)st->st_size;
+#ifdef BLKGETSIZE64
+    uint64_t bytes;
+    if (S_ISBLK(st->st_mode) && ioctl(fd, BLKGETSIZE64, &bytes) == 0) return bytes;
+#else
+    (void)fd;
+#endif
+    return 0;
+}
+
+/*
+    Runs the hashes of h over the whole stream. Returns 0 on success, or the errno of
+    the failed read. *total receives the number of bytes hashed.
+*/
+int hash_stream(int fd, struct hash_state *h, uint64_t *total) {
+    struct stream_ring r;
+    memset(&r, 0, sizeof(r));
+    r.fd = fd;
+    *total = 0;
+
+    for (int i = 0; i < STREAM_BUFS; i++)
+        if (posix_memalign((void **)&r.buf[i], STREAM_ALIGN, STREAM_BUF_SIZE)) {
+            while (i--) free(r.buf[i]);
+            return ENOMEM;
+        }
+
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.ready, NULL);
+    pthread_cond_init(&r.drained, NULL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    pthread_t tid;
+    int threaded = pthread_create(&tid, NULL, stream_reader, &r) == 0;
+
+    for (unsigned slot = 0;; slot = (slot + 1) % STREAM_BUFS) {
+        size_t n;
+        if (threaded) {
+            pthread_mutex_lock(&r.lock);
+            while (!r.filled && !r.eof && !r.error)
+                pthread_cond_wait(&r.ready, &r.lock);
+            if (!r.filled) {
+                pthread_mutex_unlock(&r.lock);
+                break;
+            }
+            n = r.len[slot];
+            pthread_mutex_unlock(&r.lock);
+        } else {
+            ssize_t got = stream_fill(fd, r.buf[slot], STREAM_BUF_SIZE);   /* no thread, read inline */
+            if (got < 0) { r.error = errno; break; }
+            if (got == 0) break;
+            n = (size_t)got;
+        }
+
+        uint64_t t0 = stats_clock();
+        for (size_t off = 0; off < n; off += SP_BLOCK)
+            hash_update(h, r.buf[slot] + off, n - off < SP_BLOCK ? n - off : SP_BLOCK);
+        stats_hashed(h->mask, n, n < SP_BLOCK ? n : SP_BLOCK, t0);
+        *total += n;
+        progress_add(n);
+
+        if (threaded) {
+            pthread_mutex_lock(&r.lock);
+            r.filled--;
+            pthread_cond_signal(&r.drained);
+            pthread_mutex_unlock(&r.lock);
+        } else if (n < STREAM_BUF_SIZE) {
+            break;
+        }
+    }
+
+    if (threaded) pthread_join(tid, NULL);
+    pthread_cond_destroy(&r.drained);
+    pthread_cond_destroy(&r.ready);
+    pthread_mutex_destroy(&r.lock);
+    for (int i = 0; i < STREAM_BUFS; i++) free(r.buf[i]);
+    return r.error;
+}
+
+/* Reads len bytes at off, fewer only at end of file. Returns the count or -1 */
+static ssize_t pread_full(int fd, uint8_t *buf, size_t len, off_t off) {
+    size_t got = 0;
+    while (got < len) {
+        uint64_t t0 = stats_clock();
+        ssize_t n = pread(fd, buf + got, len - got, off + (off_t)got);
+        stats_stage(STAGE_READ, t0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        got += (size_t)n;
+    }
+    return (ssize_t)got;
+}
+
+/* ================= IO_URING INPUT ================= */
+/*
+    Optional backend for cold-cache files and block devices (--io=uring).
+    The file is opened with O_DIRECT so the page cache is left alone, and a
+    ring of queue-depth registered buffers keeps that many READ_FIXED
+    requests in flight. Completions may arrive in any order, but the hashes
+    are sequential, so buffers are consumed strictly in file order and each
+    one is resubmitted for the next free offset as soon as it is hashed.
+
+    Raw syscalls, no liburing needed. Returns ENOSYS when the kernel (or a
+    seccomp filter) refuses io_uring so the caller can fall back to read().
+*/
+#define URING_BUF_SIZE (1024 * 1024)
+#define URING_MAX_QD   64
+#define URING_QD       8
+
+struct uring {
+    int fd;
+    unsigned sq_entries, cq_entries;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+};
+
+static int uring_setup(struct uring *u, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+
+    u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (u->fd < 0) return errno;
+
+    u->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_ring_size > u->sq_ring_size) u->sq_ring_size = u->cq_ring_size;
+        u->cq_ring_size = u->sq_ring_size;
+    }
+
+    u->sq_ring = mmap(NULL, u->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_ring == MAP_FAILED) goto fail;
+    u->cq_ring = (p.features & IORING_FEAT_SINGLE_MMAP) ? u->sq_ring :
+                 mmap(NULL, u->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      u->fd, IORING_OFF_CQ_RING);
+    if (u->cq_ring == MAP_FAILED) goto fail;
+
+    u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) goto fail;
+
+    uint8_t *sq = u->sq_ring, *cq = u->cq_ring;
+    u->sq_entries = p.sq_entries;
+    u->sq_head  = (unsigned *)(sq + p.sq_off.head);
+    u->sq_tail  = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask  = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_entries = p.cq_entries;
+    u->cq_head  = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail  = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask  = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes     = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+
+fail:;
+    int err = errno;
+    if (u->sq_ring && u->sq_ring != MAP_FAILED) munmap(u->sq_ring, u->sq_ring_size);
+    if (u->cq_ring && u->cq_ring != MAP_FAILED && u->cq_ring != u->sq_ring) munmap(u->cq_ring, u->cq_ring_size);
+    close(u->fd);
+    return err;
+}
+
+static void uring_exit(struct uring *u) {
+    munmap(u->sqes, u->sqes_size);
+    if (u->cq_ring != u->sq_ring) munmap(u->cq_ring, u->cq_ring_size);
+    munmap(u->sq_ring, u->sq_ring_size);
+    close(u->fd);
+}
+
+/* Queues one READ_FIXED, user_data is the buffer slot */
+static void uring_queue_read(struct uring *u, int fd, unsigned slot, uint8_t *buf, size_t len, uint64_t off) {
+    unsigned tail = *u->sq_tail;
+    unsigned idx = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = (uint32_t)len;
+    sqe->off = off;
+    sqe->buf_index = (uint16_t)slot;
+    sqe->user_data = slot;
+
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static int uring_enter(struct uring *u, unsigned submit, unsigned wait) {
+    for (;;) {
+        long r = syscall(__NR_io_uring_enter, u->fd, submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (r >= 0) return 0;
+        if (errno != EINTR) return errno;
+    }
+}
+
+/* One in-flight block: the file range it covers and how much has arrived */
+struct uring_slot {
+    uint8_t *buf;
+    uint64_t off;
+    size_t len, got;
+    int ready;
+};
+
+/* O_DIRECT wants block-aligned lengths, the read just comes back short at EOF */
+static void uring_queue_slot(struct uring *u, int fd, unsigned i, struct uring_slot *sl) {
+    size_t want = (sl->len + STREAM_ALIGN - 1) & ~(size_t)(STREAM_ALIGN - 1);
+    uring_queue_read(u, fd, i, sl->buf + sl->got, want - sl->got, sl->off + sl->got);
+}
+
+/*
+    Hashes fd (regular file or block device of known size) through io_uring.
+    Same contract as hash_stream(): 0 or an errno, *total = bytes hashed.
+*/
+int hash_uring(int fd, struct hash_state *h, uint64_t size, int qd, uint64_t *total) {
+    struct uring u;
+    struct uring_slot slots[URING_MAX_QD];
+    struct iovec iov[URING_MAX_QD];
+    int err;
+
+    *total = 0;
+    if (qd < 1) qd = 1;
+    if (qd > URING_MAX_QD) qd = URING_MAX_QD;
+
+    if ((err = uring_setup(&u, (unsigned)qd))) return err;
+
+    for (int i = 0; i < qd; i++) {
+        if (posix_memalign((void **)&slots[i].buf, STREAM_ALIGN, URING_BUF_SIZE)) {
+            while (i--) free(slots[i].buf);
+            uring_exit(&u);
+            return ENOMEM;
+        }
+        iov[i].iov_base = slots[i].buf;
+        iov[i].iov_len = URING_BUF_SIZE;
+    }
+
+    unsigned queued = 0, submit = 0;
+    uint64_t next_off = 0;
+
+    if (syscall(__NR_io_uring_register, u.fd, IORING_REGISTER_BUFFERS, iov, qd) < 0) {
+        err = errno;
+        goto out;
+    }
+
+    /* Prime the ring: slot i reads block i, each block then moves qd slots on */
+    for (int i = 0; i < qd && next_off < size; i++, next_off += URING_BUF_SIZE) {
+        slots[i].off = next_off;
+        slots[i].len = size - next_off < URING_BUF_SIZE ? (size_t)(size - next_off) : URING_BUF_SIZE;
+        slots[i].got = 0;
+        slots[i].ready = 0;
+        uring_queue_slot(&u, fd, (unsigned)i, &slots[i]);
+        queued++;
+        submit++;
+    }
+
+    for (int slot = 0; *total < size; slot = (slot + 1) % qd) {
+        struct uring_slot *sl = &slots[slot];
+
+        /* Reap completions until the slot holding the next block is full */
+        while (!sl->ready) {
+            uint64_t t0 = stats_clock();
+            err = uring_enter(&u, submit, 1);
+            stats_stage(STAGE_READ, t0);
+            if (err) goto drain;
+            submit = 0;
+
+            unsigned head = *u.cq_head;
+            while (head != __atomic_load_n(u.cq_tail, __ATOMIC_ACQUIRE)) {
+                struct io_uring_cqe *cqe = &u.cqes[head & *u.cq_mask];
+                struct uring_slot *c = &slots[cqe->user_data];
+                int res = cqe->res;
+                head++;
+                queued--;
+
+                if (res < 0) {
+                    if (!err) err = -res;
+                    c->ready = 1;
+                    continue;
+                }
+                c->got += (size_t)res;
+                if (res == 0 || c->got >= c->len) {
+                    c->ready = 1;
+                } else {
+                    /* short read, ask for the rest into the same buffer */
+                    uring_queue_slot(&u, fd, (unsigned)cqe->user_data, c);
+                    queued++;
+                    submit++;
+                }
+            }
+            __atomic_store_n(u.cq_head, head, __ATOMIC_RELEASE);
+            if (err) goto drain;
+        }
+
+        size_t n = sl->got < sl->len ? sl->got : sl->len;
+        uint64_t t0 = stats_clock();
+        for (size_t off = 0; off < n; off += SP_BLOCK)
+            hash_update(h, sl->buf + off, n - off < SP_BLOCK ? n - off : SP_BLOCK);
+        stats_hashed(h->mask, n, n < SP_BLOCK ? n : SP_BLOCK, t0);
+        *total += n;
+        progress_add(n);
+        if (n < sl->len) break;   /* file shrank under us */
+
+        if (next_off < size) {
+            sl->off = next_off;
+            sl->len = size - next_off < URING_BUF_SIZE ? (size_t)(size - next_off) : URING_BUF_SIZE;
+            sl->got = 0;
+            sl->ready = 0;
+            uring_queue_slot(&u, fd, (unsigned)slot, sl);
+            next_off += URING_BUF_SIZE;
+            queued++;
+            submit++;
+        }
+    }
+
+drain:
+    /* Never free buffers the kernel may still be writing into */
+    while (queued) {
+        uint64_t t0 = stats_clock();
+        int rc = uring_enter(&u, submit, 1);
+        stats_stage(STAGE_READ, t0);
+        if (rc) break;
+        submit = 0;
+        unsigned head = *u.cq_head;
+        while (head != __atomic_load_n(u.cq_tail, __ATOMIC_ACQUIRE)) { head++; queued--; }
+        __atomic_store_n(u.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+out:
+    uring_exit(&u);
+    for (int i = 0; i < qd; i++) free(slots[i].buf);
+    return err;
+}
+
+/* ================= GPU OFFLOAD (OPENCL) ================= */
+/*
+    Optional backend for big files on hosts with an idle GPU (--gpu). The
+    file is read with pread() into two pinned staging buffers in turn:
+    while the device computes the CRCs of one batch, the host reads the
+    next one and runs the xxHashes over it, so every byte is read once.
+
+    Each work-item takes GPU_PIECE bytes and computes CRC-16, CRC-32C and
+    CRC-64 from zero registers with byte tables its work-group builds in
+    local memory. The host chains the pieces in file order with
+    crcN_shift(), the same algebra as the combine functions. XXH64 and XXH3
+    cannot be cut like that (a tree of partial digests no longer matches
+    xxhsum), so they stay on the CPU and overlap with the device.
+
+    libOpenCL is opened with dlopen() on first use: the build needs no
+    OpenCL headers or SDK and the binary still runs where there is none.
+    Files under --gpu-min, and files that arrive while the device is busy
+    with another one, are hashed on the CPU. The device and its buffers are
+    kept for the life of the process.
+*/
+#define GPU_PIECE       (16 * 1024)
+#define GPU_BATCH       ((size_t)64 * 1024 * 1024)
+#define GPU_ITEMS       (GPU_BATCH / GPU_PIECE)
+#define GPU_GROUP       64
+#define GPU_MIN_DEFAULT ((uint64_t)1 << 30)
+
+/* The subset of the OpenCL 1.2 ABI used here (cl.h is not needed) */
+typedef int32_t  cl_int;
+typedef uint32_t cl_uint;
+typedef uint64_t cl_bitfield;
+typedef struct _cl_platform_id   *cl_platform_id;
+typedef struct _cl_device_id     *cl_device_id;
+typedef struct _cl_context       *cl_context;
+typedef struct _cl_command_queue *cl_command_queue;
+typedef struct _cl_mem           *cl_mem;
+typedef struct _cl_program       *cl_program;
+typedef struct _cl_kernel        *cl_kernel;
+typedef struct _cl_event         *cl_event;
+
+#define CL_SUCCESS            0
+#define CL_FALSE              0
+#define CL_TRUE               1
+#define CL_DEVICE_TYPE_GPU    (1 << 2)
+#define CL_DEVICE_NAME        0x102B
+#define CL_PROGRAM_BUILD_LOG  0x1183
+#define CL_MEM_WRITE_ONLY     (1 << 1)
+#define CL_MEM_READ_ONLY      (1 << 2)
+#define CL_MEM_ALLOC_HOST_PTR (1 << 4)
+#define CL_MAP_WRITE          (1 << 1)
+
+static struct {
+    cl_int (*GetPlatformIDs)(cl_uint, cl_platform_id *, cl_uint *);
+    cl_int (*GetDeviceIDs)(cl_platform_id, cl_bitfield, cl_uint, cl_device_id *, cl_uint *);
+    cl_int (*GetDeviceInfo)(cl_device_id, cl_uint, size_t, void *, size_t *);
+    cl_context (*CreateContext)(const intptr_t *, cl_uint, const cl_device_id *, void *, void *, cl_int *);
+    cl_command_queue (*CreateCommandQueue)(cl_context, cl_device_id, cl_bitfield, cl_int *);
+    cl_mem (*CreateBuffer)(cl_context, cl_bitfield, size_t, void *, cl_int *);
+    void *(*EnqueueMapBuffer)(cl_command_queue, cl_mem, cl_uint, cl_bitfield, size_t, size_t,
+                              cl_uint, const cl_event *, cl_event *, cl_int *);
+    cl_program (*CreateProgramWithSource)(cl_context, cl_uint, const char **, const size_t *, cl_int *);
+    cl_int (*BuildProgram)(cl_program, cl_uint, const cl_device_id *, const char *, void *, void *);
+    cl_int (*GetProgramBuildInfo)(cl_program, cl_device_id, cl_uint, size_t, void *, size_t *);
+    cl_kernel (*CreateKernel)(cl_program, const char *, cl_int *);
+    cl_int (*SetKernelArg)(cl_kernel, cl_uint, size_t, const void *);
+    cl_int (*EnqueueWriteBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t, const void *,
+                                 cl_uint, const cl_event *, cl_event *);
+    cl_int (*EnqueueNDRangeKernel)(cl_command_queue, cl_kernel, cl_uint, const size_t *, const size_t *,
+                                   const size_t *, cl_uint, const cl_event *, cl_event *);
+    cl_int (*EnqueueReadBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t, void *,
+                                cl_uint, const cl_event *, cl_event *);
+    cl_int (*WaitForEvents)(cl_uint, const cl_event *);
+    cl_int (*ReleaseEvent)(cl_event);
+    cl_int (*Finish)(cl_command_queue);
+} cl;
+
+/* out[3 * piece + k]: the raw CRC-16, CRC-32C and CRC-64 registers of each piece (mask: HASH_* bits) */
+static const char gpu_source[] =
+    "__kernel void crc_pieces(__global const uchar *data, ulong len, uint mask, __global ulong *out) {\n"
+    "    __local ushort t16[256];\n"
+    "    __local uint t32[256];\n"
+    "    __local ulong t64[256];\n"
+    "    for (uint i = get_local_id(0); i < 256; i += get_local_size(0)) {\n"
+    "        uint a = i << 8, b = i;\n"
+    "        ulong c = (ulong)i << 56;\n"
+    "        for (int k = 0; k < 8; k++) {\n"
+    "            a = (a & 0x8000) ? (a << 1) ^ 0x1021 : a << 1;\n"
+    "            b = (b & 1) ? (b >> 1) ^ 0x82F63B78 : b >> 1;\n"
+    "            c = (c >> 63) ? (c << 1) ^ 0x42F0E1EBA9EA3693UL : c << 1;\n"
+    "        }\n"
+    "        t16[i] = (ushort)a;\n"
+    "        t32[i] = b;\n"
+    "        t64[i] = c;\n"
+    "    }\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "\n"
+    "    size_t id = get_global_id(0);\n"
+    "    ulong off = (ulong)id * PIECE;\n"
+    "    if (off >= len) return;\n"
+    "    ulong end = min(off + PIECE, len);\n"
+    "    uint a = 0, b = 0;\n"
+    "    ulong c = 0;\n"
+    "    for (ulong i = off; i < end; i++) {\n"
+    "        uint x = data[i];\n"
+    "        if (mask & 1) a = t16[((a >> 8) ^ x) & 0xFF] ^ ((a << 8) & 0xFFFF);\n"
+    "        if (mask & 2) b = t32[(b ^ x) & 0xFF] ^ (b >> 8);\n"
+    "        if (mask & 4) c = t64[(c >> 56) ^ x] ^ (c << 8);\n"
+    "    }\n"
+    "    out[3 * id] = a;\n"
+    "    out[3 * id + 1] = b;\n"
+    "    out[3 * id + 2] = c;\n"
+    "}\n";
+
+struct gpu_slot {
+    cl_mem host, dev, out;
+    uint8_t *buf;               /* host, pinned and mapped for good */
+    uint64_t *res;              /* GPU_ITEMS * 3 piece registers */
+    size_t len;
+    cl_event done;
+};
+
+static struct {
+    int ready;
+    char name[128];
+    cl_command_queue q;
+    cl_kernel kernel;
+    struct gpu_slot slot[2];
+    pthread_mutex_t lock;       /* one file on the device at a time */
+} gpu = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static pthread_once_t gpu_once = PTHREAD_ONCE_INIT;
+
+/* --gpu / --gpu-min: files of at least this many bytes go to the device */
+static uint64_t gpu_min = UINT64_MAX;
+
+static void gpu_unavailable(const char *why, cl_int e) {
+    if (e) cfprintf(stderr, C_YELLOW "GPU unavailable (%s, error %d), hashing on the CPU\n" C_RESET, why, e);
+    else cfprintf(stderr, C_YELLOW "GPU unavailable (%s), hashing on the CPU\n" C_RESET, why);
+}
+
+static void gpu_setup(void) {
+    void *lib = dlopen("libOpenCL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!lib) lib = dlopen("libOpenCL.so", RTLD_NOW | RTLD_LOCAL);
+    if (!lib) { gpu_unavailable("no libOpenCL", 0); return; }
+
+#define CL_LOAD(f) if (!(cl.f = (__typeof__(cl.f))dlsym(lib, "cl" #f))) { gpu_unavailable("cl" #f " missing", 0); return; }
+    CL_LOAD(GetPlatformIDs) CL_LOAD(GetDeviceIDs) CL_LOAD(GetDeviceInfo) CL_LOAD(CreateContext)
+    CL_LOAD(CreateCommandQueue) CL_LOAD(CreateBuffer) CL_LOAD(EnqueueMapBuffer) CL_LOAD(CreateProgramWithSource)
+    CL_LOAD(BuildProgram) CL_LOAD(GetProgramBuildInfo) CL_LOAD(CreateKernel) CL_LOAD(SetKernelArg)
+    CL_LOAD(EnqueueWriteBuffer) CL_LOAD(EnqueueNDRangeKernel) CL_LOAD(EnqueueReadBuffer)
+    CL_LOAD(WaitForEvents) CL_LOAD(ReleaseEvent) CL_LOAD(Finish)
+#undef CL_LOAD
+
+    /* The first GPU of any platform */
+    cl_platform_id plat[8];
+    cl_uint nplat = 0, ndev = 0;
+    cl_device_id dev = NULL;
+    cl_int e = cl.GetPlatformIDs(8, plat, &nplat);
+    if (e || !nplat) { gpu_unavailable("no OpenCL platform", e); return; }
+    for (cl_uint i = 0; i < nplat && !dev; i++)
+        if (cl.GetDeviceIDs(plat[i], CL_DEVICE_TYPE_GPU, 1, &dev, &ndev) || !ndev) dev = NULL;
+    if (!dev) { gpu_unavailable("no OpenCL GPU", 0); return; }
+    if (cl.GetDeviceInfo(dev, CL_DEVICE_NAME, sizeof(gpu.name), gpu.name, NULL)) strcpy(gpu.name, "OpenCL GPU");
+    gpu.name[sizeof(gpu.name) - 1] = '\0';
+
+    cl_context ctx = cl.CreateContext(NULL, 1, &dev, NULL, NULL, &e);
+    if (!ctx) { gpu_unavailable("clCreateContext", e); return; }
+    gpu.q = cl.CreateCommandQueue(ctx, dev, 0, &e);
+    if (!gpu.q) { gpu_unavailable("clCreateCommandQueue", e); return; }
+
+    const char *src = gpu_source;
+    char opts[64];
+    snprintf(opts, sizeof(opts), "-DPIECE=%dUL", GPU_PIECE);
+    cl_program prog = cl.CreateProgramWithSource(ctx, 1, &src, NULL, &e);
+    if (!prog) { gpu_unavailable("clCreateProgramWithSource", e); return; }
+    if ((e = cl.BuildProgram(prog, 1, &dev, opts, NULL, NULL))) {
+        char log[1024] = "";
+        cl.GetProgramBuildInfo(prog, dev, CL_PROGRAM_BUILD_LOG, sizeof(log) - 1, log, NULL);
+        gpu_unavailable("kernel build failed", e);
+        if (*log) fprintf(stderr, "%s\n", log);
+        return;
+    }
+    gpu.kernel = cl.CreateKernel(prog, "crc_pieces", &e);
+    if (!gpu.kernel) { gpu_unavailable("clCreateKernel", e); return; }
+
+    for (int s = 0; s < 2; s++) {
+        struct gpu_slot *sl = &gpu.slot[s];
+        sl->host = cl.CreateBuffer(ctx, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR, GPU_BATCH, NULL, &e);
+        sl->dev = sl->host ? cl.CreateBuffer(ctx, CL_MEM_READ_ONLY, GPU_BATCH, NULL, &e) : NULL;
+        sl->out = sl->dev ? cl.CreateBuffer(ctx, CL_MEM_WRITE_ONLY, GPU_ITEMS * 3 * sizeof(uint64_t), NULL, &e) : NULL;
+        if (!sl->out) { gpu_unavailable("clCreateBuffer", e); return; }
+        sl->buf = cl.EnqueueMapBuffer(gpu.q, sl->host, CL_TRUE, CL_MAP_WRITE, 0, GPU_BATCH, 0, NULL, NULL, &e);
+        if (!sl->buf) { gpu_unavailable("clEnqueueMapBuffer", e); return; }
+        sl->res = malloc(GPU_ITEMS * 3 * sizeof(uint64_t));
+        if (!sl->res) { gpu_unavailable(strerror(errno), 0); return; }
+    }
+    gpu.ready = 1;
+}
+
+/* Upload, kernel and read-back of a filled slot, all queued without waiting */
+static cl_int gpu_enqueue(struct gpu_slot *sl, unsigned crcs) {
+    size_t items = (sl->len + GPU_PIECE - 1) / GPU_PIECE;
+    size_t global = (items + GPU_GROUP - 1) / GPU_GROUP * GPU_GROUP, local = GPU_GROUP;
+    uint64_t len = sl->len;
+    cl_uint mask = crcs;
+    cl_int e;
+
+    if ((e = cl.EnqueueWriteBuffer(gpu.q, sl->dev, CL_FALSE, 0, sl->len, sl->buf, 0, NULL, NULL)) ||
+        (e = cl.SetKernelArg(gpu.kernel, 0, sizeof(cl_mem), &sl->dev)) ||
+        (e = cl.SetKernelArg(gpu.kernel, 1, sizeof(len), &len)) ||
+        (e = cl.SetKernelArg(gpu.kernel, 2, sizeof(mask), &mask)) ||
+        (e = cl.SetKernelArg(gpu.kernel, 3, sizeof(cl_mem), &sl->out)) ||
+        (e = cl.EnqueueNDRangeKernel(gpu.q, gpu.kernel, 1, NULL, &global, &local, 0, NULL, NULL)))
+        return e;
+    return cl.EnqueueReadBuffer(gpu.q, sl->out, CL_FALSE, 0, items * 3 * sizeof(uint64_t), sl->res, 0, NULL, &sl->done);
+}
+
+/* Waits for a slot and appends its pieces to the file registers */
+static cl_int gpu_collect(struct gpu_slot *sl, unsigned crcs, struct hash_state *h) {
+    uint64_t t0 = stats_clock();
+    cl_int e = cl.WaitForEvents(1, &sl->done);
+    cl.ReleaseEvent(sl->done);
+    stats_stage(STAGE_HASH, t0);
+    if (e) return e;
+
+    t0 = stats_clock();
+    for (size_t i = 0, off = 0; off < sl->len; i++, off += GPU_PIECE) {
+        uint64_t n = sl->len - off < GPU_PIECE ? sl->len - off : GPU_PIECE;
+        if (crcs & HASH_CRC16) h->crc16 = crc16_shift(h->crc16, n) ^ (uint16_t)sl->res[3 * i];
+        if (crcs & HASH_CRC32) h->crc32 = crc32_shift(h->crc32, n) ^ (uint32_t)sl->res[3 * i + 1];
+        if (crcs & HASH_CRC64) h->crc64 = crc64_shift(h->crc64, n) ^ sl->res[3 * i + 2];
+    }
+    stats_stage(STAGE_COMBINE, t0);
+    stats_device(crcs, sl->len);
+    return CL_SUCCESS;
+}
+
+/*
+    The crcs (HASH_CRC* bits) of the first size bytes of fd on the device,
+    into the registers of h, while hash_update() runs the rest of h's mask
+    over the same buffers. Returns 0, an errno value for a read error, or
+    -1 when the device is busy or unusable (h is then undefined, hash the
+    file on the CPU).
+*/
+static int gpu_hash_file(int fd, uint64_t size, unsigned crcs, struct hash_state *h) {
+    if (pthread_mutex_trylock(&gpu.lock)) return -1;
+    pthread_once(&gpu_once, gpu_setup);
+    if (!gpu.ready) {
+        pthread_mutex_unlock(&gpu.lock);
+        return -1;
+    }
+
+    h->crc16 = 0xFFFF;
+    h->crc32 = 0xFFFFFFFF;
+    h->crc64 = 0;
+
+    /* Fill and queue one slot, then drain the other one while the device works */
+    int err = 0;
+    cl_int e = CL_SUCCESS;
+    struct gpu_slot *prev = NULL;
+    uint64_t off = 0;
+    for (int s = 0;; s ^= 1) {
+        struct gpu_slot *sl = &gpu.slot[s];
+        sl->len = 0;
+        if (off < size && !err && !e) {
+            size_t want = size - off < GPU_BATCH ? (size_t)(size - off) : GPU_BATCH;
+            ssize_t n = pread_full(fd, sl->buf, want, (off_t)off);
+            if (n < 0) {
+                err = errno;
+            } else if (n) {
+                sl->len = (size_t)n;
+                if ((e = gpu_enqueue(sl, crcs))) {
+                    sl->len = 0;
+                } else {
+                    uint64_t t0 = stats_clock();
+                    for (size_t o = 0; h->mask && o < sl->len; o += SP_BLOCK)
+                        hash_update(h, sl->buf + o, sl->len - o < SP_BLOCK ? sl->len - o : SP_BLOCK);
+                    stats_hashed(h->mask, sl->len, SP_BLOCK, t0);
+                    progress_add(sl->len);
+                }
+            }
+            off = (size_t)n < want ? size : off + want;   /* a file that shrank ends here */
+        }
+        if (prev) {
+            cl_int c = gpu_collect(prev, crcs, h);
+            if (!e) e = c;
+        }
+        if (!sl->len) break;
+        prev = sl;
+    }
+
+    /* A device that failed once is not tried again */
+    if (e) {
+        cl.Finish(gpu.q);
+        gpu.ready = 0;
+        gpu_unavailable("device error", e);
+    }
+    pthread_mutex_unlock(&gpu.lock);
+    return e ? -1 : err;
+}
+
+/* ================= WINDOWED MMAP INPUT ================= */
+/*
+    Instead of one mapping of the whole file, a MMAP_WINDOW view slides
+    across it, so 32-bit builds and memory-limited containers can hash
+    files of any size. Each window is walked in MMAP_STEP pieces:
+    WILLNEED is issued MMAP_AHEAD bytes in front of the cursor to keep
+    readahead busy, and processed pieces are dropped from the mapping
+    (MADV_DONTNEED) so RSS stays flat. With MAP_OPT_DROP the pages are
+    also dropped from the page cache behind the cursor (POSIX_FADV_DONTNEED),
+    main() sets it on the last pass over files bigger than one window so
+    they do not push everything else out.
+
+    Holes of sparse files are found with lseek(SEEK_HOLE / SEEK_DATA) and
+    handed to fn as p == NULL runs of zeros: they are never touched, and
+    no readahead is asked for a piece that is all hole (it would only fill
+    the page cache with zero pages). Filesystems without hole support
+    report the whole file as data.
+*/
+#define MMAP_WINDOW ((size_t)(sizeof(void *) > 4 ? 1024 : 256) * 1024 * 1024)
+#define MMAP_STEP   ((size_t)64 * 1024 * 1024)
+#define MMAP_AHEAD  (2 * MMAP_STEP)
+
+#define MAP_OPT_HUGEPAGE 0x1u   /* --hugepage: MADV_HUGEPAGE on each window */
+#define MAP_OPT_POPULATE 0x2u   /* --populate: MAP_POPULATE, fault the window in up front */
+#define MAP_OPT_DROP     0x4u   /* drop pages from the page cache once hashed */
+
+typedef void (*window_fn)(const uint8_t *p, size_t len, uint64_t off, void *ctx);
+
+static uint8_t *map_range(int fd, uint64_t off, size_t len, unsigned opts) {
+    uint64_t t0 = stats_clock();
+    uint8_t *p = mmap(NULL, len, PROT_READ, MAP_PRIVATE | (opts & MAP_OPT_POPULATE ? MAP_POPULATE : 0), fd, (off_t)off);
+    stats_stage(opts & MAP_OPT_POPULATE ? STAGE_FAULT : STAGE_MAP, t0);
+    if (p == MAP_FAILED) return NULL;
+    t0 = stats_clock();
+    madvise(p, len, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    if (opts & MAP_OPT_HUGEPAGE) madvise(p, len, MADV_HUGEPAGE);
+#endif
+    stats_stage(STAGE_MAP, t0);
+    return p;
+}
+
+/* First data offset in [off, end), end when there is none */
+static uint64_t next_data(int fd, uint64_t off, uint64_t end) {
+#ifdef SEEK_DATA
+    off_t d = lseek(fd, (off_t)off, SEEK_DATA);
+    if (d < 0) return errno == ENXIO ? end : off;   /* ENXIO: holes up to end of file */
+    return (uint64_t)d < end ? (uint64_t)d : end;
+#else
+    (void)fd; (void)end;
+    return off;
+#endif
+}
+
+/* First hole offset in [off, end), end when there is none */
+static uint64_t next_hole(int fd, uint64_t off, uint64_t end) {
+#ifdef SEEK_HOLE
+    off_t h = lseek(fd, (off_t)off, SEEK_HOLE);
+    if (h >= 0 && (uint64_t)h < end) return (uint64_t)h;
+#else
+    (void)fd; (void)off;
+#endif
+    return end;
+}
+
+/* The first hole in [pos, end) trimmed to multiples of align, [end, end) when there is none */
+static void next_zero_run(int fd, uint64_t pos, uint64_t end, uint64_t align, uint64_t *hs, uint64_t *he) {
+    while (pos < end) {
+        uint64_t h = next_hole(fd, pos, end);
+        if (h >= end) break;
+        uint64_t d = next_data(fd, h, end);
+        if (d <= h) break;
+        uint64_t s = (h + align - 1) / align * align;
+        uint64_t e = d < end ? d / align * align : d;
+        if (e > s) {
+            *hs = s;
+            *he = e;
+            return;
+        }
+        pos = d;
+    }
+    *hs = *he = end;
+}
+
+/* WILLNEED on the MMAP_STEP piece at off, unless it is all hole */
+static void map_ahead(int fd, uint8_t *base, uint64_t woff, size_t wlen, uint64_t size, uint64_t off) {
+    if (off >= size) return;
+    size_t n = size - off < MMAP_STEP ? (size_t)(size - off) : MMAP_STEP;
+    if (next_data(fd, off, off + n) == off + n) return;
+    if (off < woff + wlen)
+        madvise(base + (off - woff), n, MADV_WILLNEED);
+    else   /* the next window has no mapping yet */
+        posix_fadvise(fd, (off_t)off, (off_t)n, POSIX_FADV_WILLNEED);
+}
+
+/*
+    Calls fn over the file in order, 0 or an errno: data runs within each
+    MMAP_STEP piece, and holes of at least align bytes as fn(NULL, ...).
+    Holes start and end on multiples of align, except at end of file.
+*/
+static int map_windows_aligned(int fd, uint64_t size, unsigned opts, uint64_t align, window_fn fn, void *ctx) {
+    for (uint64_t woff = 0; woff < size; woff += MMAP_WINDOW) {
+        size_t wlen = size - woff < MMAP_WINDOW ? (size_t)(size - woff) : MMAP_WINDOW;
+        uint8_t *base = map_range(fd, woff, wlen, opts);
+        if (!base) return errno;
+        uint64_t t0 = stats_clock();
+        for (uint64_t a = 0; a < MMAP_AHEAD && a < wlen; a += MMAP_STEP)
+            map_ahead(fd, base, woff, wlen, size, woff + a);
+        stats_stage(STAGE_MAP, t0);
+
+        for (size_t off = 0; off < wlen; off += MMAP_STEP) {
+            size_t n = wlen - off < MMAP_STEP ? wlen - off : MMAP_STEP;
+            t0 = stats_clock();
+            map_ahead(fd, base, woff, wlen, size, woff + off + MMAP_AHEAD);
+            stats_stage(STAGE_MAP, t0);
+
+            uint64_t pos = woff + off, end = pos + n;
+            while (pos < end) {
+                uint64_t hs, he;
+                next_zero_run(fd, pos, end, align, &hs, &he);
+                if (hs > pos) fn(base + (pos - woff), (size_t)(hs - pos), pos, ctx);
+                if (he > hs) fn(NULL, (size_t)(he - hs), hs, ctx);
+                pos = he;
+            }
+
+            t0 = stats_clock();
+            madvise(base + off, n, MADV_DONTNEED);
+            if (opts & MAP_OPT_DROP) posix_fadvise(fd, (off_t)(woff + off), (off_t)n, POSIX_FADV_DONTNEED);
+            stats_stage(STAGE_MAP, t0);
+        }
+        t0 = stats_clock();
+        munmap(base, wlen);
+        stats_stage(STAGE_MAP, t0);
+    }
+    return 0;
+}
+
+int map_windows(int fd, uint64_t size, unsigned opts, window_fn fn, void *ctx) {
+    return map_windows_aligned(fd, size, opts, 1, fn, ctx);
+}
+
+/* ---------- window consumers ---------- */
+struct sp_window_ctx {
+    struct hash_state *h;
+};
+
+static void sp_window(const uint8_t *p, size_t len, uint64_t off, void *arg) {
+    struct sp_window_ctx *c = arg;
+    uint64_t t0 = stats_clock();
+    (void)off;
+    if (!p) {
+        hash_update_zeros(c->h, len);
+        stats_stage(STAGE_HASH, t0);
+        stats_holes(c->h->mask, len);
+        progress_add(len);
+        return;
+    }
+    for (size_t i = 0; i < len; i += SP_BLOCK) {
+        size_t n = len - i < SP_BLOCK ? len - i : SP_BLOCK;
+        hash_update(c->h, p + i, n);
+        progress_add(n);
+    }
+    stats_hashed(c->h->mask, len, len < SP_BLOCK ? len : SP_BLOCK, t0);
+}
+
+struct crc32_window_ctx {
+    uint32_t crc;
+    int threads;
+};
+
+/* Every piece is hashed in parallel, then appended to the running CRC */
+static void crc32_window(const uint8_t *p, size_t len, uint64_t off, void *arg) {
+    struct crc32_window_ctx *c = arg;
+    uint32_t crc;
+    if (p) {
+        crc = crc32_parallel(p, len, c->threads);
+    } else {
+        uint64_t t0 = stats_clock();
+        crc = crc32_shift(0xFFFFFFFF, len) ^ 0xFFFFFFFF;
+        stats_stage(STAGE_HASH, t0);
+        stats_holes(HASH_CRC32, len);
+        progress_add(len);
+    }
+    uint64_t t0 = stats_clock();
+    c->crc = off ? crc32_combine(c->crc, crc, len) : crc;
+    stats_stage(STAGE_COMBINE, t0);
+}
+
+/* One catalogue CRC (--crc NAME), holes stepped over with crc_model_shift() */
+struct model_window_ctx {
+    const struct crc_model *m;
+    uint64_t reg;
+};
+
+static void model_window(const uint8_t *p, size_t len, uint64_t off, void *arg) {
+    struct model_window_ctx *c = arg;
+    uint64_t t0 = stats_clock();
+    (void)off;
+    if (!p) {
+        c->reg = crc_model_shift(c->m, c->reg, len);
+        stats_stage(STAGE_HASH, t0);
+        stats_holes(STAT_MODEL, len);
+        progress_add(len);
+        return;
+    }
+    for (size_t i = 0; i < len; i += SP_BLOCK) {
+        size_t n = len - i < SP_BLOCK ? len - i : SP_BLOCK;
+        c->reg = crc_model_update(c->m, c->reg, p + i, n);
+        progress_add(n);
+    }
+    stats_stage(STAGE_HASH, t0);
+    if (stats.on) stats.model_bytes += len;
+}
+
+/* Streams and other unmappable inputs, 0 or an errno */
+static int model_stream(int fd, struct model_window_ctx *c) {
+    uint8_t *buf = malloc(STREAM_BUF_SIZE);
+    ssize_t n;
+    if (!buf) return ENOMEM;
+    while ((n = stream_fill(fd, buf, STREAM_BUF_SIZE)) > 0) {
+        model_window(buf, (size_t)n, 0, c);
+        if (n < STREAM_BUF_SIZE) break;
+    }
+    int err = n < 0 ? errno : 0;
+    free(buf);
+    return err;
+}
+
+/* --list-crcs: the catalogue, each model checked against "123456789" with the current kernels */
+static int list_models(void) {
+    int bad = 0;
+    printf("%-16s %-19s %5s  %-18s %-18s %-5s %-6s %-18s %s\n",
+           "Name", "Alias", "Width", "Poly", "Init", "RefIn", "RefOut", "XorOut", "Check");
+    for (int i = 0; i < crc_model_count(); i++) {
+        const struct crc_model *m = crc_model_get(i);
+        int w = (m->width + 3) / 4;
+        int ok = crc_model_hash(m, "123456789", 9) == m->check;
+        bad |= !ok;
+        cprintf("%-16s %-19s %5d  0x%0*llX%*s 0x%0*llX%*s %-5s %-6s 0x%0*llX%*s %0*llX%*s %s\n",
+                m->name, m->alias ? m->alias : "-", m->width,
+                w, (unsigned long long)m->poly, 16 - w, "", w, (unsigned long long)m->init, 16 - w, "",
+                m->refin ? "true" : "false", m->refout ? "true" : "false",
+                w, (unsigned long long)m->xorout, 16 - w, "", w, (unsigned long long)m->check, 16 - w, "",
+                ok ? C_GREEN "OK" C_RESET : C_RED "FAILED" C_RESET);
+    }
+    return bad ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* ================= DIGEST CACHE ================= */
+/*
+    --cache FILE keeps the digests of the multi-file and --check modes
+    between runs. An entry is keyed by (dev, inode, size, mtime, ctime),
+    times in nanoseconds. A file whose stat() still matches, and whose
+    entry holds every hash asked for, is answered without being opened.
+    --rehash reads every file again and refreshes the entries.
+
+    The index is a header and one array of fixed-size entries sorted by
+    (dev, inode). It is mapped read-only and binary searched, so a lookup
+    costs a stat() and a few page touches however big the index is. A run
+    that hashed anything rewrites it (temp file, then rename); entries of
+    files the run did not visit are kept. Entries are in host byte order,
+    and an index of another version or entry size is ignored.
+
+    The index holds no paths, so an entry of a deleted file cannot be told
+    from one of a file outside the run. A changed or replaced file gets a
+    new entry in place of the old one of its inode. Entries of deleted
+    files are removed by --rehash: it rebuilds the index from the files of
+    that run alone, so it should cover the whole tree the cache serves.
+
+    A file changed less than CACHE_RACY_NS before the run started is not
+    stored: with coarse timestamps it could change again during the run
+    and keep the same mtime and ctime, and the stale digest would match.
+*/
+#define CACHE_MAGIC   "CRCCACHE"
+#define CACHE_VERSION 1
+#define CACHE_RACY_NS 2000000000LL
+
+struct cache_key {
+    uint64_t dev, ino, size;
+    int64_t mtime_ns, ctime_ns;
+};
+
+struct cache_entry {
+    struct cache_key key;
+    uint32_t mask;          /* HASH_* bits held in d */
+    uint32_t reserved;
+    struct hash_digest d;
+};
+
+struct cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t count;
+};
+
+/* A file of this run: its key once opened, the entry once hashed */
+struct cache_slot {
+    struct cache_entry e;
+    int noted;
+};
+
+struct cache {
+    const char *path;
+    int rehash;
+    const struct cache_entry *old;  /* the mapped index */
+    size_t nold;
+    void *map;
+    size_t map_len;
+    struct cache_slot *slots;       /* one per file of the run */
+    size_t nslots;
+    int64_t start_ns;
+};
+
+static void cache_key_of(struct cache_key *k, const struct stat *st) {
+    k->dev = (uint64_t)st->st_dev;
+    k->ino = (uint64_t)st->st_ino;
+    k->size = (uint64_t)st->st_size;
+    k->mtime_ns = (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+    k->ctime_ns = (int64_t)st->st_ctim.tv_sec * 1000000000 + st->st_ctim.tv_nsec;
+}
+
+static int cache_cmp(const void *a, const void *b) {
+    const struct cache_key *x = a, *y = b;
+    if (x->dev != y->dev) return x->dev < y->dev ? -1 : 1;
+    if (x->ino != y->ino) return x->ino < y->ino ? -1 : 1;
+    return 0;
+}
+
+/* The entry of the same file (dev and inode), whatever its other fields */
+static const struct cache_entry *cache_find(const struct cache *c, const struct cache_key *k) {
+    return bsearch(k, c->old, c->nold, sizeof(*c->old), cache_cmp);
+}
+
+/* A missing, unreadable or foreign index just starts empty */
+static void cache_open(struct cache *c, const char *path, int rehash) {
+    struct timespec ts;
+    struct stat st;
+
+    memset(c, 0, sizeof(*c));
+    c->path = path;
+    c->rehash = rehash;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    c->start_ns = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) fprintf(stderr, "crc: cache %s: %s\n", path, strerror(errno));
+        return;
+    }
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= sizeof(struct cache_header)) {
+        void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const struct cache_header *h = p;
+        if (p == MAP_FAILED) {
+            fprintf(stderr, "crc: cache %s: %s\n", path, strerror(errno));
+        } else if (memcmp(h->magic, CACHE_MAGIC, 8) || h->version != CACHE_VERSION ||
+                   h->entry_size != sizeof(struct cache_entry) ||
+                   h->count != ((uint64_t)st.st_size - sizeof(*h)) / sizeof(struct cache_entry) ||
+                   ((uint64_t)st.st_size - sizeof(*h)) % sizeof(struct cache_entry)) {
+            fprintf(stderr, "crc: cache %s: not a crc %d cache, starting a new one\n", path, CACHE_VERSION);
+            munmap(p, (size_t)st.st_size);
+        } else {
+            c->map = p;
+            c->map_len = (size_t)st.st_size;
+            c->old = (const struct cache_entry *)(h + 1);
+            c->nold = (size_t)h->count;
+            madvise(p, c->map_len, MADV_RANDOM);
+        }
+    }
+    close(fd);
+}
+
+/* Digests of path from the cache, 1 on a hit. Never opens the file */
+static int cache_lookup(struct cache *c, const char *path, unsigned mask, struct hash_digest *d, uint64_t *size) {
+    struct stat st;
+    struct cache_key k;
+
+    if (c->rehash || stat(path, &st) < 0 || !S_ISREG(st.st_mode)) return 0;
+    cache_key_of(&k, &st);
+    const struct cache_entry *e = cache_find(c, &k);
+    if (!e || memcmp(&e->key, &k, sizeof(k)) || (e->mask & mask) != mask) return 0;
+    *d = e->d;
+    *size = (uint64_t)st.st_size;
+    return 1;
+}
+
+/* File i was opened: remember its key, hashes already cached for it are kept */
+static void cache_note(struct cache *c, size_t i, const struct stat *st) {
+    struct cache_slot *s = &c->slots[i];
+    cache_key_of(&s->e.key, st);
+    if (s->e.key.mtime_ns > c->start_ns - CACHE_RACY_NS || s->e.key.ctime_ns > c->start_ns - CACHE_RACY_NS)
+        return;
+    const struct cache_entry *e = cache_find(c, &s->e.key);
+    if (e && !memcmp(&e->key, &s->e.key, sizeof(s->e.key))) {
+        s->e.mask = e->mask;
+        s->e.d = e->d;
+    }
+    s->noted = 1;
+}
+
+static void cache_merge(struct cache_entry *e, unsigned mask, const struct hash_digest *d) {
+    if (mask & HASH_CRC16) e->d.crc16 = d->crc16;
+    if (mask & HASH_CRC32) e->d.crc32 = d->crc32;
+    if (mask & HASH_CRC64) e->d.crc64 = d->crc64;
+    if (mask & HASH_XXH64) e->d.xxh64 = d->xxh64;
+    if (mask & HASH_XXH3) {
+        e->d.xxh3 = d->xxh3;
+        e->d.xxh128 = d->xxh128;
+    }
+    e->mask |= mask;
+}
+
+/* File i is hashed: merge the mask hashes of d into its entry */
+static void cache_store(struct cache *c, size_t i, unsigned mask, const struct hash_digest *d) {
+    if (c->slots[i].noted) cache_merge(&c->slots[i].e, mask, d);
+}
+
+/* Rewrites the index with the entries of this run merged in (--rehash: only those), then unmaps it */
+static void cache_commit(struct cache *c) {
+    struct cache_entry *fresh = NULL;
+    size_t nold = c->rehash ? 0 : c->nold;
+    size_t n = 0;
+
+    for (size_t i = 0; i < c->nslots; i++)
+        if (c->slots[i].noted && c->slots[i].e.mask) n++;
+    if (n && !(fresh = malloc(n * sizeof(*fresh)))) { perror("malloc"); exit(EXIT_FAILURE); }
+    n = 0;
+    for (size_t i = 0; i < c->nslots; i++)
+        if (c->slots[i].noted && c->slots[i].e.mask) fresh[n++] = c->slots[i].e;
+    free(c->slots);
+    c->slots = NULL;
+
+    if (n || (c->rehash && c->nold)) {
+        /* a file listed twice (--check lines of different hashes) becomes one entry */
+        qsort(fresh, n, sizeof(*fresh), cache_cmp);
+        size_t m = 0;
+        for (size_t k = 0; k < n; k++) {
+            struct cache_entry *e = m ? &fresh[m - 1] : NULL;
+            if (!e || cache_cmp(e, &fresh[k])) fresh[m++] = fresh[k];
+            else if (!memcmp(&e->key, &fresh[k].key, sizeof(e->key))) cache_merge(e, fresh[k].mask, &fresh[k].d);
+            else if (fresh[k].key.ctime_ns > e->key.ctime_ns) *e = fresh[k];
+        }
+        n = m;
+
+        size_t len = strlen(c->path);
+        char *tmp = malloc(len + 32);
+        if (!tmp) { perror("malloc"); exit(EXIT_FAILURE); }
+        snprintf(tmp, len + 32, "%s.tmp.%ld", c->path, (long)getpid());
+        FILE *out = fopen(tmp, "wb");
+        int err = !out;
+
+        if (out) {
+            struct cache_header h = { .version = CACHE_VERSION, .entry_size = sizeof(struct cache_entry) };
+            size_t i = 0, j = 0;
+            memcpy(h.magic, CACHE_MAGIC, sizeof(h.magic));
+            fwrite(&h, sizeof(h), 1, out);
+            /* both sorted: a fresh entry replaces the old one of the same file */
+            while (i < nold || j < n) {
+                int order = i == nold ? 1 : j == n ? -1 : cache_cmp(&c->old[i], &fresh[j]);
+                fwrite(order < 0 ? &c->old[i] : &fresh[j], sizeof(*fresh), 1, out);
+                if (order <= 0) i++;
+                if (order >= 0) j++;
+                h.count++;
+            }
+            rewind(out);
+            fwrite(&h, sizeof(h), 1, out);
+            err = ferror(out) | (fclose(out) != 0);
+        }
+        if (err || rename(tmp, c->path) < 0) {
+            fprintf(stderr, "crc: cache %s: %s\n", c->path, strerror(errno ? errno : EIO));
+            unlink(tmp);
+        }
+        free(tmp);
+        free(fresh);
+    }
+
+    if (c->map) munmap(c->map, c->map_len);
+    c->map = NULL;
+    c->old = NULL;
+    c->nold = 0;
+}
+
+/* ================= OUTPUT FORMATS ================= */
+/*
+    --format picks how normal and multi-file mode write their digests:
+
+        text    the default: the details of one file, "<digests>  <path>" lines for many
+        json    JSON Lines, one object per file: path, size and a hex string per hash
+        csv     a header row, then path,size,<hashes>,error per file (RFC 4180 quoting)
+        tag     BSD tagged lines, one per hash: CRC32 (path) = E3069283, --check reads them
+        binary  per file the digests as big-endian bytes, then the path and a NUL
+
+    Hashes keep the order of the text columns, digests are in the same
+    byte order as their hex. Records are formatted by hand into an
+    OUT_BUF_SIZE buffer that goes out with write(2) once full, so no stdio
+    lock is taken per line. In multi-file mode only the writer thread
+    touches it (see sched_writer()).
+*/
+#define OUT_BUF_SIZE (1024 * 1024)
+
+enum out_format { FORMAT_TEXT, FORMAT_JSON, FORMAT_CSV, FORMAT_TAG, FORMAT_BINARY };
+
+static const char *const format_names[] = { "text", "json", "csv", "tag", "binary" };
+
+static enum out_format out_format = FORMAT_TEXT;
+
+/* Hashes shown per file, in output order */
+#define SHOW_CRC16  0x01u
+#define SHOW_CRC32  0x02u
+#define SHOW_CRC64  0x04u
+#define SHOW_XXH64  0x08u
+#define SHOW_XXH3   0x10u
+#define SHOW_XXH128 0x20u
+
+static const struct {
+    unsigned show;
+    const char *key, *tag;  /* JSON / CSV name, BSD tag */
+} out_hashes[] = {
+    { SHOW_CRC16, "crc16", "CRC16" }, { SHOW_CRC32, "crc32", "CRC32" }, { SHOW_CRC64, "crc64", "CRC64" },
+    { SHOW_XXH64, "xxh64", "XXH64" }, { SHOW_XXH3, "xxh3", "XXH3" }, { SHOW_XXH128, "xxh128", "XXH128" },
+};
+
+#define OUT_HASHES (sizeof(out_hashes) / sizeof(out_hashes[0]))
+
+struct out_buf {
+    int fd;
+    int err;                /* first write error */
+    char *p;
+    size_t len, cap;
+};
+
+static void out_flush(struct out_buf *o) {
+    size_t done = 0;
+    while (done < o->len && !o->err) {
+        ssize_t n = write(o->fd, o->p + done, o->len - done);
+        if (n < 0 && errno != EINTR) o->err = errno;
+        else if (n > 0) done += (size_t)n;
+    }
+    o->len = 0;
+}
+
+static void out_bytes(struct out_buf *o, const void *p, size_t n) {
+    if (o->len + n > o->cap) {
+        out_flush(o);
+        if (n > o->cap) {   /* bigger than the buffer: straight out */
+            struct out_buf direct = { o->fd, o->err, (char *)p, n, n };
+            out_flush(&direct);
+            o->err = direct.err;
+            return;
+        }
+    }
+    memcpy(o->p + o->len, p, n);
+    o->len += n;
+}
+
+static inline void out_char(struct out_buf *o, char c) {
+    if (o->len == o->cap) out_flush(o);
+    o->p[o->len++] = c;
+}
+
+static void out_str(struct out_buf *o, const char *s) {
+    out_bytes(o, s, strlen(s));
+}
+
+static void out_u64(struct out_buf *o, uint64_t v) {
+    char b[20];
+    int n = 0;
+    do b[sizeof(b) - ++n] = (char)('0' + v % 10); while (v /= 10);
+    out_bytes(o, b + sizeof(b) - n, (size_t)n);
+}
+
+static void out_hex(struct out_buf *o, uint64_t v, int digits) {
+    static const char hex[] = "0123456789ABCDEF";
+    char b[16];
+    for (int i = digits; i-- > 0; v >>= 4) b[i] = hex[v & 15];
+    out_bytes(o, b, (size_t)digits);
+}
+
+static void out_be(struct out_buf *o, uint64_t v, int bytes) {
+    char b[8];
+    for (int i = bytes; i-- > 0; v >>= 8) b[i] = (char)(v & 0xFF);
+    out_bytes(o, b, (size_t)bytes);
+}
+
+static void out_json_str(struct out_buf *o, const char *s) {
+    out_char(o, '"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out_char(o, '\\');
+            out_char(o, (char)c);
+        } else if (c < 0x20) {
+            out_str(o, "\\u00");
+            out_hex(o, c, 2);
+        } else {
+            out_char(o, (char)c);
+        }
+    }
+    out_char(o, '"');
+}
+
+static void out_csv_str(struct out_buf *o, const char *s) {
+    if (!strpbrk(s, ",\"\r\n")) {
+        out_str(o, s);
+        return;
+    }
+    out_char(o, '"');
+    for (; *s; s++) {
+        if (*s == '"') out_char(o, '"');
+        out_char(o, *s);
+    }
+    out_char(o, '"');
+}
+
+/* One SHOW_* digest, in hex or (binary) as big-endian bytes */
+static void out_digest(struct out_buf *o, const struct hash_digest *d, unsigned bit, int binary) {
+    uint64_t v = bit == SHOW_CRC16 ? d->crc16 : bit == SHOW_CRC32 ? d->crc32 : bit == SHOW_CRC64 ? d->crc64 :
+                 bit == SHOW_XXH64 ? d->xxh64 : bit == SHOW_XXH3 ? d->xxh3 : d->xxh128.hi;
+    int digits = bit == SHOW_CRC16 ? 4 : bit == SHOW_CRC32 ? 8 : 16;
+    if (binary) out_be(o, v, digits / 2);
+    else out_hex(o, v, digits);
+    if (bit == SHOW_XXH128) {
+        if (binary) out_be(o, d->xxh128.lo, 8);
+        else out_hex(o, d->xxh128.lo, 16);
+    }
+}
+
+/* A path of a text or tag line, with "\\" and "\n" escapes if escaped */
+static void out_path(struct out_buf *o, const char *path, int escaped) {
+    if (!escaped) {
+        out_str(o, path);
+        return;
+    }
+    for (const char *c = path; *c; c++) {
+        if (*c == '\\') out_str(o, "\\\\");
+        else if (*c == '\n') out_str(o, "\\n");
+        else out_char(o, *c);
+    }
+}
+
+/* The CSV header row, the only output before the first record */
+static void out_header(struct out_buf *o, unsigned show) {
+    if (out_format != FORMAT_CSV) return;
+    out_str(o, "path,size");
+    for (size_t i = 0; i < OUT_HASHES; i++)
+        if (show & out_hashes[i].show) {
+            out_char(o, ',');
+            out_str(o, out_hashes[i].key);
+        }
+    out_str(o, ",error\n");
+}
+
+/*
+    The record of one file. err is 0 or its errno: JSON and CSV carry it,
+    the other formats leave the file out (the caller reports it on stderr).
+*/
+static void out_record(struct out_buf *o, const struct hash_digest *d, unsigned show, const char *path,
+                       uint64_t size, int err) {
+    /* sha256sum escapes for text and tag: a leading backslash, then \\ and \n in the path */
+    int escaped = strpbrk(path, "\\\n") != NULL;
+    const char *sep = "";
+    switch (out_format) {
+        case FORMAT_TEXT:
+            if (err) return;
+            if (escaped) out_char(o, '\\');
+            for (size_t i = 0; i < OUT_HASHES; i++)
+                if (show & out_hashes[i].show) {
+                    out_str(o, sep);
+                    out_digest(o, d, out_hashes[i].show, 0);
+                    sep = " ";
+                }
+            out_str(o, "  ");
+            out_path(o, path, escaped);
+            out_char(o, '\n');
+            break;
+        case FORMAT_JSON:
+            out_str(o, "{\"path\":");
+            out_json_str(o, path);
+            if (err) {
+                out_str(o, ",\"error\":");
+                out_json_str(o, strerror(err));
+            } else {
+                out_str(o, ",\"size\":");
+                out_u64(o, size);
+                for (size_t i = 0; i < OUT_HASHES; i++)
+                    if (show & out_hashes[i].show) {
+                        out_str(o, ",\"");
+                        out_str(o, out_hashes[i].key);
+                        out_str(o, "\":\"");
+                        out_digest(o, d, out_hashes[i].show, 0);
+                        out_char(o, '"');
+                    }
+            }
+            out_str(o, "}\n");
+            break;
+        case FORMAT_CSV:
+            out_csv_str(o, path);
+            out_char(o, ',');
+            if (!err) out_u64(o, size);
+            for (size_t i = 0; i < OUT_HASHES; i++)
+                if (show & out_hashes[i].show) {
+                    out_char(o, ',');
+                    if (!err) out_digest(o, d, out_hashes[i].show, 0);
+                }
+            out_char(o, ',');
+            if (err) out_csv_str(o, strerror(err));
+            out_char(o, '\n');
+            break;
+        case FORMAT_TAG:
+            if (err) return;
+            for (size_t i = 0; i < OUT_HASHES; i++) {
+                if (!(show & out_hashes[i].show)) continue;
+                if (escaped) out_char(o, '\\');
+                out_str(o, out_hashes[i].tag);
+                out_str(o, " (");
+                out_path(o, path, escaped);
+                out_str(o, ") = ");
+                out_digest(o, d, out_hashes[i].show, 0);
+                out_char(o, '\n');
+            }
+            break;
+        case FORMAT_BINARY:
+            if (err) return;
+            for (size_t i = 0; i < OUT_HASHES; i++)
+                if (show & out_hashes[i].show) out_digest(o, d, out_hashes[i].show, 1);
+            out_bytes(o, path, strlen(path) + 1);
+            break;
+    }
+}
+
+/* A single file that cannot be opened: on stderr, and as its record in JSON / CSV like hash_many */
+static int out_open_error(const char *path, unsigned show, int err) {
+    fprintf(stderr, "crc: %s: %s\n", path, strerror(err));
+    if (out_format != FORMAT_TEXT) {
+        char buf[4096];
+        struct out_buf o = { STDOUT_FILENO, 0, buf, 0, sizeof(buf) };
+        struct hash_digest d = { 0 };
+        fflush(stdout);
+        out_header(&o, show);
+        out_record(&o, &d, show, path, 0, err);
+        out_flush(&o);
+    }
+    return EXIT_FAILURE;
+}
+
+/* ================= MULTI-FILE SCHEDULER ================= */
+/*
+    Many paths and -r. The file list is collected first (openat +
+    getdents64, names sorted per directory so the order never depends on
+    the filesystem), then a pool of workers hashes it. Every worker owns a
+    deque: it pops its own tasks from the back and steals from the front of
+    the others when it runs dry.
+
+    A file task hashes a file whole. Files of SPLIT_MIN bytes or more are
+    split instead: the CRCs are cut into SPLIT_CHUNK pieces that are pushed
+    as their own tasks (and stolen by idle workers) and merged with the
+    combine functions, while the worker that opened the file keeps the
+    xxHash lanes. Those run front to back, a tree of partial xxHashes would
+    no longer match xxhsum. Results are printed in input order as soon as
+    every earlier file is finished.
+
+    --check runs the same pool over the entries of a manifest: each file
+    computes only the hashes its entry names and is compared where it
+    would otherwise be printed.
+
+    Files of up to SMALL_MAX bytes skip the mapping: each worker owns an
+    arena of that size, the file is read into it with one pread() and the
+    kernel runs on it there. For a tree of source files or mail the
+    mmap/madvise/munmap calls cost more than the hashing.
+*/
+#define SMALL_MAX   (64 * 1024)
+#define SPLIT_MIN   ((uint64_t)256 * 1024 * 1024)
+#define SPLIT_CHUNK MMAP_STEP
+#define HASH_CRCS   (HASH_CRC16 | HASH_CRC32 | HASH_CRC64)
+
+struct crc_part {
+    uint16_t crc16;
+    uint32_t crc32;
+    uint64_t crc64;
+};
+
+struct file_entry {
+    char *path;
+    int fd;
+    int err;                /* first errno of any of its tasks, atomic */
+    unsigned mask;          /* HASH_* bits of this file */
+    uint64_t size;
+    uint32_t nparts;
+    struct crc_part *parts;
+    struct hash_digest d;
+    int pending;            /* tasks of this file still running */
+    int done;               /* d (or err) is final */
+};
+
+enum task_kind { TASK_FILE, TASK_CHUNK };
+
+struct task {
+    enum task_kind kind;
+    uint32_t part;
+    size_t file;
+};
+
+struct task_deque {
+    struct task *t;
+    size_t head, tail, cap;
+    pthread_mutex_t lock;
+};
+
+/* --check: the digests a manifest line expects */
+struct check_entry {
+    struct hash_digest d;
+    unsigned show;          /* SHOW_* bits given on the line */
+};
+
+struct scheduler {
+    struct file_entry *files;
+    size_t nfiles;
+    unsigned mask;          /* HASH_* bits to compute */
+    unsigned show;          /* SHOW_* bits to print */
+    const struct check_entry *expect;   /* per file, NULL prints the digests */
+    struct cache *cache;                /* --cache, or NULL */
+    size_t mismatched, unreadable;
+    unsigned map_opts;
+    int workers;
+    struct task_deque *q;
+    long queued;            /* tasks sitting in deques */
+    long remaining;         /* tasks not finished yet */
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle;
+    pthread_mutex_t print_lock;
+    pthread_cond_t printable;   /* files[next_print] is done */
+    size_t next_print;          /* atomic, written by the writer only */
+    struct out_buf out;         /* stdout, the writer's */
+    int failed;
+};
+
+/* ---------- file list ---------- */
+struct path_list {
+    char **v;
+    size_t n, cap;
+};
+
+static void path_push(struct path_list *l, char *path) {
+    if (l->n == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 256;
+        l->v = realloc(l->v, l->cap * sizeof(*l->v));
+        if (!l->v) { perror("realloc"); exit(EXIT_FAILURE); }
+    }
+    l->v[l->n++] = path;
+}
+
+static char *path_join(const char *dir, const char *name) {
+    size_t a = strlen(dir), b = strlen(name);
+    int slash = a && dir[a - 1] != '/';
+    char *p = malloc(a + slash + b + 1);
+    if (!p) { perror("malloc"); exit(EXIT_FAILURE); }
+    memcpy(p, dir, a);
+    if (slash) p[a] = '/';
+    memcpy(p + a + slash, name, b + 1);
+    return p;
+}
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static int cmp_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/*
+    Appends every regular file under the directory dfd (named path) in
+    sorted order. Symlinks are hashed when they point at a regular file but
+    never followed into directories, so loops are impossible.
+*/
+static void walk_dir(int dfd, const char *path, struct path_list *out, int *failed) {
+    struct path_list names = { 0 };
+    const size_t bufsize = 32768;
+    char *buf = malloc(bufsize);   /* heap, the walk recurses once per level */
+    if (!buf) { perror("malloc"); exit(EXIT_FAILURE); }
+
+    for (;;) {
+        long n = syscall(SYS_getdents64, dfd, buf, bufsize);
+        if (n < 0) {
+            fprintf(stderr, "crc: %s: %s\n", path, strerror(errno));
+            *failed = 1;
+            break;
+        }
+        if (n == 0) break;
+        for (long off = 0; off < n;) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(buf + off);
+            off += d->d_reclen;
+            if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, "..")) continue;
+            size_t len = strlen(d->d_name);
+            char *e = malloc(len + 2);
+            if (!e) { perror("malloc"); exit(EXIT_FAILURE); }
+            e[0] = (char)d->d_type;    /* type byte, then the name */
+            memcpy(e + 1, d->d_name, len + 1);
+            path_push(&names, e);
+        }
+    }
+    free(buf);
+
+    for (size_t i = 0; i < names.n; i++) names.v[i]++;
+    qsort(names.v, names.n, sizeof(*names.v), cmp_names);
+
+    for (size_t i = 0; i < names.n; i++) {
+        const char *name = names.v[i];
+        unsigned char type = (unsigned char)name[-1];
+        struct stat st;
+
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            if (fstatat(dfd, name, &st, 0) < 0) {
+                if (type == DT_UNKNOWN) {
+                    fprintf(stderr, "crc: %s/%s: %s\n", path, name, strerror(errno));
+                    *failed = 1;
+                }
+                continue;  /* dangling symlinks are skipped */
+            }
+            if (S_ISREG(st.st_mode)) type = DT_REG;
+            else if (S_ISDIR(st.st_mode) && type == DT_UNKNOWN) type = DT_DIR;
+            else type = DT_UNKNOWN;
+        }
+
+        if (type == DT_REG) {
+            path_push(out, path_join(path, name));
+        } else if (type == DT_DIR) {
+            char *sub = path_join(path, name);
+            int fd = openat(dfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd < 0) {
+                fprintf(stderr, "crc: %s: %s\n", sub, strerror(errno));
+                *failed = 1;
+            } else {
+                walk_dir(fd, sub, out, failed);
+                close(fd);
+            }
+            free(sub);
+        }
+    }
+
+    for (size_t i = 0; i < names.n; i++) free(names.v[i] - 1);
+    free(names.v);
+}
+
+/* ---------- deques ---------- */
+static void deque_push(struct task_deque *q, struct task t) {
+    pthread_mutex_lock(&q->lock);
+    if (q->tail == q->cap) {
+        if (q->head) {
+            memmove(q->t, q->t + q->head, (q->tail - q->head) * sizeof(*q->t));
+            q->tail -= q->head;
+            q->head = 0;
+        } else {
+            q->cap = q->cap ? q->cap * 2 : 64;
+            q->t = realloc(q->t, q->cap * sizeof(*q->t));
+            if (!q->t) { perror("realloc"); exit(EXIT_FAILURE); }
+        }
+    }
+    q->t[q->tail++] = t;
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* Owner end (back) or thief end (front), 0 when empty */
+static int deque_take(struct task_deque *q, struct task *t, int steal) {
+    int ok = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+        *t = steal ? q->t[q->head++] : q->t[--q->tail];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+static void sched_push(struct scheduler *s, int worker, struct task t) {
+    __atomic_add_fetch(&s->remaining, 1, __ATOMIC_SEQ_CST);
+    deque_push(&s->q[worker], t);
+    __atomic_add_fetch(&s->queued, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&s->idle_lock);
+    pthread_cond_broadcast(&s->idle);
+    pthread_mutex_unlock(&s->idle_lock);
+}
+
+static int sched_next(struct scheduler *s, int worker, struct task *t) {
+    for (;;) {
+        if (deque_take(&s->q[worker], t, 0)) goto got;
+        for (int i = 1; i < s->workers; i++)
+            if (deque_take(&s->q[(worker + i) % s->workers], t, 1)) goto got;
+
+        pthread_mutex_lock(&s->idle_lock);
+        while (!__atomic_load_n(&s->queued, __ATOMIC_SEQ_CST) && __atomic_load_n(&s->remaining, __ATOMIC_SEQ_CST))
+            pthread_cond_wait(&s->idle, &s->idle_lock);
+        int finished = !__atomic_load_n(&s->remaining, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&s->idle_lock);
+        if (finished) return 0;
+    }
+got:
+    __atomic_sub_fetch(&s->queued, 1, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+static void sched_task_done(struct scheduler *s) {
+    if (__atomic_sub_fetch(&s->remaining, 1, __ATOMIC_SEQ_CST) == 0) {
+        pthread_mutex_lock(&s->idle_lock);
+        pthread_cond_broadcast(&s->idle);
+        pthread_mutex_unlock(&s->idle_lock);
+    }
+}
+
+/* ---------- output ---------- */
+static unsigned show_mask(unsigned show) {
+    return (show & SHOW_CRC16 ? HASH_CRC16 : 0) | (show & SHOW_CRC32 ? HASH_CRC32 : 0) |
+           (show & SHOW_CRC64 ? HASH_CRC64 : 0) | (show & SHOW_XXH64 ? HASH_XXH64 : 0) |
+           (show & (SHOW_XXH3 | SHOW_XXH128) ? HASH_XXH3 : 0);
+}
+
+static int digest_matches(const struct hash_digest *a, const struct hash_digest *b, unsigned show) {
+    return (!(show & SHOW_CRC16) || a->crc16 == b->crc16) &&
+           (!(show & SHOW_CRC32) || a->crc32 == b->crc32) &&
+           (!(show & SHOW_CRC64) || a->crc64 == b->crc64) &&
+           (!(show & SHOW_XXH64) || a->xxh64 == b->xxh64) &&
+           (!(show & SHOW_XXH3) || a->xxh3 == b->xxh3) &&
+           (!(show & SHOW_XXH128) || (a->xxh128.lo == b->xxh128.lo && a->xxh128.hi == b->xxh128.hi));
+}
+
+/* One finished file: its record, or in --check mode only a failure, sha256sum -c style */
+static void sched_print(struct scheduler *s, size_t i) {
+    const struct check_entry *want = s->expect ? &s->expect[i] : NULL;
+    struct file_entry *f = &s->files[i];
+    int err = __atomic_load_n(&f->err, __ATOMIC_RELAXED);
+    if (err) {
+        out_flush(&s->out);   /* keep stdout and stderr in order on a terminal */
+        fprintf(stderr, "crc: %s: %s\n", f->path, strerror(err));
+        if (want) {
+            out_str(&s->out, f->path);
+            out_str(&s->out, ": FAILED open or read\n");
+        } else {
+            out_record(&s->out, &f->d, s->show, f->path, f->size, err);
+        }
+        s->unreadable++;
+        s->failed = 1;
+    } else if (!want) {
+        out_record(&s->out, &f->d, s->show, f->path, f->size, 0);
+    } else if (!digest_matches(&f->d, &want->d, want->show)) {
+        out_str(&s->out, f->path);
+        out_str(&s->out, ": FAILED\n");
+        s->mismatched++;
+        s->failed = 1;
+    }
+    free(f->path);
+    f->path = NULL;
+}
+
+/*
+    The only thread that writes stdout: prints the files in input order
+    as they finish, into the batched buffer. It flushes when it has to
+    wait for the next file, as the workers are the bottleneck then, and
+    sleeps until file_task_done() wakes it for exactly that file.
+*/
+static void *sched_writer(void *arg) {
+    struct scheduler *s = arg;
+    if (!s->expect) out_header(&s->out, s->show);
+    for (size_t i = 0; i < s->nfiles; i++) {
+        if (!__atomic_load_n(&s->files[i].done, __ATOMIC_SEQ_CST)) {
+            uint64_t t0 = stats_clock();
+            out_flush(&s->out);
+            stats_stage(STAGE_OUTPUT, t0);
+            pthread_mutex_lock(&s->print_lock);
+            while (!__atomic_load_n(&s->files[i].done, __ATOMIC_SEQ_CST))
+                pthread_cond_wait(&s->printable, &s->print_lock);
+            pthread_mutex_unlock(&s->print_lock);
+        }
+        uint64_t t0 = stats_clock();
+        sched_print(s, i);
+        stats_stage(STAGE_OUTPUT, t0);
+        __atomic_store_n(&s->next_print, i + 1, __ATOMIC_SEQ_CST);
+    }
+    out_flush(&s->out);
+    return NULL;
+}
+
+/* ---------- hashing ---------- */
+/* Chunks of a split file fail concurrently: the first error is the one reported */
+static void file_error(struct file_entry *f, int err) {
+    int none = 0;
+    __atomic_compare_exchange_n(&f->err, &none, err, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/* Last task of a file: merge the CRC pieces, close it and let it print */
+static void file_task_done(struct scheduler *s, struct file_entry *f) {
+    if (__atomic_sub_fetch(&f->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (f->parts) {
+            uint64_t t0 = stats_clock();
+            struct crc_part acc = f->parts[0];
+            for (uint32_t i = 1; i < f->nparts; i++) {
+                uint64_t len = i == f->nparts - 1 ? f->size - (uint64_t)i * SPLIT_CHUNK : SPLIT_CHUNK;
+                acc.crc16 = crc16_combine(acc.crc16, f->parts[i].crc16, len);
+                acc.crc32 = crc32_combine(acc.crc32, f->parts[i].crc32, len);
+                acc.crc64 = crc64_combine(acc.crc64, f->parts[i].crc64, len);
+            }
+            f->d.crc16 = acc.crc16;
+            f->d.crc32 = acc.crc32;
+            f->d.crc64 = acc.crc64;
+            stats_stage(STAGE_COMBINE, t0);
+            free(f->parts);
+            f->parts = NULL;
+        }
+        if (s->cache && !__atomic_load_n(&f->err, __ATOMIC_RELAXED)) cache_store(s->cache, (size_t)(f - s->files), f->mask, &f->d);
+        if (f->fd > STDIN_FILENO) close(f->fd);
+
+        /* seq_cst on both sides: the writer sees done, or this sees it waiting on f */
+        __atomic_store_n(&f->done, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&s->next_print, __ATOMIC_SEQ_CST) == (size_t)(f - s->files)) {
+            pthread_mutex_lock(&s->print_lock);
+            pthread_cond_signal(&s->printable);
+            pthread_mutex_unlock(&s->print_lock);
+        }
+    }
+    sched_task_done(s);
+}
+
+static void run_chunk_task(struct scheduler *s, struct file_entry *f, uint32_t part) {
+    uint64_t off = (uint64_t)part * SPLIT_CHUNK;
+    size_t len = f->size - off < SPLIT_CHUNK ? (size_t)(f->size - off) : SPLIT_CHUNK;
+    struct crc_part *c = &f->parts[part];
+
+    /* all hole: the CRCs of len zero bytes, nothing to map */
+    if (next_data(f->fd, off, off + len) == off + len) {
+        uint64_t t0 = stats_clock();
+        c->crc16 = crc16_shift(0xFFFF, len);
+        c->crc32 = crc32_shift(0xFFFFFFFF, len) ^ 0xFFFFFFFF;
+        c->crc64 = crc64_shift(0, len);
+        stats_stage(STAGE_HASH, t0);
+        stats_holes(f->mask & HASH_CRCS, len);
+        file_task_done(s, f);
+        return;
+    }
+
+    uint8_t *p = map_range(f->fd, off, len, s->map_opts);
+    if (!p) {
+        file_error(f, errno);
+    } else {
+        uint64_t t0 = stats_clock();
+        if (f->mask & HASH_CRC16) c->crc16 = crc16_hash(0xFFFF, p, len);
+        if (f->mask & HASH_CRC32) c->crc32 = crc32_hash(0xFFFFFFFF, p, len) ^ 0xFFFFFFFF;
+        if (f->mask & HASH_CRC64) c->crc64 = crc64_hash(0, p, len);
+        stats_hashed(f->mask & HASH_CRCS, len, len, t0);
+        t0 = stats_clock();
+        munmap(p, len);
+        stats_stage(STAGE_MAP, t0);
+    }
+    file_task_done(s, f);
+}
+
+static void run_file_task(struct scheduler *s, int worker, uint8_t *arena, struct file_entry *f) {
+    struct hash_state h;
+    struct stat st;
+    unsigned mask = f->mask;
+
+    f->pending = 1;
+    int from_stdin = !strcmp(f->path, "-");
+    if (s->cache && !from_stdin && cache_lookup(s->cache, f->path, mask, &f->d, &f->size)) {
+        file_task_done(s, f);
+        return;
+    }
+    uint64_t t0 = stats_clock();
+    f->fd = from_stdin ? STDIN_FILENO : open(f->path, O_RDONLY | O_CLOEXEC);
+    if (f->fd < 0 || fstat(f->fd, &st) < 0) {
+        file_error(f, errno);
+        file_task_done(s, f);
+        return;
+    }
+    stats_stage(STAGE_OPEN, t0);
+
+    int regular = S_ISREG(st.st_mode) && !from_stdin;
+    f->size = regular ? (uint64_t)st.st_size : 0;
+    if (s->cache && regular) cache_note(s->cache, (size_t)(f - s->files), &st);
+
+    /* --gpu: the CRCs on the device and the xxHashes here, in one read */
+    if (regular && f->size >= gpu_min && (mask & HASH_CRCS)) {
+        hash_init(&h, mask & ~HASH_CRCS);
+        int err = gpu_hash_file(f->fd, f->size, mask & HASH_CRCS, &h);
+        if (err >= 0) {
+            if (err) file_error(f, err);
+            hash_final(&h, &f->d);
+            file_task_done(s, f);
+            return;
+        }
+    }
+
+    /* Big file: CRC pieces go to the deque for anyone to take */
+    if (regular && f->size >= SPLIT_MIN && (mask & HASH_CRCS) && s->workers > 1) {
+        f->nparts = (uint32_t)((f->size + SPLIT_CHUNK - 1) / SPLIT_CHUNK);
+        f->parts = calloc(f->nparts, sizeof(*f->parts));
+        if (f->parts) {
+            __atomic_add_fetch(&f->pending, (int)f->nparts, __ATOMIC_ACQ_REL);
+            for (uint32_t i = f->nparts; i-- > 0;)
+                sched_push(s, worker, (struct task){ TASK_CHUNK, i, (size_t)(f - s->files) });
+            mask &= ~HASH_CRCS;
+        }
+    }
+
+    int err = 0;
+    hash_init(&h, mask);
+    if (mask) {
+        if (regular && f->size <= SMALL_MAX && arena) {
+            ssize_t n = pread_full(f->fd, arena, (size_t)f->size, 0);
+            if (n < 0) {
+                err = errno;
+            } else if (n) {
+                t0 = stats_clock();
+                hash_update(&h, arena, (size_t)n);
+                stats_hashed(mask, (uint64_t)n, (size_t)n, t0);
+            }
+        } else if (regular && f->size) {
+            struct sp_window_ctx c = { &h };
+            err = map_windows(f->fd, f->size, s->map_opts, sp_window, &c);
+        } else if (!regular) {
+            err = hash_stream(f->fd, &h, &f->size);
+        }
+    }
+
+    if (err) file_error(f, err);
+    struct hash_digest d;
+    hash_final(&h, &d);
+    if (f->parts) {
+        /* the CRCs are filled in when the last piece lands */
+        f->d.xxh64 = d.xxh64;
+        f->d.xxh3 = d.xxh3;
+        f->d.xxh128 = d.xxh128;
+    } else {
+        f->d = d;
+    }
+    file_task_done(s, f);
+}
+
+struct worker_arg {
+    struct scheduler *s;
+    int id;
+    pthread_t tid;
+};
+
+static void *sched_worker(void *arg) {
+    struct worker_arg *w = arg;
+    struct task t;
+    uint8_t *arena = NULL;
+
+    /* without an arena small files just take the mmap path */
+    if (posix_memalign((void **)&arena, STREAM_ALIGN, SMALL_MAX)) arena = NULL;
+    while (sched_next(w->s, w->id, &t)) {
+        struct file_entry *f = &w->s->files[t.file];
+        if (t.kind == TASK_FILE) run_file_task(w->s, w->id, arena, f);
+        else run_chunk_task(w->s, f, t.part);
+    }
+    free(arena);
+    return NULL;
+}
+
+/*
+    Runs the pool over list (mask, show, map_opts, workers, expect and
+    cache set by the caller) and frees the paths. Returns whether anything
+    failed.
+*/
+static int sched_run(struct scheduler *s, struct path_list *list) {
+    s->nfiles = list->n;
+    s->files = calloc(list->n ? list->n : 1, sizeof(*s->files));
+    s->workers = s->workers < 1 ? 1 : s->workers;
+    s->q = calloc((size_t)s->workers, sizeof(*s->q));
+    if (!s->files || !s->q) { perror("calloc"); exit(EXIT_FAILURE); }
+    if (s->cache) {
+        s->cache->nslots = list->n;
+        s->cache->slots = calloc(list->n ? list->n : 1, sizeof(*s->cache->slots));
+        if (!s->cache->slots) { perror("calloc"); exit(EXIT_FAILURE); }
+    }
+
+    pthread_mutex_init(&s->idle_lock, NULL);
+    pthread_cond_init(&s->idle, NULL);
+    pthread_mutex_init(&s->print_lock, NULL);
+    pthread_cond_init(&s->printable, NULL);
+    for (int i = 0; i < s->workers; i++) pthread_mutex_init(&s->q[i].lock, NULL);
+
+    s->out = (struct out_buf){ STDOUT_FILENO, 0, malloc(OUT_BUF_SIZE), 0, OUT_BUF_SIZE };
+    if (!s->out.p) { perror("malloc"); exit(EXIT_FAILURE); }
+    fflush(stdout);
+
+    /* Deal the files out round-robin, in reverse so each worker pops them in order */
+    for (size_t i = 0; i < list->n; i++) {
+        s->files[i].path = list->v[i];
+        s->files[i].fd = -1;
+        s->files[i].mask = s->expect ? show_mask(s->expect[i].show) : s->mask;
+    }
+    for (size_t i = list->n; i-- > 0;)
+        sched_push(s, (int)(i % (size_t)s->workers), (struct task){ TASK_FILE, 0, i });
+    free(list->v);
+
+    /* If a thread cannot be created its deque is simply emptied by stealing */
+    struct worker_arg *w = calloc((size_t)s->workers, sizeof(*w));
+    int spawned = 1;
+    if (!w) { perror("calloc"); exit(EXIT_FAILURE); }
+    for (int i = 0; i < s->workers; i++) {
+        w[i].s = s;
+        w[i].id = i;
+    }
+    pthread_t writer;
+    int own_writer = pthread_create(&writer, NULL, sched_writer, s) == 0;
+    for (; spawned < s->workers; spawned++)
+        if (pthread_create(&w[spawned].tid, NULL, sched_worker, &w[spawned])) break;
+    sched_worker(&w[0]);
+    for (int i = 1; i < spawned; i++) pthread_join(w[i].tid, NULL);
+    if (own_writer) pthread_join(writer, NULL);
+    else sched_writer(s);   /* everything is done, it prints without waiting */
+    if (s->out.err) {
+        fprintf(stderr, "crc: write error: %s\n", strerror(s->out.err));
+        s->failed = 1;
+    }
+    free(s->out.p);
+    if (s->cache) cache_commit(s->cache);
+
+    for (int i = 0; i < s->workers; i++) {
+        pthread_mutex_destroy(&s->q[i].lock);
+        free(s->q[i].t);
+    }
+    free(w);
+    free(s->q);
+    free(s->files);
+    return s->failed;
+}
+
+/*
+    Hashes every path (directories only with recursive) and prints one line
+    per file. Returns the exit status.
+*/
+int hash_many(char **paths, int npaths, int recursive, unsigned mask, unsigned show,
+              int workers, unsigned map_opts, struct cache *cache) {
+    struct path_list list = { 0 };
+    int failed = 0;
+
+    for (int i = 0; i < npaths; i++) {
+        struct stat st;
+        if (strcmp(paths[i], "-") && stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+            if (!recursive) {
+                fprintf(stderr, "crc: %s: Is a directory (use -r)\n", paths[i]);
+                failed = 1;
+                continue;
+            }
+            int fd = open(paths[i], O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0) {
+                fprintf(stderr, "crc: %s: %s\n", paths[i], strerror(errno));
+                failed = 1;
+                continue;
+            }
+            uint64_t t0 = stats_clock();
+            walk_dir(fd, paths[i], &list, &failed);
+            close(fd);
+            stats_stage(STAGE_OPEN, t0);
+        } else {
+            path_push(&list, strdup(paths[i]));   /* errors show up when it is opened */
+        }
+    }
+
+    struct scheduler s;
+    memset(&s, 0, sizeof(s));
+    s.mask = mask;
+    s.show = show;
+    s.map_opts = map_opts;
+    s.workers = workers;
+    s.cache = cache;
+    return sched_run(&s, &list) || failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* ================= MANIFEST CHECK ================= */
+/*
+    --check verifies files against a manifest, through the scheduler above.
+    Two line formats, which may be mixed:
+
+        <digest>[ <digest> ...]  <path>       GNU (sha256sum), " *<path>" too
+        <TAG> (<path>) = <digest>             BSD tagged (sha256sum --tag)
+
+    GNU lines hold the digests of the hashes picked on the command line
+    (CRC-32 by default) in the order crc prints them, so the output of
+    "crc -r [hashes] dir" is a manifest for "crc --check [hashes]". Tagged
+    lines name their own hash: CRC16, CRC32 (or CRC32C), CRC64, XXH64, XXH3
+    or XXH128. A line starting with a backslash has "\\" and "\n" escapes
+    in its path, as sha256sum writes them. Blank and '#' lines are skipped.
+*/
+static const struct {
+    const char *tag;
+    unsigned show;
+} check_tags[] = {
+    { "CRC16", SHOW_CRC16 }, { "CRC32", SHOW_CRC32 }, { "CRC32C", SHOW_CRC32 },
+    { "CRC64", SHOW_CRC64 }, { "XXH64", SHOW_XXH64 }, { "XXH3", SHOW_XXH3 },
+    { "XXH128", SHOW_XXH128 },
+};
+
+static int show_digits(unsigned bit) {
+    return bit == SHOW_CRC16 ? 4 : bit == SHOW_CRC32 ? 8 : bit == SHOW_XXH128 ? 32 : 16;
+}
+
+/* n hex digits at p (either case) as a number of up to 64 bits, 0 if one is not hex */
+static int parse_hex(const char *p, int n, uint64_t *v) {
+    *v = 0;
+    for (int i = 0; i < n; i++) {
+        int c = (unsigned char)p[i], x;
+        if (c >= '0' && c <= '9') x = c - '0';
+        else if (c >= 'a' && c <= 'f') x = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') x = c - 'A' + 10;
+        else return 0;
+        *v = *v << 4 | (uint64_t)x;
+    }
+    return 1;
+}
+
+/* The digest of one SHOW_* hash at p, 0 if it is not exactly that long */
+static int parse_digest(const char *p, unsigned bit, struct hash_digest *d) {
+    int n = show_digits(bit);
+    uint64_t v, lo = 0;
+    if (!parse_hex(p, n > 16 ? 16 : n, &v)) return 0;
+    if (n > 16 && !parse_hex(p + 16, 16, &lo)) return 0;
+    switch (bit) {
+        case SHOW_CRC16:  d->crc16 = (uint16_t)v; break;
+        case SHOW_CRC32:  d->crc32 = (uint32_t)v; break;
+        case SHOW_CRC64:  d->crc64 = v; break;
+        case SHOW_XXH64:  d->xxh64 = v; break;
+        case SHOW_XXH3:   d->xxh3 = v; break;
+        case SHOW_XXH128: d->xxh128.hi = v; d->xxh128.lo = lo; break;
+    }
+    return 1;
+}
+
+/* Undoes the sha256sum path escapes in place */
+static void unescape_path(char *p) {
+    char *o = p;
+    for (; *p; p++) {
+        if (*p == '\\' && (p[1] == '\\' || p[1] == 'n')) {
+            *o++ = p[1] == 'n' ? '\n' : '\\';
+            p++;
+        } else {
+            *o++ = *p;
+        }
+    }
+    *o = '\0';
+}
+
+/* Fills e and points path into line, 0 if the line is malformed */
+static int parse_check_line(char *line, unsigned show, struct check_entry *e, char **path) {
+    int escaped = line[0] == '\\';
+    char *p = line + escaped;
+
+    memset(e, 0, sizeof(*e));
+
+    /* BSD: TAG (path) = digest, the path may hold ") = " itself */
+    char *open = strstr(p, " (");
+    char *eq = NULL;
+    for (char *q = open ? strstr(open, ") = ") : NULL; q; q = strstr(q + 1, ") = ")) eq = q;
+    if (open && eq) {
+        for (size_t i = 0; i < sizeof(check_tags) / sizeof(check_tags[0]); i++) {
+            if ((size_t)(open - p) != strlen(check_tags[i].tag) || strncmp(p, check_tags[i].tag, (size_t)(open - p)))
+                continue;
+            unsigned bit = check_tags[i].show;
+            if (strlen(eq + 4) != (size_t)show_digits(bit) || !parse_digest(eq + 4, bit, &e->d)) return 0;
+            e->show = bit;
+            *eq = '\0';
+            *path = open + 2;
+            if (escaped) unescape_path(*path);
+            return **path != '\0';
+        }
+    }
+
+    /* GNU: the digests in SHOW_* order, then two spaces or " *" */
+    for (unsigned bit = SHOW_CRC16; bit <= SHOW_XXH128; bit <<= 1) {
+        if (!(show & bit)) continue;
+        if (!parse_digest(p, bit, &e->d)) return 0;
+        p += show_digits(bit);
+        e->show |= bit;
+        if (e->show != show && *p++ != ' ') return 0;
+    }
+    if (p[0] != ' ' || (p[1] != ' ' && p[1] != '*') || !p[2]) return 0;
+    *path = p + 2;
+    if (escaped) unescape_path(*path);
+    return 1;
+}
+
+/*
+    Verifies every file of the manifest ("-" is stdin) and prints only the
+    failures. show holds the hashes of the GNU lines. Returns the exit
+    status: failure on a mismatch, an unreadable file or a malformed line.
+*/
+int check_manifest(const char *manifest, unsigned show, int workers, unsigned map_opts, struct cache *cache) {
+    FILE *in = strcmp(manifest, "-") ? fopen(manifest, "r") : stdin;
+    if (!in) {
+        fprintf(stderr, "crc: %s: %s\n", manifest, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    struct path_list list = { 0 };
+    struct check_entry *want = NULL;
+    size_t want_cap = 0, bad = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    unsigned lineno = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &line_cap, in)) >= 0) {
+        lineno++;
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (!len || line[0] == '#') continue;
+
+        struct check_entry e;
+        char *path;
+        if (!parse_check_line(line, show, &e, &path)) {
+            fprintf(stderr, "crc: %s:%u: improperly formatted checksum line\n", manifest, lineno);
+            bad++;
+            continue;
+        }
+        char *copy = strdup(path);
+        if (!copy) { perror("strdup"); exit(EXIT_FAILURE); }
+        path_push(&list, copy);
+        if (list.n > want_cap) {
+            want_cap = list.cap;
+            want = realloc(want, want_cap * sizeof(*want));
+            if (!want) { perror("realloc"); exit(EXIT_FAILURE); }
+        }
+        want[list.n - 1] = e;
+    }
+    if (ferror(in)) {
+        fprintf(stderr, "crc: %s: %s\n", manifest, strerror(errno));
+        bad++;
+    }
+    free(line);
+    if (in != stdin) fclose(in);
+
+    if (!list.n) {
+        fprintf(stderr, "crc: %s: no properly formatted checksum lines found\n", manifest);
+        free(list.v);
+        return EXIT_FAILURE;
+    }
+
+    struct scheduler s;
+    memset(&s, 0, sizeof(s));
+    s.expect = want;
+    s.map_opts = map_opts;
+    s.workers = workers;
+    s.cache = cache;
+    int failed = sched_run(&s, &list);
+    free(want);
+
+    fflush(stdout);
+    if (s.mismatched)
+        fprintf(stderr, "crc: WARNING: %zu computed checksum%s did NOT match\n", s.mismatched, s.mismatched > 1 ? "s" : "");
+    if (s.unreadable)
+        fprintf(stderr, "crc: WARNING: %zu listed file%s could not be read\n", s.unreadable, s.unreadable > 1 ? "s" : "");
+    if (bad)
+        fprintf(stderr, "crc: WARNING: %zu line%s improperly formatted\n", bad, bad > 1 ? "s are" : " is");
+    return failed || bad ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* ================= BENCHMARK ================= */
+/*
+    -b times every hash on data held in RAM, so the numbers describe the
+    kernels and not the disk: buffers of the --bench-size sizes, or the
+    mapped pages of a file once the warmup has pulled them in. Each case is
+    warmed up first, then timed for --reps repetitions with CLOCK_MONOTONIC
+    and the TSC. A repetition loops the hash until it lasts BENCH_MIN_REP, so
+    64-byte buffers are not lost in timer resolution. The table shows the
+    median and the 99th percentile (the slow tail) of the repetitions and TSC
+    cycles per byte at the median. TSC cycles are reference cycles: they only
+    equal core cycles when the clock does not boost.
+
+    Every case's digest is checked against one hash_state pass over the same
+    buffer; a mismatch is reported and makes the exit status 1.
+
+    --all-impls times every kernel of every hash this CPU can run instead of
+    the dispatched ones, and picks a winner per hash over all sizes: the
+    fastest at the largest size, plus the fastest at the smallest size for
+    the sizes where it beats that one. --save-profile stores the winners as
+    the libcrc tuning profile.
+
+    With --cold and a file, each repetition first drops the file from the
+    page cache (POSIX_FADV_DONTNEED) and then hashes it through the mmap
+    windows, so the storage is part of what is measured.
+*/
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_IMPLS 8
+#define BENCH_MAX_REPS  1000
+#define BENCH_REPS      15
+#define BENCH_WARMUP    2
+#define BENCH_MIN_REP   0.005     /* seconds */
+
+struct bench_opts {
+    int reps, warmup, cold, threads, all_impls;
+    int sweep, numa_cpu, numa_mem;      /* --numa nodes, -1 when not given */
+    int nsizes;
+    uint64_t sizes[BENCH_MAX_SIZES];
+};
+
+/* Median MB/s of every kernel at every size, for the --all-impls winners */
+static double bench_mbps[BENCH_MAX_SIZES][ALGO_COUNT][BENCH_MAX_IMPLS];
+
+#define B_XXH128 ALGO_COUNT         /* bench_case.algo beyond the libcrc ones */
+#define B_ALL    (ALGO_COUNT + 1)
+
+typedef uint64_t (*bench_fn)(const uint8_t *p, size_t len, const void *arg);
+
+struct bench_case {
+    const char *name;
+    bench_fn fn;
+    int algo;               /* enum hash_algo, B_XXH128 or B_ALL */
+    unsigned mask;          /* hash_state mask for the cold runs */
+};
+
+static uint64_t bench_crc16(const uint8_t *p, size_t len, const void *arg) {
+    (void)arg;
+    return crc16_hash(0xFFFF, p, len);
+}
+
+static uint64_t bench_crc32(const uint8_t *p, size_t len, const void *arg) {
+    (void)arg;
+    return crc32_hash(0xFFFFFFFF, p, len) ^ 0xFFFFFFFF;
+}
+
+static uint64_t bench_crc32_mt(const uint8_t *p, size_t len, const void *arg) {
+    return crc32_parallel(p, len, *(const int *)arg);
+}
+
+static uint64_t bench_crc64(const uint8_t *p, size_t len, const void *arg) {
+    (void)arg;
+    return crc64_hash(0, p, len);
+}
+
+static uint64_t bench_xxh64(const uint8_t *p, size_t len, const void *arg) {
+    (void)arg;
+    return xxh64(p, len, 0);
+}
+
+static uint64_t bench_xxh3(const uint8_t *p, size_t len, const void *arg) {
+    (void)arg;
+    return xxh3_64(p, len);
+}
+
+static uint64_t bench_xxh128(const uint8_t *p, size_t len, const void *arg) {
+    (void)arg;
+    return xxh3_128(p, len).lo;
+}
+
+/* every hash in one pass */
+static uint64_t bench_all(const uint8_t *p, size_t len, const void *arg) {
+    struct hash_state h;
+    struct hash_digest d;
+    (void)arg;
+    hash_init(&h, HASH_ALL);
+    hash_update(&h, p, len);
+    hash_final(&h, &d);
+    return d.crc16 ^ d.crc32 ^ d.crc64 ^ d.xxh64 ^ d.xxh128.lo ^ d.xxh128.hi;
+}
+
+/* one kernel of --all-impls, arg is its struct hash_impl */
+static uint64_t bench_impl(const uint8_t *p, size_t len, const void *arg) {
+    return impl_hash(arg, p, len);
+}
+
+static const struct bench_case bench_cases[] = {
+    { "CRC-16",    bench_crc16,    ALGO_CRC16, HASH_CRC16 },
+    { "CRC-32",    bench_crc32,    ALGO_CRC32, HASH_CRC32 },
+    { "CRC-32 MT", bench_crc32_mt, ALGO_CRC32, 0 },
+    { "CRC-64",    bench_crc64,    ALGO_CRC64, HASH_CRC64 },
+    { "xxH64",     bench_xxh64,    ALGO_XXH64, HASH_XXH64 },
+    { "xxH3",      bench_xxh3,     ALGO_XXH3,  HASH_XXH3 },
+    { "xxH128",    bench_xxh128,   B_XXH128,   0 },
+    { "All (-s)",  bench_all,      B_ALL,      HASH_ALL },
+};
+#define BENCH_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+/* bench_cases[] name of each enum hash_algo */
+static const char *const bench_algo_names[ALGO_COUNT] = { "CRC-16", "CRC-32", "CRC-64", "xxH64", "xxH3" };
+
+static inline uint64_t bench_tsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of a sorted array */
+static double percentile(const double *v, int n, double pct) {
+    int i = (int)(pct / 100.0 * n + 0.999999) - 1;
+    return v[i < 0 ? 0 : i >= n ? n - 1 : i];
+}
+
+static uint64_t bench_expected(const struct hash_digest *d, int algo) {
+    switch (algo) {
+        case ALGO_CRC16: return d->crc16;
+        case ALGO_CRC32: return d->crc32;
+        case ALGO_CRC64: return d->crc64;
+        case ALGO_XXH64: return d->xxh64;
+        case ALGO_XXH3:  return d->xxh3;
+        case B_XXH128:   return d->xxh128.lo;
+        default:         return d->crc16 ^ d->crc32 ^ d->crc64 ^ d->xxh64 ^ d->xxh128.lo ^ d->xxh128.hi;
+    }
+}
+
+static void bench_print_digest(const struct hash_digest *d, int algo) {
+    switch (algo) {
+        case ALGO_CRC16: printf("%04X", d->crc16); break;
+        case ALGO_CRC32: printf("%08X", d->crc32); break;
+        case ALGO_CRC64: printf("%016llX", (unsigned long long)d->crc64); break;
+        case ALGO_XXH64: printf("%016llX", (unsigned long long)d->xxh64); break;
+        case ALGO_XXH3:  printf("%016llX", (unsigned long long)d->xxh3); break;
+        case B_XXH128:   printf("%016llX%016llX", (unsigned long long)d->xxh128.hi, (unsigned long long)d->xxh128.lo); break;
+        default:         printf("-"); break;
+    }
+}
+
+/* Kernel column: what a call of len bytes dispatches to */
+static const char *bench_kernel(const struct bench_case *bc, size_t len) {
+    const struct hash_impl *impl;
+    if (bc->algo == B_ALL) return "-";
+    impl = current_impl(bc->algo == B_XXH128 ? ALGO_XXH3 : (enum hash_algo)bc->algo, len);
+    return impl ? impl->name : "?";
+}
+
+static void bench_size_label(char *out, size_t n, uint64_t size) {
+    if (size >= (1ULL << 30) && !(size % (1ULL << 30))) snprintf(out, n, "%llu GB", (unsigned long long)(size >> 30));
+    else if (size >= (1ULL << 20) && !(size % (1ULL << 20))) snprintf(out, n, "%llu MB", (unsigned long long)(size >> 20));
+    else if (size >= 1024 && !(size % 1024)) snprintf(out, n, "%llu KB", (unsigned long long)(size >> 10));
+    else snprintf(out, n, "%llu B", (unsigned long long)size);
+}
+
+static void bench_header(const char *what, const struct bench_opts *o) {
+    cprintf(C_RESET "%s " C_GREEN "(" C_RESET "%d reps", what, o->reps);
+    if (o->warmup) printf(", %d warmup", o->warmup);
+    cprintf(C_GREEN ")\n" C_RESET);
+    printf("  %-10s %-8s %12s %12s %12s %8s  %s\n", "Hash", "Kernel", "Median MB/s", "p99 MB/s", "Median", "cyc/B", "Digest");
+}
+
+/* Sorts the repetitions, prints everything up to the digest and returns the median MB/s */
+static double bench_row(const char *name, const char *kernel, size_t len, double *t, double *cyc, int reps) {
+    qsort(t, (size_t)reps, sizeof(*t), cmp_double);
+    qsort(cyc, (size_t)reps, sizeof(*cyc), cmp_double);
+    double med = percentile(t, reps, 50), p99 = percentile(t, reps, 99);
+    double mb = len / (1024.0 * 1024.0);
+    const char *unit = "s";
+    double shown = med;
+    if (med < 1e-3) { shown = med * 1e6; unit = "us"; }
+    else if (med < 1.0) { shown = med * 1e3; unit = "ms"; }
+    cprintf("  " C_GREEN "%-10s " C_RESET "%-8s " C_ORANGE "%12.2f %12.2f " C_YELLOW "%9.3f %-2s " C_RESET "%8.3f  ",
+            name, kernel, mb / med, mb / p99, shown, unit, percentile(cyc, reps, 50) / len);
+    stats_bench_row(name, kernel, len, mb / med, percentile(cyc, reps, 50) / len);
+    return mb / med;
+}
+
+/* Warmup and timed repetitions of one case, returns the digest of the first call */
+static uint64_t bench_time(bench_fn fn, const void *arg, const uint8_t *p, size_t len,
+                           const struct bench_opts *o, double *t, double *cyc) {
+    volatile uint64_t sink = 0;
+
+    /* one call to size the repetitions, then the warmup */
+    double t0 = now_seconds();
+    uint64_t v = fn(p, len, arg);
+    double one = now_seconds() - t0;
+    long iters = one >= BENCH_MIN_REP ? 1 : (long)(BENCH_MIN_REP / (one > 1e-9 ? one : 1e-9)) + 1;
+    for (int w = 0; w < o->warmup; w++)
+        for (long i = 0; i < iters; i++) sink ^= fn(p, len, arg);
+
+    stats_perf_begin();
+    for (int r = 0; r < o->reps; r++) {
+        uint64_t c0 = bench_tsc();
+        t0 = now_seconds();
+        for (long i = 0; i < iters; i++) sink ^= fn(p, len, arg);
+        t[r] = (now_seconds() - t0) / iters;
+        cyc[r] = (double)(bench_tsc() - c0) / iters;
+    }
+    stats_perf_end((double)len * iters * o->reps);
+    (void)sink;
+    return v;
+}
+
+static int bench_check(uint64_t v, const struct hash_digest *ref, int algo) {
+    if (v != bench_expected(ref, algo)) {
+        cprintf(C_RED "MISMATCH" C_RESET "\n");
+        return 1;
+    }
+    bench_print_digest(ref, algo);
+    printf("\n");
+    return 0;
+}
+
+/*
+    Warm timing of every case on one buffer, or of every kernel with
+    --all-impls (their speeds go to bench_mbps[slot]). Returns 0, or 1 on a
+    digest mismatch.
+*/
+static int bench_buffer(const uint8_t *p, size_t len, const struct bench_opts *o, int slot) {
+    static double t[BENCH_MAX_REPS], cyc[BENCH_MAX_REPS];
+    struct hash_state h;
+    struct hash_digest ref;
+    int bad = 0;
+
+    hash_init(&h, HASH_ALL);
+    hash_update(&h, p, len);
+    hash_final(&h, &ref);
+
+    if (o->all_impls) {
+        for (int a = 0; a < ALGO_COUNT; a++)
+            for (int i = 0; i < impl_count((enum hash_algo)a) && i < BENCH_MAX_IMPLS; i++) {
+                const struct hash_impl *impl = impl_get((enum hash_algo)a, i);
+                bench_mbps[slot][a][i] = 0;
+                if (!impl_supported(impl)) continue;
+                uint64_t v = bench_time(bench_impl, impl, p, len, o, t, cyc);
+                bench_mbps[slot][a][i] = bench_row(bench_algo_names[a], impl->name, len, t, cyc, o->reps);
+                bad |= bench_check(v, &ref, a);
+            }
+        if (o->threads > 1 && len >= 2 * MT_MIN_CHUNK) {
+            char kernel[16];
+            uint64_t v = bench_time(bench_crc32_mt, &o->threads, p, len, o, t, cyc);
+            snprintf(kernel, sizeof(kernel), "%d thr", o->threads);
+            bench_row("CRC-32 MT", kernel, len, t, cyc, o->reps);
+            bad |= bench_check(v, &ref, ALGO_CRC32);
+        }
+        return bad;
+    }
+
+    for (size_t c = 0; c < BENCH_CASES; c++) {
+        const struct bench_case *bc = &bench_cases[c];
+        if (bc->fn == bench_crc32_mt && (o->threads < 2 || len < 2 * MT_MIN_CHUNK)) continue;
+
+        uint64_t v = bench_time(bc->fn, &o->threads, p, len, o, t, cyc);
+        bench_row(bc->name, bench_kernel(bc, len), len, t, cyc, o->reps);
+        bad |= bench_check(v, &ref, bc->algo);
+    }
+    return bad;
+}
+
+/*
+    Cold timing: drop the file from the page cache, then hash it through the
+    mmap windows. Every rep is checked against an untimed reference pass, so
+    a wrong digest is never reported as a speed. Returns 0, or 1 on an
+    error or a mismatch.
+*/
+static int bench_cold(int fd, uint64_t size, unsigned map_opts, const struct bench_opts *o) {
+    static double t[BENCH_MAX_REPS], cyc[BENCH_MAX_REPS];
+    struct bench_opts cold = *o;
+    struct hash_state h;
+    struct sp_window_ctx w = { &h };
+    struct hash_digest ref;
+    int bad = 0;
+
+    hash_init(&h, HASH_ALL);
+    int err = map_windows(fd, size, map_opts, sp_window, &w);
+    hash_final(&h, &ref);
+    if (err) {
+        cfprintf(stderr, C_RED "mmap: %s\n" C_RESET, strerror(err));
+        return 1;
+    }
+
+    cold.warmup = 0;
+    bench_header("Cold cache, dropped before each rep", &cold);
+    for (size_t c = 0; c < BENCH_CASES; c++) {
+        const struct bench_case *bc = &bench_cases[c];
+        struct hash_digest d;
+        uint64_t want = bench_expected(&ref, bc->algo), v = want;
+        if (!bc->mask) continue;
+
+        stats_perf_begin();
+        for (int r = 0; r < o->reps; r++) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            uint64_t c0 = bench_tsc();
+            double t0 = now_seconds();
+            hash_init(&h, bc->mask);
+            err = map_windows(fd, size, map_opts, sp_window, &w);
+            hash_final(&h, &d);
+            t[r] = now_seconds() - t0;
+            cyc[r] = (double)(bench_tsc() - c0);
+            if (err) {
+                cfprintf(stderr, C_RED "mmap: %s\n" C_RESET, strerror(err));
+                return 1;
+            }
+            if (v == want) v = bench_expected(&d, bc->algo);   /* the first bad rep is kept */
+        }
+        stats_perf_end((double)size * o->reps);
+        bench_row(bc->name, bench_kernel(bc, SP_BLOCK), (size_t)size, t, cyc, o->reps);
+        bad |= bench_check(v, &ref, bc->algo);
+    }
+    return bad;
+}
+
+/* xorshift noise, the same for every run */
+static void bench_fill(uint8_t *p, size_t len) {
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (size_t j = 0; j < len; j++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        p[j] = (uint8_t)x;
+    }
+}
+
+/* RAM buffers of every --bench-size */
+static int bench_sizes(const struct bench_opts *o) {
+    int bad = 0;
+    for (int i = 0; i < o->nsizes; i++) {
+        uint64_t size = o->sizes[i];
+        uint8_t *p = NULL;
+        char label[32], what[64];
+
+        bench_size_label(label, sizeof(label), size);
+        if (size > SIZE_MAX || posix_memalign((void **)&p, 64, (size_t)size)) {
+            cfprintf(stderr, C_RED "Cannot allocate a %s buffer\n" C_RESET, label);
+            return 1;
+        }
+        bench_fill(p, (size_t)size);
+
+        snprintf(what, sizeof(what), "Buffer: %s", label);
+        bench_header(what, o);
+        bad |= bench_buffer(p, (size_t)size, o, i);
+        printf("\n");
+        free(p);
+    }
+    return bad;
+}
+
+/*
+    --all-impls winners over the sizes timed, selected in libcrc so that
+    --save-profile can write them: the fastest kernel at the largest size,
+    and the fastest at the smallest size for every size up to the first one
+    where it no longer beats it.
+*/
+static void bench_winners(const uint64_t *sizes, int nsizes) {
+    int order[BENCH_MAX_SIZES];
+
+    for (int i = 0; i < nsizes; i++) order[i] = i;
+    for (int i = 1; i < nsizes; i++)
+        for (int j = i; j > 0 && sizes[order[j]] < sizes[order[j - 1]]; j--) {
+            int tmp = order[j]; order[j] = order[j - 1]; order[j - 1] = tmp;
+        }
+
+    cprintf(C_RESET "Winners " C_GREEN "(" C_RESET "%d sizes" C_GREEN ")\n" C_RESET, nsizes);
+    for (int a = 0; a < ALGO_COUNT; a++) {
+        int n = impl_count((enum hash_algo)a) < BENCH_MAX_IMPLS ? impl_count((enum hash_algo)a) : BENCH_MAX_IMPLS;
+        int lo = order[0], hi = order[nsizes - 1], big = 0, small = 0;
+        uint64_t small_max = 0;
+
+        for (int i = 1; i < n; i++) {
+            if (bench_mbps[hi][a][i] > bench_mbps[hi][a][big]) big = i;
+            if (bench_mbps[lo][a][i] > bench_mbps[lo][a][small]) small = i;
+        }
+        if (small != big)
+            for (int s = 0; s < nsizes && bench_mbps[order[s]][a][small] > bench_mbps[order[s]][a][big]; s++)
+                small_max = sizes[order[s]];
+
+        select_impl(impl_get((enum hash_algo)a, big), 0);
+        cprintf("  " C_GREEN "%-10s " C_ORANGE "%s" C_RESET, bench_algo_names[a], impl_get((enum hash_algo)a, big)->name);
+        if (small_max && !select_impl(impl_get((enum hash_algo)a, small), (size_t)small_max)) {
+            char label[32];
+            bench_size_label(label, sizeof(label), small_max);
+            cprintf(", " C_ORANGE "%s" C_RESET " up to %s", impl_get((enum hash_algo)a, small)->name, label);
+        }
+        printf("\n");
+    }
+}
+
+/* ================= THREAD SWEEP ================= */
+/*
+    --sweep hashes one buffer with 1, 2, 4 ... -j threads and reports GB/s,
+    speedup and parallel efficiency (speedup / threads) for each count. The
+    buffer is cut into one range per thread. CRC ranges are merged with
+    crcN_combine() into the digest of the whole buffer and checked. xxHash
+    has no combine, so its ranges are hashed as independent slices: that is
+    the aggregate rate of the multi-file scheduler, not a faster single
+    digest.
+
+    The workers wait on a barrier between passes, so thread start-up is not
+    timed. Placement on NUMA machines follows --numa CPU[:MEM]: the RAM
+    buffer is first touched, and so placed, by a thread on node MEM and the
+    workers run on node CPU. Without it the workers go to the node that
+    holds their range, like crc32_parallel() does.
+*/
+struct sweep {
+    const uint8_t *buf;
+    size_t len;
+    int threads, algo, quit;
+    uint64_t part[MT_MAX_THREADS];
+    pthread_mutex_t gate;               /* held while the workers are created */
+    pthread_barrier_t start, done;
+};
+
+struct sweep_worker {
+    struct sweep *s;
+    int id;
+    pthread_t tid;
+};
+
+static void sweep_range(struct sweep *s, int id, const uint8_t **p, size_t *n) {
+    size_t chunk = s->len / s->threads & ~(size_t)63;
+    *p = s->buf + (size_t)id * chunk;
+    *n = id == s->threads - 1 ? s->len - (size_t)id * chunk : chunk;
+}
+
+static void sweep_part(struct sweep *s, int id) {
+    const uint8_t *p;
+    size_t n;
+    sweep_range(s, id, &p, &n);
+    switch (s->algo) {
+        case ALGO_CRC16: s->part[id] = crc16_hash(0xFFFF, p, n); break;
+        case ALGO_CRC32: s->part[id] = crc32_hash(0xFFFFFFFF, p, n) ^ 0xFFFFFFFF; break;
+        case ALGO_CRC64: s->part[id] = crc64_hash(0, p, n); break;
+        case ALGO_XXH64: s->part[id] = xxh64(p, n, 0); break;
+        default:         s->part[id] = xxh3_64(p, n); break;
+    }
+}
+
+static void *sweep_thread(void *arg) {
+    struct sweep_worker *w = arg;
+    pthread_mutex_lock(&w->s->gate);
+    pthread_mutex_unlock(&w->s->gate);
+    for (;;) {
+        pthread_barrier_wait(&w->s->start);
+        if (w->s->quit) break;
+        sweep_part(w->s, w->id);
+        pthread_barrier_wait(&w->s->done);
+    }
+    return NULL;
+}
+
+/* One pass over the buffer by every thread (bench_fn, arg is the sweep) */
+static uint64_t sweep_pass(const uint8_t *p, size_t len, const void *arg) {
+    struct sweep *s = (struct sweep *)arg;
+    uint64_t v;
+    (void)p;
+
+    pthread_barrier_wait(&s->start);
+    sweep_part(s, 0);
+    pthread_barrier_wait(&s->done);
+
+    v = s->part[0];
+    for (int t = 1; t < s->threads; t++) {
+        const uint8_t *q;
+        size_t n;
+        sweep_range(s, t, &q, &n);
+        switch (s->algo) {
+            case ALGO_CRC16: v = crc16_combine((uint16_t)v, (uint16_t)s->part[t], n); break;
+            case ALGO_CRC32: v = crc32_combine((uint32_t)v, (uint32_t)s->part[t], n); break;
+            case ALGO_CRC64: v = crc64_combine(v, s->part[t], n); break;
+            default:         v ^= s->part[t]; break;
+        }
+    }
+    (void)len;
+    return v;
+}
+
+/* Node of thread id: --numa CPU, else the node of its range on NUMA machines, else -1 */
+static int sweep_node(struct sweep *s, int id, int cpu_node) {
+    const uint8_t *p;
+    size_t n;
+    if (cpu_node >= 0) return cpu_node;
+    if (numa_nodes() < 2) return -1;
+    sweep_range(s, id, &p, &n);
+    return numa_page_node(p + n / 2);
+}
+
+static int sweep_buffer(const uint8_t *buf, size_t len, const struct bench_opts *o, const char *what) {
+    static double t[BENCH_MAX_REPS], cyc[BENCH_MAX_REPS];
+    struct sweep_worker w[MT_MAX_THREADS];
+    double base[ALGO_COUNT] = { 0 };
+    struct hash_state h;
+    struct hash_digest ref;
+    cpu_set_t saved;
+    int counts[32], ncounts = 0, bad = 0;
+
+    for (int n = 1; n < o->threads && ncounts < 31; n *= 2) counts[ncounts++] = n;
+    counts[ncounts++] = o->threads;
+
+    hash_init(&h, HASH_CRC16 | HASH_CRC32 | HASH_CRC64);
+    hash_update(&h, buf, len);
+    hash_final(&h, &ref);
+
+    int mem_node = numa_page_node(buf);
+    cprintf(C_RESET "Thread sweep: %s " C_GREEN "(" C_RESET "memory on node %d, workers on ", what, mem_node);
+    if (o->numa_cpu >= 0) printf("node %d", o->numa_cpu);
+    else printf(numa_nodes() > 1 ? "the node of their range" : "any CPU");
+    cprintf(", %d reps" C_GREEN ")\n" C_RESET, o->reps);
+    printf("  %-10s %7s %10s %9s %11s  %s\n", "Hash", "Threads", "GB/s", "Speedup", "Efficiency", "Digest");
+
+    pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved);
+    for (int a = 0; a < ALGO_COUNT; a++) {
+        for (int c = 0; c < ncounts; c++) {
+            struct sweep s = { .buf = buf, .len = len, .threads = counts[c], .algo = a };
+            int spawned = 1;
+
+            if ((size_t)s.threads > len / 4096) break;
+            pthread_mutex_init(&s.gate, NULL);
+
+            /* the barriers are sized once the workers exist, the gate holds them until then */
+            pthread_mutex_lock(&s.gate);
+            for (; spawned < s.threads; spawned++) {
+                pthread_attr_t attr;
+                pthread_attr_init(&attr);
+                numa_bind(&attr, sweep_node(&s, spawned, o->numa_cpu));
+                w[spawned].s = &s;
+                w[spawned].id = spawned;
+                int err = pthread_create(&w[spawned].tid, &attr, sweep_thread, &w[spawned]);
+                pthread_attr_destroy(&attr);
+                if (err) break;
+            }
+            pthread_barrier_init(&s.start, NULL, (unsigned)spawned);
+            pthread_barrier_init(&s.done, NULL, (unsigned)spawned);
+            pthread_mutex_unlock(&s.gate);
+
+            if (spawned < s.threads) {
+                cfprintf(stderr, C_RED "Cannot start %d threads\n" C_RESET, s.threads);
+                bad = 1;
+            } else {
+                numa_bind(NULL, sweep_node(&s, 0, o->numa_cpu));
+                uint64_t v = bench_time(sweep_pass, &s, buf, len, o, t, cyc);
+                pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+                qsort(t, (size_t)o->reps, sizeof(*t), cmp_double);
+                double gbs = len / percentile(t, o->reps, 50) / 1e9;
+                if (c == 0) base[a] = gbs;
+                cprintf("  " C_GREEN "%-10s " C_RESET "%7d " C_ORANGE "%10.2f " C_RESET "%8.2fx %10.1f%%  ",
+                        bench_algo_names[a], s.threads, gbs, gbs / base[a], 100.0 * gbs / base[a] / s.threads);
+                if (a >= ALGO_XXH64) printf("(slices)\n");
+                else bad |= bench_check(v, &ref, a);
+            }
+
+            /* the quit round: the workers wake on start and leave */
+            s.quit = 1;
+            pthread_barrier_wait(&s.start);
+            for (int i = 1; i < spawned; i++) pthread_join(w[i].tid, NULL);
+            pthread_barrier_destroy(&s.start);
+            pthread_barrier_destroy(&s.done);
+            pthread_mutex_destroy(&s.gate);
+            if (spawned < s.threads) return bad;
+        }
+    }
+    return bad;
+}
+
+struct first_touch {
+    uint8_t *p;
+    size_t len;
+};
+
+static void *first_touch_thread(void *arg) {
+    struct first_touch *f = arg;
+    bench_fill(f->p, f->len);
+    return NULL;
+}
+
+/* RAM sweep: the largest --bench-size, first touched on the --numa memory node */
+static int sweep_sizes(const struct bench_opts *o) {
+    uint64_t size = 0;
+    char label[32], what[64];
+    int bad;
+
+    for (int i = 0; i < o->nsizes; i++)
+        if (o->sizes[i] > size) size = o->sizes[i];
+    bench_size_label(label, sizeof(label), size);
+
+    uint8_t *p = size <= SIZE_MAX ? mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : MAP_FAILED;
+    if (p == MAP_FAILED) {
+        cfprintf(stderr, C_RED "Cannot allocate a %s buffer\n" C_RESET, label);
+        return 1;
+    }
+
+    struct first_touch f = { p, (size_t)size };
+    pthread_attr_t attr;
+    pthread_t tid;
+    pthread_attr_init(&attr);
+    numa_bind(&attr, o->numa_mem);
+    if (pthread_create(&tid, &attr, first_touch_thread, &f)) bench_fill(p, (size_t)size);
+    else pthread_join(tid, NULL);
+    pthread_attr_destroy(&attr);
+
+    snprintf(what, sizeof(what), "%s buffer", label);
+    bad = sweep_buffer(p, (size_t)size, o, what);
+    printf("\n");
+    munmap(p, (size_t)size);
+    return bad;
+}
+
+/* --save-profile: write the selected winners, 0 or 1 on error */
+static int save_profile(const char *path) {
+    if (!path) return 0;
+    if (libcrc_save_profile(path)) {
+        cfprintf(stderr, C_RED "crc: %s: %s\n" C_RESET, path, strerror(errno));
+        return 1;
+    }
+    cprintf(C_GREEN "Profile written to " C_RESET "%s\n", path);
+    return 0;
+}
+
+/* ================= SIDECAR COMBINE ================= */
+/*
+    --combine composes the CRC of a whole object from the CRCs of its
+    parts, e.g. the per-part checksums of a multipart upload, without
+    reading the data. The sidecar lists the parts in object order, one
+    per line:
+
+        <crc in hex> <length in bytes>
+
+    Blank lines and lines starting with '#' are skipped. "-" reads the
+    list from stdin. Only CRCs can be combined, xxHash has no such rule.
+*/
+int combine_sidecar(const char *path, int width) {
+    FILE *in = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!in) {
+        cfprintf(stderr, C_RED "crc: %s: %s\n" C_RESET, path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    /* start from the CRC of nothing, combining a part into it returns the part */
+    uint64_t acc = width == 16 ? 0xFFFF : 0, total = 0, parts = 0;
+    uint64_t max = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    char line[256];
+    int lineno = 0, bad = 0;
+
+    while (fgets(line, sizeof(line), in)) {
+        char *p = line, *end;
+        lineno++;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\r' || !*p) continue;
+
+        errno = 0;
+        uint64_t crc = strtoull(p, &end, 16);
+        int ok = end != p && (*end == ' ' || *end == '\t') && crc <= max && !errno;
+        uint64_t len = 0;
+        if (ok) {
+            p = end;
+            len = strtoull(p, &end, 10);
+            while (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n') end++;
+            ok = end != p && !*end && !errno && strchr(p, '-') == NULL;
+        }
+        if (!ok) {
+            cfprintf(stderr, C_RED "crc: %s:%d: expected '<crc hex> <length>'\n" C_RESET, path, lineno);
+            bad = 1;
+            break;
+        }
+
+        if (width == 16) acc = crc16_combine((uint16_t)acc, (uint16_t)crc, len);
+        else if (width == 32) acc = crc32_combine((uint32_t)acc, (uint32_t)crc, len);
+        else acc = crc64_combine(acc, crc, len);
+        total += len;
+        parts++;
+    }
+    if (ferror(in)) {
+        cfprintf(stderr, C_RED "crc: %s: %s\n" C_RESET, path, strerror(errno));
+        bad = 1;
+    }
+    if (in != stdin) fclose(in);
+    if (bad) return EXIT_FAILURE;
+
+    printf("Parts : %llu\n", (unsigned long long)parts);
+    cprintf("Size  : " C_ORANGE "%.2f " C_RESET "%s\n\n",
+            total < (1024*1024) ? total / 1024.0 : total / (1024.0*1024.0),
+            total < (1024*1024) ? "KB" : "MB");
+    if (width == 16) printf("CRC-16: %04X\n", (unsigned)acc);
+    else if (width == 32) printf("CRC-32: %08X\n", (unsigned)acc);
+    else printf("CRC-64: %016llX\n", (unsigned long long)acc);
+    return EXIT_SUCCESS;
+}
+
+/* ================= BLOCK INDEX ================= */
+/*
+    --blocks INDEX writes, next to the whole-file digest, one digest per
+    --block-size block of a single file: CRC-16, CRC-32C, CRC-64, xxHash64
+    or XXH3 of each block on its own. --verify-blocks INDEX hashes the file
+    again and prints the byte ranges whose blocks differ, so a damaged
+    image can be repaired or re-synced block by block.
+
+    It is one pass over the mapped pieces. The blocks of every piece are
+    split over the threads; a block never crosses a piece because block
+    sizes are powers of two up to MMAP_STEP. A whole-file CRC is then
+    combined from the block CRCs. xxHash has no combine, so the calling
+    thread streams the whole-file xxHash over each piece while the
+    others hash its blocks. Holes of a sparse file are found block-aligned,
+    and their blocks all get the precomputed digest of a zero block.
+
+    The index is JSON, one block digest per line so that two indexes can be
+    compared with diff:
+
+        {"version":1,"path":"disk.img","size":8388608,"block_size":4194304,
+         "hash":"crc32","digest":"7F00F52D","blocks":[
+        "2D8FF5C1",
+        "0B9E4A17"
+        ]}
+*/
+#define BLOCK_VERSION      1
+#define BLOCK_SIZE_DEFAULT ((size_t)4 * 1024 * 1024)
+#define BLOCK_SIZE_MIN     ((size_t)4096)
+
+struct block_index {
+    enum hash_algo algo;
+    size_t block_size;
+    uint64_t size, nblocks;
+    uint64_t *digests;
+    uint64_t digest;            /* of the whole file */
+    uint64_t zero_digest;       /* of a block of zeros, for holes */
+    char *path;                 /* as stored in a loaded index */
+    int threads;
+    struct hash_state h;        /* whole-file xxHash, streamed by the caller */
+};
+
+struct block_job {
+    const struct block_index *bi;
+    const uint8_t *p;
+    size_t len;
+    uint64_t *out;
+    int spawned;
+    pthread_t tid;
+};
+
+static int block_digits(enum hash_algo algo) {
+    return algo == ALGO_CRC16 ? 4 : algo == ALGO_CRC32 ? 8 : 16;
+}
+
+static uint64_t block_digest(enum hash_algo algo, const uint8_t *p, size_t n) {
+    switch (algo) {
+        case ALGO_CRC16: return crc16_hash(0xFFFF, p, n);
+        case ALGO_CRC32: return crc32_hash(0xFFFFFFFF, p, n) ^ 0xFFFFFFFF;
+        case ALGO_CRC64: return crc64_hash(0, p, n);
+        case ALGO_XXH64: return xxh64(p, n, 0);
+        default:         return xxh3_64(p, n);
+    }
+}
+
+/* block_digest() of n zero bytes, without the bytes */
+static uint64_t block_zero_digest(enum hash_algo algo, uint64_t n) {
+    struct hash_state h;
+    struct hash_digest d;
+    hash_init(&h, 1u << algo);
+    hash_update_zeros(&h, n);
+    hash_final(&h, &d);
+    switch (algo) {
+        case ALGO_CRC16: return d.crc16;
+        case ALGO_CRC32: return d.crc32;
+        case ALGO_CRC64: return d.crc64;
+        case ALGO_XXH64: return d.xxh64;
+        default:         return d.xxh3;
+    }
+}
+
+static void *block_worker(void *arg) {
+    struct block_job *j = arg;
+    size_t bs = j->bi->block_size;
+    for (size_t off = 0, k = 0; off < j->len; off += bs, k++) {
+        size_t n = j->len - off < bs ? j->len - off : bs;
+        j->out[k] = block_digest(j->bi->algo, j->p + off, n);
+        progress_add(n);
+    }
+    return NULL;
+}
+
+/* The blocks of one piece, in as many contiguous ranges as there are threads */
+static void block_window(const uint8_t *p, size_t len, uint64_t off, void *arg) {
+    struct block_index *bi = arg;
+    struct block_job jobs[MT_MAX_THREADS];
+    size_t bs = bi->block_size, nb = (len + bs - 1) / bs, b = 0;
+
+    /* holes come block-aligned, only the last block of the file can be short */
+    if (!p) {
+        for (size_t k = 0; k < nb; k++)
+            bi->digests[off / bs + k] = len - k * bs < bs ? block_zero_digest(bi->algo, len - k * bs) : bi->zero_digest;
+        if (bi->h.mask) hash_update_zeros(&bi->h, len);
+        progress_add(len);
+        return;
+    }
+    int threads = (size_t)bi->threads < nb ? bi->threads : (int)nb;
+
+    for (int t = 0; t < threads; t++) {
+        size_t count = nb / (size_t)threads + ((size_t)t < nb % (size_t)threads);
+        jobs[t].bi = bi;
+        jobs[t].p = p + b * bs;
+        jobs[t].len = (b + count) * bs < len ? count * bs : len - b * bs;
+        jobs[t].out = bi->digests + off / bs + b;
+        jobs[t].spawned = 0;
+        b += count;
+    }
+    for (int t = 1; t < threads; t++)
+        jobs[t].spawned = pthread_create(&jobs[t].tid, NULL, block_worker, &jobs[t]) == 0;
+
+    if (bi->h.mask) hash_update(&bi->h, p, len);
+    block_worker(&jobs[0]);
+    for (int t = 1; t < threads; t++) {
+        if (jobs[t].spawned) pthread_join(jobs[t].tid, NULL);
+        else block_worker(&jobs[t]);   /* pthread_create failed, do it here */
+    }
+}
+
+/* Fills the block digests and the whole-file digest of bi from fd, 0 or an errno */
+static int block_hash_file(int fd, unsigned map_opts, struct block_index *bi) {
+    bi->nblocks = (bi->size + bi->block_size - 1) / bi->block_size;
+    bi->digests = calloc(bi->nblocks ? bi->nblocks : 1, sizeof(*bi->digests));
+    if (!bi->digests) return ENOMEM;
+    hash_init(&bi->h, bi->algo == ALGO_XXH64 ? HASH_XXH64 : bi->algo == ALGO_XXH3 ? HASH_XXH3 : 0);
+
+    bi->zero_digest = block_zero_digest(bi->algo, bi->block_size);
+
+    int err = map_windows_aligned(fd, bi->size, map_opts, bi->block_size, block_window, bi);
+    if (err) return err;
+
+    if (bi->h.mask) {
+        struct hash_digest d;
+        hash_final(&bi->h, &d);
+        bi->digest = bi->algo == ALGO_XXH64 ? d.xxh64 : d.xxh3;
+        return 0;
+    }
+    /* start from the CRC of nothing, combining a block into it returns the block */
+    uint64_t acc = bi->algo == ALGO_CRC16 ? 0xFFFF : 0;
+    for (uint64_t i = 0; i < bi->nblocks; i++) {
+        uint64_t n = i == bi->nblocks - 1 ? bi->size - i * bi->block_size : bi->block_size;
+        if (bi->algo == ALGO_CRC16) acc = crc16_combine((uint16_t)acc, (uint16_t)bi->digests[i], n);
+        else if (bi->algo == ALGO_CRC32) acc = crc32_combine((uint32_t)acc, (uint32_t)bi->digests[i], n);
+        else acc = crc64_combine(acc, bi->digests[i], n);
+    }
+    bi->digest = acc;
+    return 0;
+}
+
+static void json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+/* 0, or -1 with errno set */
+static int block_save(const char *path, const char *file, const struct block_index *bi) {
+    FILE *out = fopen(path, "w");
+    int w = block_digits(bi->algo);
+    if (!out) return -1;
+
+    fprintf(out, "{\"version\":%d,\"path\":", BLOCK_VERSION);
+    json_string(out, file);
+    fprintf(out, ",\"size\":%llu,\"block_size\":%zu,\n \"hash\":\"%s\",\"digest\":\"%0*llX\",\"blocks\":[\n",
+            (unsigned long long)bi->size, bi->block_size, algo_name(bi->algo), w, (unsigned long long)bi->digest);
+    for (uint64_t i = 0; i < bi->nblocks; i++)
+        fprintf(out, "\"%0*llX\"%s\n", w, (unsigned long long)bi->digests[i], i + 1 < bi->nblocks ? "," : "");
+    fprintf(out, "]}\n");
+
+    int err = ferror(out);
+    if (fclose(out) || err) return -1;
+    return 0;
+}
+
+/* ---------- index reader ---------- */
+/* A JSON scanner for the index, just enough for what block_save writes */
+struct json_in {
+    const char *p, *end;
+};
+
+static void json_ws(struct json_in *j) {
+    while (j->p < j->end && (*j->p == ' ' || *j->p == '\t' || *j->p == '\n' || *j->p == '\r')) j->p++;
+}
+
+static int json_char(struct json_in *j, char c) {
+    json_ws(j);
+    if (j->p < j->end && *j->p == c) {
+        j->p++;
+        return 1;
+    }
+    return 0;
+}
+
+/* A string into a new buffer (\uXXXX only below 0x80), NULL when malformed */
+static char *json_parse_string(struct json_in *j) {
+    if (!json_char(j, '"')) return NULL;
+    const char *start = j->p;
+    while (j->p < j->end && *j->p != '"') j->p += *j->p == '\\' ? 2 : 1;
+    if (j->p >= j->end) return NULL;
+
+    char *s = malloc((size_t)(j->p - start) + 1), *o = s;
+    if (!s) { perror("malloc"); exit(EXIT_FAILURE); }
+    for (const char *q = start; q < j->p; q++) {
+        if (*q != '\\') { *o++ = *q; continue; }
+        q++;
+        uint64_t u;
+        switch (*q) {
+            case 'n': *o++ = '\n'; break;
+            case 't': *o++ = '\t'; break;
+            case 'r': *o++ = '\r'; break;
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'u':
+                if (j->p - q < 5 || !parse_hex(q + 1, 4, &u) || u >= 0x80) { free(s); return NULL; }
+                *o++ = (char)u;
+                q += 4;
+                break;
+            default: *o++ = *q; break;
+        }
+    }
+    *o = '\0';
+    j->p++;
+    return s;
+}
+
+static int json_parse_u64(struct json_in *j, uint64_t *v) {
+    json_ws(j);
+    const char *start = j->p;
+    *v = 0;
+    while (j->p < j->end && *j->p >= '0' && *j->p <= '9') *v = *v * 10 + (uint64_t)(*j->p++ - '0');
+    return j->p != start;
+}
+
+/* Loads an index written by --blocks, 0 or -1 after printing why */
+static int block_load(const char *path, struct block_index *bi) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    const char *map = MAP_FAILED;
+    if (fd >= 0 && fstat(fd, &st) == 0) {
+        if (!st.st_size) errno = ENODATA;
+        else map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (fd >= 0) close(fd);
+    if (map == MAP_FAILED) {
+        cfprintf(stderr, C_RED "crc: %s: %s\n" C_RESET, path, strerror(errno));
+        return -1;
+    }
+
+    struct json_in j = { map, map + st.st_size };
+    uint64_t version = 0, size = ~0ULL, block_size = 0, cap = 0;
+    int algo = -1, have_digest = 0, ok = json_char(&j, '{');
+    char *digest = NULL;
+
+    memset(bi, 0, sizeof(*bi));
+    while (ok && !json_char(&j, '}')) {
+        char *key = json_parse_string(&j);
+        ok = key && json_char(&j, ':');
+        if (!ok) {
+        } else if (!strcmp(key, "version")) {
+            ok = json_parse_u64(&j, &version) && version == BLOCK_VERSION;
+        } else if (!strcmp(key, "size")) {
+            ok = json_parse_u64(&j, &size);
+        } else if (!strcmp(key, "block_size")) {
+            ok = json_parse_u64(&j, &block_size);
+        } else if (!strcmp(key, "path")) {
+            free(bi->path);
+            ok = (bi->path = json_parse_string(&j)) != NULL;
+        } else if (!strcmp(key, "hash")) {
+            char *name = json_parse_string(&j);
+            for (int a = 0; name && a < ALGO_COUNT; a++)
+                if (!strcmp(name, algo_name((enum hash_algo)a))) algo = a;
+            ok = name && algo >= 0;
+            free(name);
+        } else if (!strcmp(key, "digest")) {
+            free(digest);
+            ok = have_digest = (digest = json_parse_string(&j)) != NULL;
+        } else if (!strcmp(key, "blocks")) {
+            ok = algo >= 0 && json_char(&j, '[');
+            bi->nblocks = 0;
+            while (ok && !json_char(&j, ']')) {
+                char *b = json_parse_string(&j);
+                ok = b && (int)strlen(b) == block_digits((enum hash_algo)algo);
+                if (ok && bi->nblocks == cap) {
+                    cap = cap ? cap * 2 : 1024;
+                    bi->digests = realloc(bi->digests, cap * sizeof(*bi->digests));
+                    if (!bi->digests) { perror("realloc"); exit(EXIT_FAILURE); }
+                }
+                ok = ok && parse_hex(b, block_digits((enum hash_algo)algo), &bi->digests[bi->nblocks++]);
+                free(b);
+                if (ok && !json_char(&j, ',')) {
+                    json_ws(&j);
+                    ok = j.p < j.end && *j.p == ']';
+                }
+            }
+        } else {
+            ok = 0;
+        }
+        free(key);
+        if (ok && !json_char(&j, ',')) {
+            json_ws(&j);
+            ok = j.p < j.end && *j.p == '}';
+        }
+    }
+    munmap((void *)map, (size_t)st.st_size);
+
+    /* the fields have to describe each other: block count, size and digest width */
+    ok = ok && algo >= 0 && have_digest && size != ~0ULL && block_size >= BLOCK_SIZE_MIN &&
+         block_size <= MMAP_STEP && !(block_size & (block_size - 1)) &&
+         bi->nblocks == (size + block_size - 1) / block_size &&
+         (int)strlen(digest) == block_digits((enum hash_algo)algo) &&
+         parse_hex(digest, block_digits((enum hash_algo)algo), &bi->digest);
+    free(digest);
+    if (!ok) {
+        cfprintf(stderr, C_RED "crc: %s: not a crc block index (version %d)\n" C_RESET, path, BLOCK_VERSION);
+        free(bi->digests);
+        free(bi->path);
+        bi->digests = NULL;
+        bi->path = NULL;
+        return -1;
+    }
+    bi->algo = (enum hash_algo)algo;
+    bi->block_size = (size_t)block_size;
+    bi->size = size;
+    return 0;
+}
+
+/*
+    Prints the byte ranges whose blocks differ from the index, runs of bad
+    blocks as one range. A size change makes every block past the shorter
+    one bad. Returns the number of bad blocks.
+*/
+static uint64_t block_compare(const struct block_index *want, const struct block_index *got) {
+    uint64_t n = want->nblocks > got->nblocks ? want->nblocks : got->nblocks;
+    uint64_t bad = 0, run = 0, bs = want->block_size;
+    uint64_t size = want->size > got->size ? want->size : got->size;
+
+    for (uint64_t i = 0; i <= n; i++) {
+        int differs = i < n && (i >= want->nblocks || i >= got->nblocks || want->digests[i] != got->digests[i]);
+        if (differs) {
+            run++;
+        } else if (run) {
+            uint64_t first = i - run, end = i * bs < size ? i * bs : size;
+            if (run == 1)
+                cprintf("Bad   : " C_RED "%llu-%llu" C_RESET " (block %llu)\n", (unsigned long long)(first * bs),
+                        (unsigned long long)end - 1, (unsigned long long)first);
+            else
+                cprintf("Bad   : " C_RED "%llu-%llu" C_RESET " (blocks %llu-%llu)\n", (unsigned long long)(first * bs),
+                        (unsigned long long)end - 1, (unsigned long long)first, (unsigned long long)(i - 1));
+            bad += run;
+            run = 0;
+        }
+    }
+    return bad;
+}
+
+enum io_backend { IO_MMAP, IO_READ, IO_URING };
+
+/* ================= ARGUMENT HELPERS ================= */
+/* Matches "--name=value" or "--name value", returns the value or NULL */
+const char *opt_value(int argc, char **argv, int *i, const char *name) {
+    size_t n = strlen(name);
+    if (strncmp(argv[*i], name, n)) return NULL;
+    if (argv[*i][n] == '=') return argv[*i] + n + 1;
+    if (argv[*i][n] == '\0' && *i + 1 < argc) return argv[++*i];
+    return NULL;
+}
+
+/* Byte count with an optional K, M or G suffix (powers of 1024), 0 if invalid */
+static uint64_t parse_size(const char *s) {
+    char *end = NULL;
+    unsigned long long n = strtoull(s, &end, 10);
+    if (end == s) return 0;
+    switch (*end) {
+        case 'k': case 'K': n <<= 10; end++; break;
+        case 'm': case 'M': n <<= 20; end++; break;
+        case 'g': case 'G': n <<= 30; end++; break;
+    }
+    return *end ? 0 : (uint64_t)n;
+}
+
+/* ================= MAIN ================= */
+int main(int argc, char **argv) {
+    int fast_mode = 0, benchmark = 0;
+    int do_crc16 = 0, do_crc32 = 1, do_crc64 = 0;
+    int do_xxh64 = 0, do_xxh3 = 0, do_xxh128 = 0;
+    int threads = online_cpus();
+    int show_dbg = 0;
+    enum io_backend io = IO_MMAP;
+    int qd = URING_QD;
+    unsigned map_opts = 0;
+    const char *file = NULL, *sidecar = NULL, *manifest = NULL, *cache_path = NULL;
+    const char *blocks_out = NULL, *blocks_in = NULL;
+    const struct crc_model *model = NULL;
+    int list_crcs = 0;
+    size_t block_size = BLOCK_SIZE_DEFAULT;
+    int rehash = 0;
+    char **paths = calloc((size_t)argc, sizeof(*paths));
+    int npaths = 0, recursive = 0;
+    const char *val;
+    struct bench_opts bo = { BENCH_REPS, BENCH_WARMUP, 0, 0, 0, 0, -1, -1, 5, { 64, 4096, 65536, 1 << 20, 64 << 20 } };
+    const char *profile_out = NULL;
+
+    libcrc_init();
+    color_setup(0);
+    int isa = -1;
+
+    /* ---------- Argument parsing ---------- */
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-d") || !strcmp(argv[i], "--debug")) show_dbg = 1;
+        else if ((val = opt_value(argc, argv, &i, "--force-isa"))) {
+            int forced = isa_from_name(val);
+            if (forced < 0) {
+                cfprintf(stderr, C_RED "Unknown ISA '%s' (", val);
+                for (int l = 0; l < ISA_COUNT; l++)
+                    fprintf(stderr, "%s%s", l ? ", " : "", isa_name((enum isa_level)l));
+                cfprintf(stderr, ")\n" C_RESET);
+                return EXIT_FAILURE;
+            }
+            if (!isa_supported((enum isa_level)forced)) {
+                cfprintf(stderr, C_RED "This CPU does not support '%s'\n" C_RESET, val);
+                return EXIT_FAILURE;
+            }
+            isa = forced;
+        } else if ((val = opt_value(argc, argv, &i, "--io"))) {
+            if (!strcmp(val, "mmap")) io = IO_MMAP;
+            else if (!strcmp(val, "read")) io = IO_READ;
+            else if (!strcmp(val, "uring")) io = IO_URING;
+            else {
+                cfprintf(stderr, C_RED "Unknown I/O backend '%s' (mmap, read, uring)\n" C_RESET, val);
+                return EXIT_FAILURE;
+            }
+        } else if ((val = opt_value(argc, argv, &i, "--qd"))) {
+            char *end = NULL;
+            long n = strtol(val, &end, 10);
+            if (*end || n < 1 || n > URING_MAX_QD) {
+                cfprintf(stderr, C_RED "Invalid queue depth (1-%d)\n" C_RESET, URING_MAX_QD);
+                return EXIT_FAILURE;
+            }
+            qd = (int)n;
+        } else if ((val = opt_value(argc, argv, &i, "--progress"))) {
+            if (!strcmp(val, "auto")) progress.mode = PROGRESS_AUTO;
+            else if (!strcmp(val, "bar")) progress.mode = PROGRESS_BAR;
+            else if (!strcmp(val, "json")) progress.mode = PROGRESS_JSON;
+            else if (!strcmp(val, "none")) progress.mode = PROGRESS_NONE;
+            else {
+                cfprintf(stderr, C_RED "Unknown progress mode '%s' (auto, bar, json, none)\n" C_RESET, val);
+                return EXIT_FAILURE;
+            }
+        } else if ((val = opt_value(argc, argv, &i, "--crc"))) {
+            if (!(model = crc_model_find(val))) {
+                cfprintf(stderr, C_RED "Unknown CRC '%s' (see --list-crcs)\n" C_RESET, val);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--list-crcs")) list_crcs = 1;
+        else if ((val = opt_value(argc, argv, &i, "--combine"))) sidecar = val;
+        else if ((val = opt_value(argc, argv, &i, "--check")) || (val = opt_value(argc, argv, &i, "-c"))) manifest = val;
+        else if ((val = opt_value(argc, argv, &i, "--cache"))) cache_path = val;
+        else if (!strcmp(argv[i], "--rehash")) rehash = 1;
+        else if ((val = opt_value(argc, argv, &i, "--blocks"))) blocks_out = val;
+        else if ((val = opt_value(argc, argv, &i, "--verify-blocks"))) blocks_in = val;
+        else if (!strcmp(argv[i], "--gpu")) {
+            if (gpu_min == UINT64_MAX) gpu_min = GPU_MIN_DEFAULT;
+        }
+        else if ((val = opt_value(argc, argv, &i, "--gpu-min"))) {
+            if (!(gpu_min = parse_size(val))) {
+                cfprintf(stderr, C_RED "Invalid --gpu-min '%s' (a size such as 512M or 2G)\n" C_RESET, val);
+                return EXIT_FAILURE;
+            }
+        }
+        else if ((val = opt_value(argc, argv, &i, "--block-size"))) {
+            uint64_t n = parse_size(val);
+            if (n < BLOCK_SIZE_MIN || n > MMAP_STEP || (n & (n - 1))) {
+                cfprintf(stderr, C_RED "Invalid --block-size '%s' (a power of two from 4K to %zuM)\n" C_RESET,
+                         val, MMAP_STEP >> 20);
+                return EXIT_FAILURE;
+            }
+            block_size = (size_t)n;
+        }
+        else if ((val = opt_value(argc, argv, &i, "--reps"))) {
+            char *end = NULL;
+            long n = strtol(val, &end, 10);
+            if (*end || n < 1 || n > BENCH_MAX_REPS) {
+                cfprintf(stderr, C_RED "Invalid repetition count (1-%d)\n" C_RESET, BENCH_MAX_REPS);
+                return EXIT_FAILURE;
+            }
+            bo.reps = (int)n;
+        } else if ((val = opt_value(argc, argv, &i, "--warmup"))) {
+            char *end = NULL;
+            long n = strtol(val, &end, 10);
+            if (*end || n < 0 || n > BENCH_MAX_REPS) {
+                cfprintf(stderr, C_RED "Invalid warmup count (0-%d)\n" C_RESET, BENCH_MAX_REPS);
+                return EXIT_FAILURE;
+            }
+            bo.warmup = (int)n;
+        } else if ((val = opt_value(argc, argv, &i, "--bench-size"))) {
+            char list[256];
+            snprintf(list, sizeof(list), "%s", val);
+            bo.nsizes = 0;
+            for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+                uint64_t n = parse_size(tok);
+                if (!n || bo.nsizes == BENCH_MAX_SIZES) {
+                    cfprintf(stderr, C_RED "Invalid --bench-size '%s' (up to %d sizes such as 64,4K,1M,1G)\n" C_RESET, val, BENCH_MAX_SIZES);
+                    return EXIT_FAILURE;
+                }
+                bo.sizes[bo.nsizes++] = n;
+            }
+        }
+        else if (!strcmp(argv[i], "--cold")) bo.cold = 1;
+        else if (!strcmp(argv[i], "--all-impls")) bo.all_impls = 1;
+        else if (!strcmp(argv[i], "--sweep")) bo.sweep = 1;
+        else if ((val = opt_value(argc, argv, &i, "--numa"))) {
+            char *end = NULL;
+            long cpu = strtol(val, &end, 10), mem = cpu;
+            if (end != val && *end == ':') mem = strtol(end + 1, &end, 10);
+            if (*end || end == val || !numa_has_cpus((int)cpu) || mem < 0 || mem >= numa_nodes() || !numa.present[mem]) {
+                cfprintf(stderr, C_RED "Invalid --numa '%s' (CPU[:MEM] node, %d node%s here)\n" C_RESET,
+                         val, numa_nodes(), numa_nodes() > 1 ? "s" : "");
+                return EXIT_FAILURE;
+            }
+            bo.numa_cpu = (int)cpu;
+            bo.numa_mem = (int)mem;
+        }
+        else if (!strcmp(argv[i], "--no-color")) color_setup(1);
+        else if ((val = opt_value(argc, argv, &i, "--format"))) {
+            size_t f = 0;
+            while (f < sizeof(format_names) / sizeof(format_names[0]) && strcmp(val, format_names[f])) f++;
+            if (f == sizeof(format_names) / sizeof(format_names[0])) {
+                cfprintf(stderr, C_RED "Unknown format '%s' (text, json, csv, tag, binary)\n" C_RESET, val);
+                return EXIT_FAILURE;
+            }
+            out_format = (enum out_format)f;
+        }
+        else if (!strcmp(argv[i], "--stats")) stats.report = 1;
+        else if (!strncmp(argv[i], "--stats=", 8) && argv[i][8]) {
+            stats.report = 1;
+            stats.path = argv[i] + 8;
+        }
+        else if (!strcmp(argv[i], "--perf")) stats.report = stats.perf = 1;
+        else if (!strcmp(argv[i], "--save-profile")) profile_out = "";
+        else if (!strncmp(argv[i], "--save-profile=", 15) && argv[i][15]) profile_out = argv[i] + 15;
+        else if (!strcmp(argv[i], "--hugepage")) map_opts |= MAP_OPT_HUGEPAGE;
+        else if (!strcmp(argv[i], "--populate")) map_opts |= MAP_OPT_POPULATE;
+        else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--single")) fast_mode = 1;
+        else if (!strcmp(argv[i], "--benchmark") || !strcmp(argv[i], "-b")) benchmark = fast_mode = 1;
+        else if (!strcmp(argv[i], "--crc16") || !strcmp(argv[i], "-c16")) do_crc16 = 1, do_crc32 = 0;
+        else if (!strcmp(argv[i], "--crc64") || !strcmp(argv[i], "-c64")) do_crc64 = 1, do_crc32 = 0;
+        else if (!strcmp(argv[i], "--x64") || !strcmp(argv[i], "-h")) do_xxh64 = 1, do_crc32 = 0;
+        else if (!strcmp(argv[i], "--x3") || !strcmp(argv[i], "-3")) do_xxh3 = 1, do_crc32 = 0;
+        else if (!strcmp(argv[i], "--x128") || !strcmp(argv[i], "-H")) do_xxh128 = 1, do_crc32 = 0;
+        else if (!strcmp(argv[i], "-a") || !strcmp(argv[i], "--all"))
+            do_crc16 = do_crc32 = do_crc64 = do_xxh64 = do_xxh3 = do_xxh128 = 1;
+        else if (!strcmp(argv[i], "-j") || !strcmp(argv[i], "--threads")) {
+            char *end = NULL;
+            long n = (i + 1 < argc) ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end || n < 1 || n > MT_MAX_THREADS) {
+                cfprintf(stderr, C_RED "Invalid thread count (1-%d)\n" C_RESET, MT_MAX_THREADS);
+                return EXIT_FAILURE;
+            }
+            threads = (int)n;
+        }
+        else if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--recursive")) recursive = 1;
+        else paths[npaths++] = argv[i];
+    }
+
+    /* --force-isa replaces the tuning profile as well as the best level */
+    if (isa >= 0) select_engines((enum isa_level)isa);
+
+    if (bo.sweep && (bo.all_impls || bo.cold)) {
+        cfprintf(stderr, C_RED "--sweep cannot be combined with --all-impls or --cold\n" C_RESET);
+        return EXIT_FAILURE;
+    }
+    if (profile_out && !bo.all_impls) {
+        cfprintf(stderr, C_RED "--save-profile needs --benchmark --all-impls\n" C_RESET);
+        return EXIT_FAILURE;
+    }
+    if ((blocks_out || blocks_in) && (benchmark || manifest || sidecar || cache_path || recursive || npaths > 1 ||
+                                      (blocks_out && blocks_in))) {
+        cfprintf(stderr, C_RED "--blocks / --verify-blocks take one file and no other mode\n" C_RESET);
+        return EXIT_FAILURE;
+    }
+    if (blocks_out && (do_crc16 + do_crc32 + do_crc64 + do_xxh64 + do_xxh3 != 1 || do_xxh128)) {
+        cfprintf(stderr, C_RED "--blocks takes one of --crc16, --crc64, --x64, --x3 or the default CRC-32\n" C_RESET);
+        return EXIT_FAILURE;
+    }
+    if (out_format != FORMAT_TEXT && (benchmark || manifest || sidecar || model || blocks_out || blocks_in)) {
+        cfprintf(stderr, C_RED "--format is for the digests of files, not -b, --check, --combine, --crc or --blocks\n" C_RESET);
+        return EXIT_FAILURE;
+    }
+    if (model && (benchmark || manifest || sidecar || cache_path || recursive || npaths > 1 || blocks_out ||
+                  blocks_in || do_crc16 || do_crc64 || do_xxh64 || do_xxh3 || do_xxh128)) {
+        cfprintf(stderr, C_RED "--crc takes one file and no other hash or mode\n" C_RESET);
+        return EXIT_FAILURE;
+    }
+    if (rehash && !cache_path) {
+        cfprintf(stderr, C_RED "--rehash needs --cache FILE\n" C_RESET);
+        return EXIT_FAILURE;
+    }
+    if (profile_out && !*profile_out) {
+        profile_out = getenv(LIBCRC_PROFILE_ENV);
+        if (!profile_out || !*profile_out) profile_out = LIBCRC_PROFILE_PATH;
+    }
+
+    if (show_dbg) {
+        show_debug();
+        return EXIT_SUCCESS;
+    }
+    if (list_crcs) return list_models();
+    if (stats.report) {
+        stats.model = model;
+        stats_start(!benchmark);
+    }
+
+    if (sidecar) {
+        if (do_crc16 + do_crc32 + do_crc64 != 1 || do_xxh64 || do_xxh3 || do_xxh128 || npaths) {
+            cfprintf(stderr, C_RED "--combine takes one of --crc16, --crc64 or the default CRC-32, and no files\n" C_RESET);
+            return EXIT_FAILURE;
+        }
+        return combine_sidecar(sidecar, do_crc16 ? 16 : do_crc64 ? 64 : 32);
+    }
+
+    unsigned show = (do_crc16 ? SHOW_CRC16 : 0) | (do_crc32 ? SHOW_CRC32 : 0) |
+                    (do_crc64 ? SHOW_CRC64 : 0) | (do_xxh64 ? SHOW_XXH64 : 0) |
+                    (do_xxh3 ? SHOW_XXH3 : 0) | (do_xxh128 ? SHOW_XXH128 : 0);
+    if (manifest) {
+        if (benchmark || npaths || recursive) {
+            cfprintf(stderr, C_RED "--check takes a manifest and no files\n" C_RESET);
+            return EXIT_FAILURE;
+        }
+        struct cache cache;
+        if (cache_path) cache_open(&cache, cache_path, rehash);
+        return check_manifest(manifest, show, threads, map_opts, cache_path ? &cache : NULL);
+    }
+
+    /*
+        Several paths, -r, a directory or --cache: one line per file from
+        the scheduler. A single file keeps the detailed output below.
+    */
+    struct stat pst;
+    if (npaths > 1 || recursive || (npaths && cache_path) ||
+        (npaths == 1 && stat(paths[0], &pst) == 0 && S_ISDIR(pst.st_mode))) {
+        if (benchmark) {
+            cfprintf(stderr, C_RED "Benchmark mode takes a single file\n" C_RESET);
+            return EXIT_FAILURE;
+        }
+        unsigned mask = (do_crc16 ? HASH_CRC16 : 0) | (do_crc32 ? HASH_CRC32 : 0) |
+                        (do_crc64 ? HASH_CRC64 : 0) | (do_xxh64 ? HASH_XXH64 : 0) |
+                        (do_xxh3 || do_xxh128 ? HASH_XXH3 : 0);
+        if (!npaths) paths[npaths++] = ".";
+        struct cache cache;
+        if (cache_path) cache_open(&cache, cache_path, rehash);
+        return hash_many(paths, npaths, recursive, mask, show, threads, map_opts, cache_path ? &cache : NULL);
+    }
+    if (npaths) file = paths[0];
+
+    /* --verify-blocks hashes the file named in the index unless one is given */
+    struct block_index want;
+    if (blocks_in) {
+        if (block_load(blocks_in, &want)) return EXIT_FAILURE;
+        if (!file) file = want.path;
+    }
+
+    /* -b without a file: RAM buffers of every --bench-size */
+    bo.threads = threads;
+    if (benchmark && !file) {
+        double t0 = now_seconds();
+        int bad = bo.sweep ? sweep_sizes(&bo) : bench_sizes(&bo);
+        if (!bad && bo.all_impls) {
+            bench_winners(bo.sizes, bo.nsizes);
+            bad = save_profile(profile_out);
+            printf("\n");
+        }
+        cprintf(C_RESET "Time  : %.6f s\n", now_seconds() - t0);
+        return bad ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    /* No file but something piped in: hash stdin */
+    if (!file && !isatty(STDIN_FILENO)) file = "-";
+
+    if (!file) {
+        cfprintf(stderr,
+                 "CRC Checker v%s\nUsage: crc [OPTIONS] <file | - | path...>\n\n"
+                 "Options:\n"
+                 "  --crc16, -c16     Perform an CRC-16 checksum\n"
+                 "  --crc64, -c64     Perform an CRC-64 checksum\n"
+                 "  --x64, -h         Perform an xxHash64 checksum\n"
+                 "  --x3, -3          Perform an XXH3 (64-bit) checksum\n"
+                 "  --x128, -H        Perform an XXH3-128 checksum\n"
+                 "  --all, -a         Perform all checksum (slow)\n"
+                 "  --single, -s      Single pass checksum calculation (Fast mode)\n"
+                 "  --benchmark, -b   Benchmark every hash on FILE, or on RAM buffers without one\n"
+                 "  --bench-size LIST Buffer sizes for -b without a file (default: 64,4K,64K,1M,64M)\n"
+                 "  --reps N          Timed repetitions per hash for -b (default: %d)\n"
+                 "  --warmup N        Untimed runs before them (default: %d)\n"
+                 "  --cold            -b FILE: also time it from disk, page cache dropped per run\n"
+                 "  --all-impls       -b: time every kernel of every hash and pick the winners\n"
+                 "  --sweep           -b: GB/s and parallel efficiency for 1, 2, 4 ... -j threads\n"
+                 "  --numa CPU[:MEM]  --sweep: workers on node CPU, buffer first touched on node MEM\n"
+                 "  --save-profile[=FILE] Store the winners as the libcrc tuning profile\n"
+                 "  --recursive, -r   Hash every file under the given directories\n"
+                 "  --crc NAME        A CRC of the catalogue instead, e.g. CRC-32/ISO-HDLC, CRC-64/NVME\n"
+                 "  --list-crcs       List the catalogue (name, alias, Rocksoft parameters, check)\n"
+                 "  --combine FILE    CRC of a whole object from '<crc hex> <length>' part lines\n"
+                 "  --check, -c FILE  Verify the files of a sha256sum-style or tagged manifest\n"
+                 "  --cache FILE      Reuse digests of unchanged files (by inode, size, mtime, ctime)\n"
+                 "  --rehash          With --cache: read every file again, rebuild the cache from them\n"
+                 "  --blocks INDEX    Also write a digest per block of FILE as a JSON index\n"
+                 "  --block-size SIZE Block size for --blocks, a power of two (default: 4M)\n"
+                 "  --verify-blocks INDEX  Hash FILE (default: the indexed path), print bad ranges\n"
+                 "  --threads, -j N   Threads for CRC32 / the file scheduler (default: online CPUs)\n"
+                 "  --gpu             CRCs of files from 1G up on an OpenCL GPU, xxHashes on the CPU\n"
+                 "  --gpu-min SIZE    Size from which --gpu takes a file (implies --gpu)\n"
+                 "  --force-isa ISA   Use the scalar, sse4.2, pclmul, avx2, avx512, armv8 or pmull kernels\n"
+                 "  --io=BACKEND      Read files with mmap (default), read or uring (O_DIRECT)\n"
+                 "  --qd N            Reads in flight for --io=uring (default: %d)\n"
+                 "  --hugepage        madvise(MADV_HUGEPAGE) on the mmap windows\n"
+                 "  --populate        Prefault each mmap window (MAP_POPULATE)\n"
+                 "  --progress=MODE   auto (bar on a terminal), bar, json (lines on stderr) or none\n"
+                 "  --format=FORMAT   Digests as text (default), json (lines), csv, tag (BSD) or binary\n"
+                 "  --no-color        No ANSI colors (also off when not a terminal, or with NO_COLOR)\n"
+                 "  --stats[=FILE]    Stage times, bytes per kernel and rusage as JSON at exit (default: stderr)\n"
+                 "  --perf            --stats with perf_event_open cycles / instructions / LLC misses\n\n"
+                 "NOTE: " C_GREEN "By default, the " C_ORANGE "CRC32" C_GREEN " checksum is performed unless otherwise specified.\n" C_RESET, VERSION, BENCH_REPS, BENCH_WARMUP, URING_QD);
+        return EXIT_FAILURE;
+    }
+
+    char full[PATH_MAX];
+    int from_stdin = !strcmp(file, "-");
+    int fd = STDIN_FILENO;
+    uint64_t t_open = stats_clock();
+
+    if (!from_stdin) {
+        if (!realpath(file, full)) return out_open_error(file, show, errno);
+        fd = open(full, O_RDONLY);
+        if (fd < 0) return out_open_error(file, show, errno);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) return out_open_error(file, show, errno);
+
+    /*
+        Regular files are mapped through sliding windows unless --io picks
+        another backend. Everything else (stdin, pipes, FIFOs, devices),
+        empty files and files that refuse mmap go through the streaming
+        reader. Only benchmark mode maps the whole file at once.
+    */
+    int streaming = io != IO_MMAP || from_stdin || !S_ISREG(st.st_mode) || !st.st_size;
+    uint64_t filesize = streaming ? 0 : (uint64_t)st.st_size;
+    uint8_t *data = NULL;
+
+    if (!streaming) {
+        size_t probe = filesize < MMAP_STEP ? (size_t)filesize : MMAP_STEP;
+        uint8_t *p = mmap(NULL, probe, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) streaming = 1;
+        else munmap(p, probe);
+    }
+    stats_stage(STAGE_OPEN, t_open);
+
+    if (benchmark) {
+        if (streaming || filesize > SIZE_MAX || !(data = map_range(fd, 0, (size_t)filesize, map_opts))) {
+            cfprintf(stderr, C_RED "Benchmark mode needs a non-empty regular file that fits in memory and --io=mmap\n" C_RESET);
+            return EXIT_FAILURE;
+        }
+        if (!bo.cold) close(fd);
+    }
+
+    /* other formats print the record and nothing else */
+    char dir[PATH_MAX];
+    uint64_t size_hint = streaming ? stream_size_hint(fd, &st) : filesize;
+    if (out_format == FORMAT_TEXT) {
+        if (from_stdin) {
+            printf("File  : (stdin)\n");
+        } else {
+            strcpy(dir, full);
+            get_directory(dir);
+            printf("File  : %s\nPath  : %s\n", get_filename(full), dir);
+        }
+        /* an empty regular file is streamed as well, but has a size: 0 */
+        if ((from_stdin || !S_ISREG(st.st_mode)) && !size_hint)
+            cprintf("Size  : " C_ORANGE "stream" C_RESET "\n\n");
+        else
+            cprintf("Size  : " C_ORANGE "%.2f " C_RESET "%s\n\n",
+                    size_hint < (1024*1024) ? size_hint / 1024.0 : size_hint / (1024.0*1024.0),
+                    size_hint < (1024*1024) ? "KB" : "MB");
+    }
+
+    /* ================= CATALOGUE CRC MODE ================= */
+    if (model) {
+        double t0 = now_seconds();
+        struct model_window_ctx c = { model, crc_model_init(model) };
+        progress_start(size_hint);
+        int merr = streaming ? model_stream(fd, &c)
+                             : map_windows(fd, filesize, map_opts | (filesize > MMAP_WINDOW ? MAP_OPT_DROP : 0),
+                                           model_window, &c);
+        progress_stop();
+        if (!from_stdin) close(fd);
+        if (merr) {
+            cfprintf(stderr, C_RED "crc: %s: %s\n" C_RESET, file, strerror(merr));
+            return EXIT_FAILURE;
+        }
+        printf("%s: %0*llX\n", model->name, (model->width + 3) / 4,
+               (unsigned long long)crc_model_final(model, c.reg));
+        printf("\nTime  : %.6f s\n", now_seconds() - t0);
+        return EXIT_SUCCESS;
+    }
+
+    /* ================= BENCHMARK MODE ================= */
+    if (benchmark) {
+        double t0 = now_seconds();
+
+        /* the warmup runs fault the mapping in, the timed ones hash from RAM */
+        int bad;
+        if (bo.sweep) {
+            bad = sweep_buffer(data, (size_t)filesize, &bo, "file in memory");
+        } else {
+            bench_header("File in memory", &bo);
+            bad = bench_buffer(data, (size_t)filesize, &bo, 0);
+        }
+        munmap(data, (size_t)filesize);
+        if (!bad && bo.all_impls) {
+            printf("\n");
+            bench_winners(&filesize, 1);
+            bad = save_profile(profile_out);
+        }
+
+        /* mapped pages would survive DONTNEED, so the cold runs come after munmap */
+        if (bo.cold) {
+            printf("\n");
+            bad |= bench_cold(fd, filesize, map_opts, &bo);
+            close(fd);
+        }
+
+        cprintf(C_RESET "\nTime  : %.6f s\n", now_seconds() - t0);
+        return bad ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    /* ================= BLOCK INDEX MODE ================= */
+    if (blocks_out || blocks_in) {
+        if (streaming) {
+            cfprintf(stderr, C_RED "Block mode needs a non-empty regular file and --io=mmap\n" C_RESET);
+            return EXIT_FAILURE;
+        }
+        double t0 = now_seconds();
+        struct block_index bi;
+        memset(&bi, 0, sizeof(bi));
+        bi.algo = blocks_in ? want.algo : do_crc16 ? ALGO_CRC16 : do_crc64 ? ALGO_CRC64 :
+                  do_xxh64 ? ALGO_XXH64 : do_xxh3 ? ALGO_XXH3 : ALGO_CRC32;
+        bi.block_size = blocks_in ? want.block_size : block_size;
+        bi.size = filesize;
+        bi.threads = threads;
+
+        progress_start(filesize);
+        int berr = block_hash_file(fd, map_opts | (filesize > MMAP_WINDOW ? MAP_OPT_DROP : 0), &bi);
+        progress_stop();
+        close(fd);
+        if (berr) {
+            cfprintf(stderr, C_RED "mmap: %s\n" C_RESET, strerror(berr));
+            return EXIT_FAILURE;
+        }
+
+        int w = block_digits(bi.algo), bad = 0;
+        printf("Blocks: %llu x %zu KB, %s\n", (unsigned long long)bi.nblocks, bi.block_size / 1024,
+               bench_algo_names[bi.algo]);
+        printf("%-6s: %0*llX\n", bench_algo_names[bi.algo], w, (unsigned long long)bi.digest);
+        if (blocks_out) {
+            if (block_save(blocks_out, file, &bi)) {
+                cfprintf(stderr, C_RED "crc: %s: %s\n" C_RESET, blocks_out, strerror(errno));
+                bad = 1;
+            } else {
+                printf("Index : %s\n", blocks_out);
+            }
+        } else {
+            if (bi.size != want.size)
+                cprintf("Size  : " C_RED "%llu bytes, the index has %llu" C_RESET "\n",
+                        (unsigned long long)bi.size, (unsigned long long)want.size);
+            uint64_t nbad = block_compare(&want, &bi);
+            bad = nbad || bi.size != want.size || bi.digest != want.digest;
+            if (bad)
+                cprintf("Result: " C_RED "%llu of %llu blocks differ" C_RESET "\n", (unsigned long long)nbad,
+                        (unsigned long long)(want.nblocks > bi.nblocks ? want.nblocks : bi.nblocks));
+            else
+                cprintf("Result: " C_GREEN "OK" C_RESET "\n");
+        }
+        printf("\nTime  : %.6f s\n", now_seconds() - t0);
+        return bad ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    /* ================= SINGLE-PASS / PROGRESS ================= */
+    double t_start = now_seconds();
+    struct hash_state h;
+    unsigned mask = (do_crc16 ? HASH_CRC16 : 0) | (do_crc32 ? HASH_CRC32 : 0) |
+                    (do_crc64 ? HASH_CRC64 : 0) | (do_xxh64 ? HASH_XXH64 : 0) |
+                    (do_xxh3 || do_xxh128 ? HASH_XXH3 : 0);
+    hash_init(&h, mask);
+
+    /* ---------- GPU: the CRCs on the device, the xxHashes here in the same read ---------- */
+    const char *device = NULL;
+    if (!streaming && filesize >= gpu_min && (mask & HASH_CRCS)) {
+        progress_start(filesize);
+        hash_init(&h, mask & ~HASH_CRCS);
+        int gerr = gpu_hash_file(fd, filesize, mask & HASH_CRCS, &h);
+        progress_stop();
+        if (gerr > 0) {
+            cfprintf(stderr, C_RED "read: %s\n" C_RESET, strerror(gerr));
+            return EXIT_FAILURE;
+        }
+        if (gerr == 0) {
+            device = gpu.name;
+            mask = 0;
+        } else {
+            hash_init(&h, mask);
+        }
+    }
+
+    /* normal mode reads a mapped file twice when CRC32 has company */
+    int passes = !streaming && !fast_mode && (mask & HASH_CRC32) && (mask & ~HASH_CRC32) ? 2 : 1;
+    if (mask || streaming) progress_start(streaming ? size_hint : filesize * passes);
+
+    /* ---------- Streams: one pass, every hash in the same kernel ---------- */
+    uint64_t streamed = 0;
+    if (streaming) {
+        int err = ENOSYS;
+
+        /* io_uring needs a known size; falls back to read() if nothing was hashed yet */
+        if (io == IO_URING && size_hint && !from_stdin) {
+            int dfd = open(full, O_RDONLY | O_DIRECT);
+            err = hash_uring(dfd >= 0 ? dfd : fd, &h, size_hint, qd, &streamed);
+            if (dfd >= 0) close(dfd);
+            if (err && !streamed)
+                cfprintf(stderr, C_YELLOW "io_uring unavailable (%s), using read\n" C_RESET, strerror(err));
+        }
+        if (err && !streamed)
+            err = hash_stream(fd, &h, &streamed);
+        if (fd != STDIN_FILENO) close(fd);
+        if (err) {
+            progress_stop();
+            cfprintf(stderr, C_RED "read: %s\n" C_RESET, strerror(err));
+            return EXIT_FAILURE;
+        }
+        mask = 0;
+    }
+
+    /* Large files leave the page cache behind the last pass over them */
+    unsigned last_pass_opts = map_opts | (filesize > MMAP_WINDOW ? MAP_OPT_DROP : 0);
+    int err = 0;
+
+    /* ---------- Normal mode: CRC32 gets its own threaded pass ---------- */
+    if (!fast_mode && (mask & HASH_CRC32)) {
+        struct crc32_window_ctx c = { 0, threads };
+        mask &= ~HASH_CRC32;
+        err = map_windows(fd, filesize, mask ? map_opts : last_pass_opts, crc32_window, &c);
+        /* the rest runs without CRC32 below; left un-finalized for hash_final() */
+        hash_init(&h, mask);
+        h.crc32 = c.crc ^ 0xFFFFFFFF;
+    }
+
+    if (mask && !err) {
+        struct sp_window_ctx c = { &h };
+        err = map_windows(fd, filesize, last_pass_opts, sp_window, &c);
+    }
+
+    if (!streaming) close(fd);
+    progress_stop();
+    if (err) {
+        cfprintf(stderr, C_RED "mmap: %s\n" C_RESET, strerror(err));
+        return EXIT_FAILURE;
+    }
+
+    struct hash_digest d;
+    hash_final(&h, &d);
+
+    double t_end = now_seconds();
+    uint64_t t_out = stats_clock();
+
+    if (out_format != FORMAT_TEXT) {
+        char buf[4096];
+        struct out_buf o = { STDOUT_FILENO, 0, buf, 0, sizeof(buf) };
+        fflush(stdout);
+        out_header(&o, show);
+        out_record(&o, &d, show, file, streaming ? streamed : filesize, 0);
+        out_flush(&o);
+        stats_stage(STAGE_OUTPUT, t_out);
+        if (o.err) {
+            fprintf(stderr, "crc: write error: %s\n", strerror(o.err));
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (do_crc16) printf("CRC-16: %04X\n", d.crc16);
+    if (do_crc32) printf("CRC-32: %08X\n", d.crc32);
+    if (do_crc64) printf("CRC-64: %016llX\n", (unsigned long long)d.crc64);
+    if (do_xxh64) printf("xxH64 : %016llX\n", (unsigned long long)d.xxh64);
+    if (do_xxh3)  printf("xxH3  : %016llX\n", (unsigned long long)d.xxh3);
+    if (do_xxh128)
+        printf("xxH128: %016llX%016llX\n", (unsigned long long)d.xxh128.hi, (unsigned long long)d.xxh128.lo);
+
+    if (streaming && streamed != size_hint)
+        cprintf("Read  : " C_ORANGE "%.2f " C_RESET "MB\n", streamed / (1024.0 * 1024.0));
+    if (device)
+        cprintf("GPU   : " C_ORANGE "%s" C_RESET " (CRCs)\n", device);
+    printf("\nTime  : %.6f s\n", t_end - t_start);
+    fflush(stdout);
+    stats_stage(STAGE_OUTPUT, t_out);
 
-    munmap(data, filesize);
     return EXIT_SUCCESS;
 }
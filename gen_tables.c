@@ -0,0 +1,443 @@
+/*
+
+gen_tables. Copyright (C) 2026 Ino Jacob. All rights reserved.
+
+Build-time generator of crc_tables.h: the slicing tables, the x^(2^n)
+combine tables and the PCLMUL folding constants of libcrc, printed as
+static const arrays so they live in .rodata and cost nothing at startup.
+It runs on the build host, the output is the same on every target.
+
+The CRC catalogue (Rocksoft parameter sets) is defined here too, and each
+model gets its own tables and folding constants. A model whose check value
+does not come out is an error, so a typo in the list never builds.
+
+Compilation:
+
+    make tables
+
+    or,
+
+    gcc -O2 gen_tables.c -o gen_tables && ./gen_tables > crc_tables.h
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ================= CRC POLYNOMIALS ================= */
+/* Must match libcrc.c, the generated header checks it */
+#define CRC16_POLY  0x1021u
+#define CRC32C_POLY 0x1EDC6F41u
+#define CRC64_POLY  0x42F0E1EBA9EA3693ULL
+#define CRC32C_POLY_REFLECTED 0x82F63B78u
+
+#define CRC_SLICES   16
+#define FOLD_LEVELS  5
+
+static uint64_t crc64_table[CRC_SLICES][256];
+static uint32_t crc32_table[CRC_SLICES][256];
+static uint16_t crc16_table[CRC_SLICES][256];
+
+static uint32_t crc32_x2n_table[64];
+static uint64_t crc16_x2n_table[64];
+static uint64_t crc64_x2n_table[64];
+
+static uint64_t crc16_fold[FOLD_LEVELS][2], crc32_fold[FOLD_LEVELS][2], crc64_fold[FOLD_LEVELS][2];
+
+/* ================= SLICING TABLES ================= */
+/* Table 0 is the classic byte table, table k is a byte followed by k zero bytes */
+static void init_crc64(void) {
+    for (int i = 0; i < 256; i++) {
+        uint64_t crc = (uint64_t)i << 56;
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 0x8000000000000000ULL) ? (crc << 1) ^ CRC64_POLY : (crc << 1);
+        crc64_table[0][i] = crc;
+    }
+
+    for (int k = 1; k < CRC_SLICES; k++)
+        for (int i = 0; i < 256; i++) {
+            uint64_t crc = crc64_table[k - 1][i];
+            crc64_table[k][i] = (crc << 8) ^ crc64_table[0][crc >> 56];
+        }
+}
+
+static void init_crc32(void) {
+    for (int i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY_REFLECTED : (crc >> 1);
+        crc32_table[0][i] = crc;
+    }
+
+    for (int k = 1; k < CRC_SLICES; k++)
+        for (int i = 0; i < 256; i++) {
+            uint32_t crc = crc32_table[k - 1][i];
+            crc32_table[k][i] = (crc >> 8) ^ crc32_table[0][crc & 0xFF];
+        }
+}
+
+static void init_crc16(void) {
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = i << 8;
+        for (int j = 0; j < 8; j++)
+            crc = (uint16_t)(
+                (crc & 0x8000u)
+                ? ((crc << 1) ^ (uint16_t)CRC16_POLY)
+                : (crc << 1)
+            );
+
+        crc16_table[0][i] = crc;
+    }
+
+    for (int k = 1; k < CRC_SLICES; k++)
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = crc16_table[k - 1][i];
+            crc16_table[k][i] = (uint16_t)((crc << 8) ^ crc16_table[0][crc >> 8]);
+        }
+}
+
+/* ================= COMBINE TABLES ================= */
+/* Same products as crc32_multmodp / crc_msb_multmodp in libcrc.c */
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31, p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC32C_POLY_REFLECTED : b >> 1;
+    }
+    return p;
+}
+
+static uint64_t crc_msb_multmodp(uint64_t a, uint64_t b, uint64_t poly, int width) {
+    uint64_t top = 1ULL << (width - 1);
+    uint64_t mask = width == 64 ? ~0ULL : (top << 1) - 1;
+    uint64_t p = 0;
+    for (int i = width - 1; i >= 0; i--) {
+        int carry = (p & top) != 0;
+        p = (p << 1) & mask;
+        if (carry) p ^= poly;
+        if ((a >> i) & 1) p ^= b;
+    }
+    return p;
+}
+
+/* Entry n is x^(2^n) mod P */
+static void init_crc_combine(void) {
+    uint32_t p = 1u << 30;  /* x^1 */
+    crc32_x2n_table[0] = p;
+    for (int n = 1; n < 64; n++)
+        crc32_x2n_table[n] = p = crc32_multmodp(p, p);
+
+    uint64_t p16 = 2, p64 = 2;  /* x^1 */
+    crc16_x2n_table[0] = p16;
+    crc64_x2n_table[0] = p64;
+    for (int n = 1; n < 64; n++) {
+        crc16_x2n_table[n] = p16 = crc_msb_multmodp(p16, p16, CRC16_POLY, 16);
+        crc64_x2n_table[n] = p64 = crc_msb_multmodp(p64, p64, CRC64_POLY, 64);
+    }
+}
+
+/* ================= FOLD CONSTANTS ================= */
+/* x^n mod P, MSB-first, P = x^width + poly */
+static uint64_t xnmodp(unsigned n, uint64_t poly, int width) {
+    uint64_t top = 1ULL << (width - 1);
+    uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    uint64_t p = 1;
+    while (n--) {
+        int carry = (p & top) != 0;
+        p = (p << 1) & mask;
+        if (carry) p ^= poly;
+    }
+    return p;
+}
+
+static uint64_t bitrev64(uint64_t v) {
+    uint64_t r = 0;
+    for (int i = 0; i < 64; i++, v >>= 1)
+        r = (r << 1) | (v & 1);
+    return r;
+}
+
+/* { multiplier for qword 0, multiplier for qword 1 } per 128 << level bits */
+static void init_fold_consts(uint64_t k[FOLD_LEVELS][2], uint64_t poly, int width, int reflected) {
+    for (int i = 0; i < FOLD_LEVELS; i++) {
+        unsigned d = 128u << i;
+        if (reflected) {
+            k[i][0] = bitrev64(xnmodp(d + 63, poly, width));
+            k[i][1] = bitrev64(xnmodp(d - 1, poly, width));
+        } else {
+            k[i][0] = xnmodp(d, poly, width);
+            k[i][1] = xnmodp(d + 64, poly, width);
+        }
+    }
+}
+
+/* ================= CRC CATALOGUE ================= */
+/*
+    Rocksoft model parameters and the CRC of "123456789", as listed in the
+    reveng catalogue. The aliases are the names the same CRC goes by most.
+    CRC-32/CKSUM is the plain CRC, without the length bytes cksum appends.
+*/
+struct model {
+    const char *name, *alias;
+    int width, refin, refout;
+    uint64_t poly, init, xorout, check;
+};
+
+#define ONES ~0ULL
+
+static const struct model models[] = {
+    { "CRC-8/SMBUS",        NULL,                  8, 0, 0, 0x07, 0x00, 0x00, 0xF4 },
+    { "CRC-8/MAXIM-DOW",    "CRC-8/MAXIM",         8, 1, 1, 0x31, 0x00, 0x00, 0xA1 },
+    { "CRC-16/ARC",         "CRC-16",             16, 1, 1, 0x8005, 0x0000, 0x0000, 0xBB3D },
+    { "CRC-16/IBM-3740",    "CRC-16/CCITT-FALSE", 16, 0, 0, 0x1021, 0xFFFF, 0x0000, 0x29B1 },
+    { "CRC-16/KERMIT",      "CRC-16/CCITT",       16, 1, 1, 0x1021, 0x0000, 0x0000, 0x2189 },
+    { "CRC-16/XMODEM",      NULL,                 16, 0, 0, 0x1021, 0x0000, 0x0000, 0x31C3 },
+    { "CRC-16/MODBUS",      NULL,                 16, 1, 1, 0x8005, 0xFFFF, 0x0000, 0x4B37 },
+    { "CRC-16/USB",         NULL,                 16, 1, 1, 0x8005, 0xFFFF, 0xFFFF, 0xB4C8 },
+    { "CRC-16/IBM-SDLC",    "CRC-16/X-25",        16, 1, 1, 0x1021, 0xFFFF, 0xFFFF, 0x906E },
+    { "CRC-24/OPENPGP",     NULL,                 24, 0, 0, 0x864CFB, 0xB704CE, 0x000000, 0x21CF02 },
+    { "CRC-32/ISO-HDLC",    "CRC-32",             32, 1, 1, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, 0xCBF43926 },
+    { "CRC-32/ISCSI",       "CRC-32C",            32, 1, 1, 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, 0xE3069283 },
+    { "CRC-32/BZIP2",       "CRC-32/AAL5",        32, 0, 0, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, 0xFC891918 },
+    { "CRC-32/MPEG-2",      NULL,                 32, 0, 0, 0x04C11DB7, 0xFFFFFFFF, 0x00000000, 0x0376E6E7 },
+    { "CRC-32/CKSUM",       "CRC-32/POSIX",       32, 0, 0, 0x04C11DB7, 0x00000000, 0xFFFFFFFF, 0x765E7680 },
+    { "CRC-64/ECMA-182",    "CRC-64",             64, 0, 0, 0x42F0E1EBA9EA3693ULL, 0, 0, 0x6C40DF5F0B497347ULL },
+    { "CRC-64/XZ",          "CRC-64/GO-ECMA",     64, 1, 1, 0x42F0E1EBA9EA3693ULL, ONES, ONES, 0x995DC9BBDF1939FAULL },
+    { "CRC-64/WE",          NULL,                 64, 0, 0, 0x42F0E1EBA9EA3693ULL, ONES, ONES, 0x62EC59E3F1A4F00AULL },
+    { "CRC-64/GO-ISO",      NULL,                 64, 1, 1, 0x000000000000001BULL, ONES, ONES, 0xB90956C775A41001ULL },
+    { "CRC-64/NVME",        NULL,                 64, 1, 1, 0xAD93D23594C93659ULL, ONES, ONES, 0xAE8B14860A799888ULL },
+};
+
+#define MODELS       ((int)(sizeof(models) / sizeof(models[0])))
+#define MODEL_SLICES 8
+
+static uint64_t model_table[MODELS][MODEL_SLICES][256];
+static uint64_t model_x2n[MODELS][64];
+static uint64_t model_fold[MODELS][FOLD_LEVELS][2];
+
+static uint64_t reflect(uint64_t v, int width) {
+    return bitrev64(v) >> (64 - width);
+}
+
+static uint64_t width_mask(int width) {
+    return width == 64 ? ~0ULL : (1ULL << width) - 1;
+}
+
+/* The textbook bit-at-a-time CRC, the reference the tables are checked against */
+static uint64_t model_bitwise(const struct model *m, const uint8_t *p, size_t len) {
+    uint64_t top = 1ULL << (m->width - 1), mask = width_mask(m->width), crc = m->init;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = m->refin ? (uint8_t)(bitrev64(p[i]) >> 56) : p[i];
+        for (int j = 7; j >= 0; j--) {
+            int bit = ((crc & top) != 0) ^ ((b >> j) & 1);
+            crc = (crc << 1) & mask;
+            if (bit) crc ^= m->poly;
+        }
+    }
+    if (m->refout) crc = reflect(crc, m->width);
+    return (crc ^ m->xorout) & mask;
+}
+
+/*
+    Reflected models keep the register in the low bits, LSB first, like
+    CRC-32C. The others keep it in the top bits of 64, MSB first, like
+    CRC-64, so one kernel serves every width.
+*/
+static void init_model(int i) {
+    const struct model *m = &models[i];
+    uint64_t (*t)[256] = model_table[i];
+
+    for (int b = 0; b < 256; b++) {
+        uint64_t crc;
+        if (m->refin) {
+            uint64_t rpoly = reflect(m->poly, m->width);
+            crc = (uint64_t)b;
+            for (int j = 0; j < 8; j++)
+                crc = (crc & 1) ? (crc >> 1) ^ rpoly : crc >> 1;
+        } else {
+            uint64_t lpoly = m->poly << (64 - m->width);
+            crc = (uint64_t)b << 56;
+            for (int j = 0; j < 8; j++)
+                crc = (crc & 0x8000000000000000ULL) ? (crc << 1) ^ lpoly : crc << 1;
+        }
+        t[0][b] = crc;
+    }
+    for (int k = 1; k < MODEL_SLICES; k++)
+        for (int b = 0; b < 256; b++) {
+            uint64_t crc = t[k - 1][b];
+            t[k][b] = m->refin ? (crc >> 8) ^ t[0][crc & 0xFF] : (crc << 8) ^ t[0][crc >> 56];
+        }
+
+    uint64_t p = 2;  /* x^1 */
+    model_x2n[i][0] = p;
+    for (int n = 1; n < 64; n++)
+        model_x2n[i][n] = p = crc_msb_multmodp(p, p, m->poly, m->width);
+
+    init_fold_consts(model_fold[i], m->poly, m->width, m->refin);
+}
+
+/* The table CRC of "123456789" against the bit loop and the catalogue value */
+static int check_model(int i) {
+    const struct model *m = &models[i];
+    const uint8_t *s = (const uint8_t *)"123456789";
+    int w = m->width;
+    uint64_t crc = m->refin ? reflect(m->init, w) : m->init << (64 - w);
+    for (int j = 0; j < 9; j++)
+        crc = m->refin ? (crc >> 8) ^ model_table[i][0][(crc ^ s[j]) & 0xFF]
+                       : (crc << 8) ^ model_table[i][0][(crc >> 56) ^ s[j]];
+    if (!m->refin) crc >>= 64 - w;
+    if (m->refin != m->refout) crc = reflect(crc, w);
+    crc ^= m->xorout;
+
+    if (crc != m->check || model_bitwise(m, s, 9) != m->check) {
+        fprintf(stderr, "gen_tables: %s: check %llX, expected %llX\n", m->name,
+                (unsigned long long)crc, (unsigned long long)m->check);
+        return -1;
+    }
+    return 0;
+}
+
+/* ================= OUTPUT ================= */
+/* n values of size bytes, per_line to a line */
+static void print_row(const char *indent, const void *v, int size, int n, int per_line) {
+    for (int i = 0; i < n; i++) {
+        uint64_t x = size == 2 ? ((const uint16_t *)v)[i]
+                   : size == 4 ? ((const uint32_t *)v)[i]
+                   : ((const uint64_t *)v)[i];
+        if (i % per_line == 0) fputs(indent, stdout);
+        printf("0x%0*llX%s", size * 2, (unsigned long long)x,
+               size == 8 ? "ULL" : size == 4 ? "u" : "");
+        if (i + 1 < n) putchar(',');
+        putchar(i % per_line == per_line - 1 || i + 1 == n ? '\n' : ' ');
+    }
+}
+
+static void print_slices(const char *type, const char *name, const void *t, int size) {
+    int per_line = size == 8 ? 4 : 8;
+    printf("\nstatic const %s %s[CRC_SLICES][256] = {\n", type, name);
+    for (int k = 0; k < CRC_SLICES; k++) {
+        printf("    {\n");
+        print_row("        ", (const uint8_t *)t + (size_t)k * 256 * size, size, 256, per_line);
+        printf("    }%s\n", k + 1 < CRC_SLICES ? "," : "");
+    }
+    printf("};\n");
+}
+
+static void print_x2n(const char *type, const char *name, const void *t, int size) {
+    printf("\nstatic const %s %s[64] = {\n", type, name);
+    print_row("    ", t, size, 64, 4);
+    printf("};\n");
+}
+
+/* An initializer for struct fold_consts, which libcrc.c defines */
+static void print_fold(const char *name, const uint64_t k[FOLD_LEVELS][2]) {
+    printf("\n#define %s { { \\\n", name);
+    for (int i = 0; i < FOLD_LEVELS; i++)
+        printf("    { 0x%016llXULL, 0x%016llXULL }%s \\\n",
+               (unsigned long long)k[i][0], (unsigned long long)k[i][1], i + 1 < FOLD_LEVELS ? "," : "");
+    printf("} }\n");
+}
+
+static void print_hex(uint64_t v) {
+    printf("0x%llXULL", (unsigned long long)v);
+}
+
+static void print_models(void) {
+    printf("\n/* ---------- CRC catalogue ---------- */\n");
+    printf("#define CRC_MODELS %d\n#define CRC_MODEL_SLICES %d\n", MODELS, MODEL_SLICES);
+
+    printf("\n/* An initializer for struct crc_model crc_models[CRC_MODELS] */\n");
+    printf("#define CRC_MODEL_LIST { \\\n");
+    for (int i = 0; i < MODELS; i++) {
+        const struct model *m = &models[i];
+        printf("    { \"%s\", ", m->name);
+        if (m->alias) printf("\"%s\", ", m->alias);
+        else printf("NULL, ");
+        printf("%d, %d, %d, ", m->width, m->refin, m->refout);
+        print_hex(m->poly); printf(", ");
+        print_hex(m->init); printf(", ");
+        print_hex(m->xorout); printf(", ");
+        print_hex(m->check);
+        printf(" }%s \\\n", i + 1 < MODELS ? "," : "");
+    }
+    printf("}\n");
+
+    printf("\nstatic const uint64_t crc_model_table[CRC_MODELS][CRC_MODEL_SLICES][256] = {\n");
+    for (int i = 0; i < MODELS; i++) {
+        printf("    /* %s */\n    {\n", models[i].name);
+        for (int k = 0; k < MODEL_SLICES; k++) {
+            printf("        {\n");
+            print_row("            ", model_table[i][k], 8, 256, 4);
+            printf("        }%s\n", k + 1 < MODEL_SLICES ? "," : "");
+        }
+        printf("    }%s\n", i + 1 < MODELS ? "," : "");
+    }
+    printf("};\n");
+
+    printf("\nstatic const uint64_t crc_model_x2n_table[CRC_MODELS][64] = {\n");
+    for (int i = 0; i < MODELS; i++) {
+        printf("    /* %s */\n    {\n", models[i].name);
+        print_row("        ", model_x2n[i], 8, 64, 4);
+        printf("    }%s\n", i + 1 < MODELS ? "," : "");
+    }
+    printf("};\n");
+
+    printf("\n/* An initializer for struct fold_consts crc_model_fold[CRC_MODELS] */\n");
+    printf("#define CRC_MODEL_FOLD_CONSTS { \\\n");
+    for (int i = 0; i < MODELS; i++) {
+        printf("    { { /* %s */ \\\n", models[i].name);
+        for (int l = 0; l < FOLD_LEVELS; l++)
+            printf("        { 0x%016llXULL, 0x%016llXULL }%s \\\n", (unsigned long long)model_fold[i][l][0],
+                   (unsigned long long)model_fold[i][l][1], l + 1 < FOLD_LEVELS ? "," : "");
+        printf("    } }%s \\\n", i + 1 < MODELS ? "," : "");
+    }
+    printf("}\n");
+}
+
+int main(void) {
+    init_crc64();
+    init_crc32();
+    init_crc16();
+    init_crc_combine();
+    init_fold_consts(crc16_fold, CRC16_POLY, 16, 0);
+    init_fold_consts(crc32_fold, CRC32C_POLY, 32, 1);
+    init_fold_consts(crc64_fold, CRC64_POLY, 64, 0);
+    for (int i = 0; i < MODELS; i++) {
+        init_model(i);
+        if (check_model(i)) return EXIT_FAILURE;
+    }
+
+    printf("/* crc_tables.h: generated by gen_tables.c, do not edit. Rebuild with make tables */\n");
+    printf("#ifndef CRC_TABLES_H\n#define CRC_TABLES_H\n\n");
+    printf("#if CRC_SLICES != %d\n", CRC_SLICES);
+    printf("#error \"crc_tables.h holds %d slicing tables, run make tables\"\n#endif\n", CRC_SLICES);
+    printf("#if CRC16_POLY != 0x%X || CRC32C_POLY != 0x%X || CRC64_POLY != 0x%llXULL\n",
+           CRC16_POLY, CRC32C_POLY, (unsigned long long)CRC64_POLY);
+    printf("#error \"crc_tables.h was generated for other polynomials, run make tables\"\n#endif\n\n");
+    printf("#define CRC_TABLES_FOLD_LEVELS %d\n", FOLD_LEVELS);
+
+    printf("\n/* ---------- slicing tables ---------- */\n");
+    print_slices("uint64_t", "crc64_table", crc64_table, 8);
+    print_slices("uint32_t", "crc32_table", crc32_table, 4);
+    print_slices("uint16_t", "crc16_table", crc16_table, 2);
+
+    printf("\n/* ---------- x^(2^n) mod P, for crcN_shift ---------- */\n");
+    print_x2n("uint32_t", "crc32_x2n_table", crc32_x2n_table, 4);
+    print_x2n("uint64_t", "crc16_x2n_table", crc16_x2n_table, 8);
+    print_x2n("uint64_t", "crc64_x2n_table", crc64_x2n_table, 8);
+
+    printf("\n/* ---------- folding constants, per FOLD_128 ... FOLD_2048 ---------- */\n");
+    print_fold("CRC16_FOLD_CONSTS", crc16_fold);
+    print_fold("CRC32_FOLD_CONSTS", crc32_fold);
+    print_fold("CRC64_FOLD_CONSTS", crc64_fold);
+
+    print_models();
+
+    printf("\n#endif\n");
+    return ferror(stdout) ? 1 : 0;
+}
@@ -0,0 +1,2289 @@
+/*
+
+libcrc. Copyright (C) 2026 Ino Jacob. All rights reserved.
+
+Hashing engines of CRC Checker: table, SSE4.2, PCLMUL and VPCLMULQDQ CRCs
+on x86, CRC32 instruction and PMULL CRCs on aarch64, reference xxHash64 /
+XXH3 with SIMD accumulators, the runtime dispatcher and the single-pass
+multi-hash kernels. Other architectures get the portable table and scalar
+kernels. The API is in libcrc.h, the revision history in crc.c.
+
+Compilation:
+
+    make
+
+    or,
+
+    gcc -O3 -fPIC -fvisibility=hidden -pthread -c libcrc.c
+
+    -DLIBCRC_PORTABLE leaves out every architecture specific kernel.
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#if defined(LIBCRC_PORTABLE)
+/* tables and scalar code only */
+#elif defined(__x86_64__) || defined(__i386__)
+#define LIBCRC_X86 1
+#include <immintrin.h>
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define LIBCRC_ARM64 1
+#include <arm_neon.h>
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
+
+#include "libcrc.h"
+
+/* ================= CRC POLYNOMIALS ================= */
+#define CRC16_POLY  0x1021u
+#define CRC32C_POLY 0x1EDC6F41u
+#define CRC32_POLY  0x04C11DB7u     /* CRC-32/ISO-HDLC, a catalogue model */
+#define CRC64_POLY  0x42F0E1EBA9EA3693ULL
+
+/* ================= CRC TABLES ================= */
+/*
+    Table 0 is the classic byte table, table k is a byte followed by k zero
+    bytes. The tables, the combine tables and the folding constants are
+    generated at build time by gen_tables.c (make tables), so they sit in
+    .rodata, shared by every process and never written.
+*/
+#define CRC_SLICES 16
+#include "crc_tables.h"
+
+/* ================= ISA TARGETS ================= */
+/*
+    Kernels are compiled for their ISA with target attributes, so the binary
+    itself can be built for baseline x86-64 (or armv8-a) and still carry
+    every variant. The dispatcher below only calls a variant the CPU
+    actually supports.
+*/
+#if LIBCRC_X86
+#define TARGET_SSE2       __attribute__((target("sse2")))
+#define TARGET_SSE42      __attribute__((target("sse4.2")))
+#define TARGET_PCLMUL     __attribute__((target("sse4.2,ssse3,pclmul")))
+#define TARGET_AVX2       __attribute__((target("avx2")))
+#define TARGET_AVX512     __attribute__((target("avx512f,avx512bw,avx512vl")))
+#define TARGET_VPCLMUL256 __attribute__((target("avx2,sse4.2,pclmul,vpclmulqdq")))
+#define TARGET_VPCLMUL512 __attribute__((target("avx512f,avx512bw,avx512vl,sse4.2,pclmul,vpclmulqdq")))
+#elif LIBCRC_ARM64
+/* GCC takes "+ext" extension strings, clang the feature names */
+#if defined(__clang__)
+#define TARGET_ARMCRC     __attribute__((target("crc")))
+#define TARGET_PMULL      __attribute__((target("crc,aes")))
+#else
+#define TARGET_ARMCRC     __attribute__((target("+crc")))
+#define TARGET_PMULL      __attribute__((target("+crc+crypto")))
+#endif
+#endif
+
+/* ================= SIMD CRC32 ================= */
+#if LIBCRC_X86
+TARGET_SSE42 static uint32_t crc32_simd(uint32_t crc, const uint8_t *buf, size_t len) {
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, buf, sizeof(w));
+        crc = (uint32_t)_mm_crc32_u64(crc, w);
+        buf += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = _mm_crc32_u8(crc, *buf++);
+    return crc;
+}
+#elif LIBCRC_ARM64
+/* The ARMv8 CRC32 instructions, CRC-32C here and CRC-32/ISO-HDLC for the catalogue */
+TARGET_ARMCRC static uint32_t crc32_armv8(uint32_t crc, const uint8_t *buf, size_t len) {
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, buf, sizeof(w));
+        crc = __crc32cd(crc, w);
+        buf += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = __crc32cb(crc, *buf++);
+    return crc;
+}
+
+TARGET_ARMCRC static uint32_t crc32_iso_armv8(uint32_t crc, const uint8_t *buf, size_t len) {
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, buf, sizeof(w));
+        crc = __crc32d(crc, w);
+        buf += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = __crc32b(crc, *buf++);
+    return crc;
+}
+#endif
+
+/* ================= CRC COMBINE (GF(2)) ================= */
+/*
+    crcN_shift(crc, n) advances a raw CRC register over n zero bytes, the
+    same as crcN_hash(crc, zeros, n) but in O(log n): crc * x^(8n) mod P.
+    crcN_combine(crc(A), crc(B), len(B)) gives crc(A || B) from the final
+    CRC values, so per-part CRCs can be merged without the data.
+
+    crc32(A || B) = crc32(A) * x^(8 * len(B)) mod P  xor  crc32(B)
+    Init and final xor are both 0xFFFFFFFF, so they cancel out.
+*/
+#define CRC32C_POLY_REFLECTED 0x82F63B78u
+
+/* a * b mod P, both in reflected bit order. a must not be zero */
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31, p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC32C_POLY_REFLECTED : b >> 1;
+    }
+    return p;
+}
+
+/* x^(n * 2^k) mod P */
+static uint32_t crc32_x2nmodp(uint64_t n, unsigned k) {
+    uint32_t p = 1u << 31;  /* x^0 */
+    while (n) {
+        if (n & 1) p = crc32_multmodp(crc32_x2n_table[k & 63], p);
+        n >>= 1;
+        k++;
+    }
+    return p;
+}
+
+uint32_t crc32_shift(uint32_t crc, uint64_t len) {
+    return crc32_multmodp(crc32_x2nmodp(len, 3), crc);
+}
+
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2) {
+    return crc32_shift(crc1, len2) ^ crc2;
+}
+
+/*
+    CRC-16 and CRC-64 are MSB-first, with init I and no final xor:
+    crc(A || B) = (crc(A) ^ I) * x^(8 * len(B)) mod P  xor  crc(B)
+    CRC-64 starts at 0, so it reduces to the plain form above.
+*/
+/* a * b mod P in normal (MSB-first) bit order, polynomials up to 64 bits */
+static uint64_t crc_msb_multmodp(uint64_t a, uint64_t b, uint64_t poly, int width) {
+    uint64_t top = 1ULL << (width - 1);
+    uint64_t mask = width == 64 ? ~0ULL : (top << 1) - 1;
+    uint64_t p = 0;
+    for (int i = width - 1; i >= 0; i--) {
+        int carry = (p & top) != 0;
+        p = (p << 1) & mask;
+        if (carry) p ^= poly;
+        if ((a >> i) & 1) p ^= b;
+    }
+    return p;
+}
+
+static uint64_t crc_msb_x2nmodp(const uint64_t *table, uint64_t n, unsigned k, uint64_t poly, int width) {
+    uint64_t p = 1;  /* x^0 */
+    while (n) {
+        if (n & 1) p = crc_msb_multmodp(table[k & 63], p, poly, width);
+        n >>= 1;
+        k++;
+    }
+    return p;
+}
+
+uint16_t crc16_shift(uint16_t crc, uint64_t len) {
+    uint64_t x = crc_msb_x2nmodp(crc16_x2n_table, len, 3, CRC16_POLY, 16);
+    return (uint16_t)crc_msb_multmodp(x, crc, CRC16_POLY, 16);
+}
+
+uint64_t crc64_shift(uint64_t crc, uint64_t len) {
+    uint64_t x = crc_msb_x2nmodp(crc64_x2n_table, len, 3, CRC64_POLY, 64);
+    return crc_msb_multmodp(x, crc, CRC64_POLY, 64);
+}
+
+uint16_t crc16_combine(uint16_t crc1, uint16_t crc2, uint64_t len2) {
+    return (uint16_t)(crc16_shift(crc1 ^ 0xFFFFu, len2) ^ crc2);
+}
+
+uint64_t crc64_combine(uint64_t crc1, uint64_t crc2, uint64_t len2) {
+    return crc64_shift(crc1, len2) ^ crc2;
+}
+
+/* ================= SLICING CRC16 / CRC32 / CRC64 ================= */
+/*
+    CRC-16 and CRC-64 are MSB-first, so the data is loaded big-endian and byte
+    j of an n-byte step is looked up in table (n - 1 - j). CRC-32C is
+    reflected and loads little-endian. The CRC register is xored into the
+    first bytes of the step. These are also the scalar fallbacks of the
+    dispatcher.
+*/
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint64_t load_le64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint16_t crc16_byte(uint16_t crc, uint8_t b) {
+    return crc16_table[0][(crc >> 8) ^ b] ^ (uint16_t)(crc << 8);
+}
+
+static inline uint64_t crc64_byte(uint64_t crc, uint8_t b) {
+    return (crc << 8) ^ crc64_table[0][(crc >> 56) ^ b];
+}
+
+static inline uint32_t crc32_byte(uint32_t crc, uint8_t b) {
+    return (crc >> 8) ^ crc32_table[0][(crc ^ b) & 0xFF];
+}
+
+static inline uint32_t crc32_step16(uint32_t crc, const uint8_t *p) {
+    uint64_t a = load_le64(p) ^ crc;
+    uint64_t b = load_le64(p + 8);
+    return crc32_table[15][a & 0xFF]         ^ crc32_table[14][(a >> 8) & 0xFF] ^
+           crc32_table[13][(a >> 16) & 0xFF] ^ crc32_table[12][(a >> 24) & 0xFF] ^
+           crc32_table[11][(a >> 32) & 0xFF] ^ crc32_table[10][(a >> 40) & 0xFF] ^
+           crc32_table[9][(a >> 48) & 0xFF]  ^ crc32_table[8][a >> 56] ^
+           crc32_table[7][b & 0xFF]          ^ crc32_table[6][(b >> 8) & 0xFF] ^
+           crc32_table[5][(b >> 16) & 0xFF]  ^ crc32_table[4][(b >> 24) & 0xFF] ^
+           crc32_table[3][(b >> 32) & 0xFF]  ^ crc32_table[2][(b >> 40) & 0xFF] ^
+           crc32_table[1][(b >> 48) & 0xFF]  ^ crc32_table[0][b >> 56];
+}
+
+static inline uint16_t crc16_step16(uint16_t crc, const uint8_t *p) {
+    uint64_t a = load_be64(p) ^ ((uint64_t)crc << 48);
+    uint64_t b = load_be64(p + 8);
+    return crc16_table[15][a >> 56]          ^ crc16_table[14][(a >> 48) & 0xFF] ^
+           crc16_table[13][(a >> 40) & 0xFF] ^ crc16_table[12][(a >> 32) & 0xFF] ^
+           crc16_table[11][(a >> 24) & 0xFF] ^ crc16_table[10][(a >> 16) & 0xFF] ^
+           crc16_table[9][(a >> 8) & 0xFF]   ^ crc16_table[8][a & 0xFF] ^
+           crc16_table[7][b >> 56]           ^ crc16_table[6][(b >> 48) & 0xFF] ^
+           crc16_table[5][(b >> 40) & 0xFF]  ^ crc16_table[4][(b >> 32) & 0xFF] ^
+           crc16_table[3][(b >> 24) & 0xFF]  ^ crc16_table[2][(b >> 16) & 0xFF] ^
+           crc16_table[1][(b >> 8) & 0xFF]   ^ crc16_table[0][b & 0xFF];
+}
+
+static inline uint64_t crc64_step16(uint64_t crc, const uint8_t *p) {
+    uint64_t a = load_be64(p) ^ crc;
+    uint64_t b = load_be64(p + 8);
+    return crc64_table[15][a >> 56]          ^ crc64_table[14][(a >> 48) & 0xFF] ^
+           crc64_table[13][(a >> 40) & 0xFF] ^ crc64_table[12][(a >> 32) & 0xFF] ^
+           crc64_table[11][(a >> 24) & 0xFF] ^ crc64_table[10][(a >> 16) & 0xFF] ^
+           crc64_table[9][(a >> 8) & 0xFF]   ^ crc64_table[8][a & 0xFF] ^
+           crc64_table[7][b >> 56]           ^ crc64_table[6][(b >> 48) & 0xFF] ^
+           crc64_table[5][(b >> 40) & 0xFF]  ^ crc64_table[4][(b >> 32) & 0xFF] ^
+           crc64_table[3][(b >> 24) & 0xFF]  ^ crc64_table[2][(b >> 16) & 0xFF] ^
+           crc64_table[1][(b >> 8) & 0xFF]   ^ crc64_table[0][b & 0xFF];
+}
+
+static uint16_t crc16_update(uint16_t crc, const uint8_t *buf, size_t len) {
+    for (; len >= 16; buf += 16, len -= 16)
+        crc = crc16_step16(crc, buf);
+    while (len--)
+        crc = crc16_byte(crc, *buf++);
+    return crc;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *buf, size_t len) {
+    for (; len >= 16; buf += 16, len -= 16)
+        crc = crc32_step16(crc, buf);
+    while (len--)
+        crc = crc32_byte(crc, *buf++);
+    return crc;
+}
+
+static uint64_t crc64_update(uint64_t crc, const uint8_t *buf, size_t len) {
+    for (; len >= 16; buf += 16, len -= 16)
+        crc = crc64_step16(crc, buf);
+    while (len--)
+        crc = crc64_byte(crc, *buf++);
+    return crc;
+}
+
+/* One byte per step through table 0: no setup at all, for tiny inputs */
+static uint16_t crc16_bytewise(uint16_t crc, const uint8_t *buf, size_t len) {
+    while (len--)
+        crc = crc16_byte(crc, *buf++);
+    return crc;
+}
+
+static uint32_t crc32_bytewise(uint32_t crc, const uint8_t *buf, size_t len) {
+    while (len--)
+        crc = crc32_byte(crc, *buf++);
+    return crc;
+}
+
+static uint64_t crc64_bytewise(uint64_t crc, const uint8_t *buf, size_t len) {
+    while (len--)
+        crc = crc64_byte(crc, *buf++);
+    return crc;
+}
+
+/* ================= PCLMUL / PMULL FOLDING (CRC16 / CRC32 / CRC64) ================= */
+/*
+    Carry-less multiply folding, one generic engine for all three CRCs.
+
+    The data is viewed as a string of 128-bit chunks. An accumulator is moved
+    D bits further down the message by multiplying its two 64-bit halves with
+    x^(D+64) mod P and x^D mod P, then xoring the next chunk in. This keeps the
+    accumulator congruent to the message modulo P. At the end the 128-bit
+    residue is run through the table/hardware CRC as 16 plain bytes with a zero
+    register, which is the same as reducing it modulo P.
+
+    MSB-first CRCs (CRC-16, CRC-64) byte swap each chunk so bit 127 is the first
+    message bit. Reflected CRCs (CRC-32C) use the chunk as loaded, the halves
+    swap roles and every constant is taken one power lower because a reflected
+    carry-less product comes out shifted by one bit.
+
+    The CRC register is xored into the first chunk, so the kernels continue an
+    existing CRC and can be called block by block. PCLMULQDQ and PMULL put
+    the product the same way round, so both share the constants.
+*/
+#define FOLD_LEVELS  5      /* 128, 256, 512, 1024, 2048 bits */
+#define FOLD_128     0
+#define FOLD_256     1
+#define FOLD_512     2
+#define FOLD_1024    3
+#define FOLD_2048    4
+#define FOLD_MIN_LEN 256    /* below this the table / crc32 instruction wins */
+
+struct fold_consts {
+    uint64_t k[FOLD_LEVELS][2];     /* { multiplier for qword 0, multiplier for qword 1 } */
+};
+
+#if FOLD_LEVELS != CRC_TABLES_FOLD_LEVELS
+#error "crc_tables.h holds other fold levels, run make tables"
+#endif
+
+#if LIBCRC_X86 || LIBCRC_ARM64
+static const struct fold_consts crc16_fold = CRC16_FOLD_CONSTS;
+static const struct fold_consts crc32_fold = CRC32_FOLD_CONSTS;
+static const struct fold_consts crc64_fold = CRC64_FOLD_CONSTS;
+#endif
+
+#if LIBCRC_X86
+/* ---------- 128-bit PCLMULQDQ ---------- */
+TARGET_PCLMUL static inline __m128i bswap128(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+TARGET_PCLMUL static inline __m128i fold_load128(const uint8_t *p, const int msb) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    return msb ? bswap128(v) : v;
+}
+
+TARGET_PCLMUL static inline __m128i fold128(__m128i x, __m128i k) {
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+TARGET_PCLMUL static inline __m128i fold_kvec(const struct fold_consts *c, int level) {
+    return _mm_set_epi64x((long long)c->k[level][1], (long long)c->k[level][0]);
+}
+
+/*
+    8 accumulators, 128 bytes per iteration. len must be a multiple of 16 and
+    at least 128. Returns the 128-bit residue in the chunk layout.
+*/
+TARGET_PCLMUL static inline __attribute__((always_inline))
+__m128i fold_pclmul(const struct fold_consts *c, __m128i init, const uint8_t *buf, size_t len, const int msb) {
+    __m128i x[8];
+    for (int i = 0; i < 8; i++)
+        x[i] = fold_load128(buf + 16 * i, msb);
+    x[0] = _mm_xor_si128(x[0], init);
+    buf += 128;
+    len -= 128;
+
+    const __m128i k1024 = fold_kvec(c, FOLD_1024);
+    for (; len >= 128; buf += 128, len -= 128)
+        for (int i = 0; i < 8; i++)
+            x[i] = _mm_xor_si128(fold128(x[i], k1024), fold_load128(buf + 16 * i, msb));
+
+    const __m128i k128 = fold_kvec(c, FOLD_128);
+    __m128i acc = x[0];
+    for (int i = 1; i < 8; i++)
+        acc = _mm_xor_si128(fold128(acc, k128), x[i]);
+    for (; len >= 16; buf += 16, len -= 16)
+        acc = _mm_xor_si128(fold128(acc, k128), fold_load128(buf, msb));
+
+    return acc;
+}
+
+/* ---------- 256-bit VPCLMULQDQ (AVX2) ---------- */
+TARGET_VPCLMUL256 static inline __m256i fold_load256(const uint8_t *p, const int msb) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    if (msb)
+        v = _mm256_shuffle_epi8(v, _mm256_broadcastsi128_si256(
+                _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+    return v;
+}
+
+TARGET_VPCLMUL256 static inline __m256i fold256_xor(__m256i x, __m256i k, __m256i y) {
+    return _mm256_xor_si256(_mm256_xor_si256(_mm256_clmulepi64_epi128(x, k, 0x00),
+                                             _mm256_clmulepi64_epi128(x, k, 0x11)), y);
+}
+
+/* 4 x 256-bit accumulators, 128 bytes per iteration. len multiple of 16, >= 128 */
+TARGET_VPCLMUL256 static inline __attribute__((always_inline))
+__m128i fold_vpclmul256(const struct fold_consts *c, __m128i init, const uint8_t *buf, size_t len, const int msb) {
+    if (len < 512)
+        return fold_pclmul(c, init, buf, len, msb);
+
+    __m256i y0 = fold_load256(buf, msb);
+    __m256i y1 = fold_load256(buf + 32, msb);
+    __m256i y2 = fold_load256(buf + 64, msb);
+    __m256i y3 = fold_load256(buf + 96, msb);
+    y0 = _mm256_xor_si256(y0, _mm256_zextsi128_si256(init));
+    buf += 128;
+    len -= 128;
+
+    const __m256i k1024 = _mm256_broadcastsi128_si256(fold_kvec(c, FOLD_1024));
+    for (; len >= 128; buf += 128, len -= 128) {
+        y0 = fold256_xor(y0, k1024, fold_load256(buf, msb));
+        y1 = fold256_xor(y1, k1024, fold_load256(buf + 32, msb));
+        y2 = fold256_xor(y2, k1024, fold_load256(buf + 64, msb));
+        y3 = fold256_xor(y3, k1024, fold_load256(buf + 96, msb));
+    }
+
+    const __m256i k256 = _mm256_broadcastsi128_si256(fold_kvec(c, FOLD_256));
+    y0 = fold256_xor(y0, k256, y1);
+    y0 = fold256_xor(y0, k256, y2);
+    y0 = fold256_xor(y0, k256, y3);
+    for (; len >= 32; buf += 32, len -= 32)
+        y0 = fold256_xor(y0, k256, fold_load256(buf, msb));
+
+    const __m128i k128 = fold_kvec(c, FOLD_128);
+    __m128i acc = _mm256_castsi256_si128(y0);
+    acc = _mm_xor_si128(fold128(acc, k128), _mm256_extracti128_si256(y0, 1));
+    for (; len >= 16; buf += 16, len -= 16)
+        acc = _mm_xor_si128(fold128(acc, k128), fold_load128(buf, msb));
+
+    return acc;
+}
+
+/* ---------- 512-bit VPCLMULQDQ (AVX-512) ---------- */
+TARGET_VPCLMUL512 static inline __m512i fold_load512(const uint8_t *p, const int msb) {
+    __m512i v = _mm512_loadu_si512((const void *)p);
+    if (msb)
+        v = _mm512_shuffle_epi8(v, _mm512_broadcast_i32x4(
+                _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+    return v;
+}
+
+/* (x folded) ^ y in one ternary-logic op */
+TARGET_VPCLMUL512 static inline __m512i fold512_xor(__m512i x, __m512i k, __m512i y) {
+    return _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x00),
+                                     _mm512_clmulepi64_epi128(x, k, 0x11), y, 0x96);
+}
+
+/* 4 x 512-bit accumulators, 256 bytes per iteration. len multiple of 16, >= 128 */
+TARGET_VPCLMUL512 static inline __attribute__((always_inline))
+__m128i fold_vpclmul512(const struct fold_consts *c, __m128i init, const uint8_t *buf, size_t len, const int msb) {
+    if (len < 1024)
+        return fold_pclmul(c, init, buf, len, msb);
+
+    __m512i z0 = fold_load512(buf, msb);
+    __m512i z1 = fold_load512(buf + 64, msb);
+    __m512i z2 = fold_load512(buf + 128, msb);
+    __m512i z3 = fold_load512(buf + 192, msb);
+    z0 = _mm512_xor_si512(z0, _mm512_zextsi128_si512(init));
+    buf += 256;
+    len -= 256;
+
+    const __m512i k2048 = _mm512_broadcast_i32x4(fold_kvec(c, FOLD_2048));
+    for (; len >= 256; buf += 256, len -= 256) {
+        z0 = fold512_xor(z0, k2048, fold_load512(buf, msb));
+        z1 = fold512_xor(z1, k2048, fold_load512(buf + 64, msb));
+        z2 = fold512_xor(z2, k2048, fold_load512(buf + 128, msb));
+        z3 = fold512_xor(z3, k2048, fold_load512(buf + 192, msb));
+    }
+
+    const __m512i k512 = _mm512_broadcast_i32x4(fold_kvec(c, FOLD_512));
+    z0 = fold512_xor(z0, k512, z1);
+    z0 = fold512_xor(z0, k512, z2);
+    z0 = fold512_xor(z0, k512, z3);
+    for (; len >= 64; buf += 64, len -= 64)
+        z0 = fold512_xor(z0, k512, fold_load512(buf, msb));
+
+    const __m128i k128 = fold_kvec(c, FOLD_128);
+    __m128i acc = _mm512_extracti32x4_epi32(z0, 0);
+    acc = _mm_xor_si128(fold128(acc, k128), _mm512_extracti32x4_epi32(z0, 1));
+    acc = _mm_xor_si128(fold128(acc, k128), _mm512_extracti32x4_epi32(z0, 2));
+    acc = _mm_xor_si128(fold128(acc, k128), _mm512_extracti32x4_epi32(z0, 3));
+    for (; len >= 16; buf += 16, len -= 16)
+        acc = _mm_xor_si128(fold128(acc, k128), fold_load128(buf, msb));
+
+    return acc;
+}
+
+/*
+    Per-ISA CRC entry points. The bulk (a multiple of 16 bytes) is folded, the
+    residue and the tail go through the tables, or the crc32 instruction for
+    CRC-32C.
+*/
+#define CRC_FOLD_KERNELS(isa, TARGET, fold)                                              \
+TARGET static uint16_t crc16_##isa(uint16_t crc, const uint8_t *buf, size_t len) {       \
+    if (len >= FOLD_MIN_LEN) {                                                          \
+        size_t n = len & ~(size_t)15;                                                   \
+        uint8_t r[16];                                                                  \
+        __m128i init = _mm_set_epi64x((long long)((uint64_t)crc << 48), 0);             \
+        _mm_storeu_si128((__m128i *)r, bswap128(fold(&crc16_fold, init, buf, n, 1)));   \
+        crc = crc16_update(0, r, 16);                                                   \
+        buf += n;                                                                       \
+        len -= n;                                                                       \
+    }                                                                                   \
+    return crc16_update(crc, buf, len);                                                 \
+}                                                                                       \
+TARGET static uint32_t crc32_##isa(uint32_t crc, const uint8_t *buf, size_t len) {       \
+    if (len >= FOLD_MIN_LEN) {                                                          \
+        size_t n = len & ~(size_t)15;                                                   \
+        uint8_t r[16];                                                                  \
+        __m128i init = _mm_cvtsi32_si128((int)crc);                                     \
+        _mm_storeu_si128((__m128i *)r, fold(&crc32_fold, init, buf, n, 0));             \
+        crc = crc32_simd(0, r, 16);                                                     \
+        buf += n;                                                                       \
+        len -= n;                                                                       \
+    }                                                                                   \
+    return crc32_simd(crc, buf, len);                                                   \
+}                                                                                       \
+TARGET static uint64_t crc64_##isa(uint64_t crc, const uint8_t *buf, size_t len) {       \
+    if (len >= FOLD_MIN_LEN) {                                                          \
+        size_t n = len & ~(size_t)15;                                                   \
+        uint8_t r[16];                                                                  \
+        __m128i init = _mm_set_epi64x((long long)crc, 0);                               \
+        _mm_storeu_si128((__m128i *)r, bswap128(fold(&crc64_fold, init, buf, n, 1)));   \
+        crc = crc64_update(0, r, 16);                                                   \
+        buf += n;                                                                       \
+        len -= n;                                                                       \
+    }                                                                                   \
+    return crc64_update(crc, buf, len);                                                 \
+}
+
+CRC_FOLD_KERNELS(pclmul, TARGET_PCLMUL,     fold_pclmul)
+CRC_FOLD_KERNELS(avx2,   TARGET_VPCLMUL256, fold_vpclmul256)
+CRC_FOLD_KERNELS(avx512, TARGET_VPCLMUL512, fold_vpclmul512)
+
+#elif LIBCRC_ARM64
+/* ---------- 128-bit PMULL (aarch64) ---------- */
+TARGET_PMULL static inline uint64x2_t bswap128_neon(uint64x2_t v) {
+    uint8x16_t b = vrev64q_u8(vreinterpretq_u8_u64(v));
+    return vreinterpretq_u64_u8(vextq_u8(b, b, 8));
+}
+
+TARGET_PMULL static inline uint64x2_t fold_load_neon(const uint8_t *p, const int msb) {
+    uint64x2_t v = vreinterpretq_u64_u8(vld1q_u8(p));
+    return msb ? bswap128_neon(v) : v;
+}
+
+TARGET_PMULL static inline uint64x2_t fold_neon(uint64x2_t x, uint64x2_t k) {
+    poly64x2_t px = vreinterpretq_p64_u64(x), pk = vreinterpretq_p64_u64(k);
+    uint64x2_t lo = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_p64(px, 0), vgetq_lane_p64(pk, 0)));
+    uint64x2_t hi = vreinterpretq_u64_p128(vmull_high_p64(px, pk));
+    return veorq_u64(lo, hi);
+}
+
+/* { qword 0, qword 1 } as one register */
+TARGET_PMULL static inline uint64x2_t fold_pair_neon(uint64_t lo, uint64_t hi) {
+    return vcombine_u64(vcreate_u64(lo), vcreate_u64(hi));
+}
+
+/* fold_pclmul() on PMULL: 8 accumulators, len a multiple of 16 and at least 128 */
+TARGET_PMULL static inline __attribute__((always_inline))
+uint64x2_t fold_pmull(const struct fold_consts *c, uint64x2_t init, const uint8_t *buf, size_t len, const int msb) {
+    uint64x2_t x[8];
+    for (int i = 0; i < 8; i++)
+        x[i] = fold_load_neon(buf + 16 * i, msb);
+    x[0] = veorq_u64(x[0], init);
+    buf += 128;
+    len -= 128;
+
+    const uint64x2_t k1024 = vld1q_u64(c->k[FOLD_1024]);
+    for (; len >= 128; buf += 128, len -= 128)
+        for (int i = 0; i < 8; i++)
+            x[i] = veorq_u64(fold_neon(x[i], k1024), fold_load_neon(buf + 16 * i, msb));
+
+    const uint64x2_t k128 = vld1q_u64(c->k[FOLD_128]);
+    uint64x2_t acc = x[0];
+    for (int i = 1; i < 8; i++)
+        acc = veorq_u64(fold_neon(acc, k128), x[i]);
+    for (; len >= 16; buf += 16, len -= 16)
+        acc = veorq_u64(fold_neon(acc, k128), fold_load_neon(buf, msb));
+
+    return acc;
+}
+
+/* The residue leaves in message byte order, as 16 bytes for the table / crc32 instruction */
+TARGET_PMULL static inline void fold_store_neon(uint8_t r[16], uint64x2_t v, const int msb) {
+    vst1q_u8(r, vreinterpretq_u8_u64(msb ? bswap128_neon(v) : v));
+}
+
+TARGET_PMULL static uint16_t crc16_pmull(uint16_t crc, const uint8_t *buf, size_t len) {
+    if (len >= FOLD_MIN_LEN) {
+        size_t n = len & ~(size_t)15;
+        uint8_t r[16];
+        fold_store_neon(r, fold_pmull(&crc16_fold, fold_pair_neon(0, (uint64_t)crc << 48), buf, n, 1), 1);
+        crc = crc16_update(0, r, 16);
+        buf += n;
+        len -= n;
+    }
+    return crc16_update(crc, buf, len);
+}
+
+TARGET_PMULL static uint32_t crc32_pmull(uint32_t crc, const uint8_t *buf, size_t len) {
+    if (len >= FOLD_MIN_LEN) {
+        size_t n = len & ~(size_t)15;
+        uint8_t r[16];
+        fold_store_neon(r, fold_pmull(&crc32_fold, fold_pair_neon(crc, 0), buf, n, 0), 0);
+        crc = crc32_armv8(0, r, 16);
+        buf += n;
+        len -= n;
+    }
+    return crc32_armv8(crc, buf, len);
+}
+
+TARGET_PMULL static uint64_t crc64_pmull(uint64_t crc, const uint8_t *buf, size_t len) {
+    if (len >= FOLD_MIN_LEN) {
+        size_t n = len & ~(size_t)15;
+        uint8_t r[16];
+        fold_store_neon(r, fold_pmull(&crc64_fold, fold_pair_neon(0, crc), buf, n, 1), 1);
+        crc = crc64_update(0, r, 16);
+        buf += n;
+        len -= n;
+    }
+    return crc64_update(crc, buf, len);
+}
+#endif
+
+/* ================= CRC CATALOGUE KERNELS ================= */
+/*
+    One engine for every model of the catalogue, on its generated tables
+    (slice-by-8) and folding constants. Reflected models keep the register
+    in the low bits and load little-endian like CRC-32C; the others keep it
+    in the top bits of 64 and load big-endian like CRC-64, whatever their
+    width. The fold below is the same as for the built-in CRCs.
+*/
+static const struct crc_model crc_models[CRC_MODELS] = CRC_MODEL_LIST;
+#if LIBCRC_X86 || LIBCRC_ARM64
+static const struct fold_consts crc_model_fold[CRC_MODELS] = CRC_MODEL_FOLD_CONSTS;
+#endif
+
+static uint64_t model_update(int m, uint64_t crc, const uint8_t *buf, size_t len) {
+    const uint64_t (*t)[256] = crc_model_table[m];
+
+    if (crc_models[m].refin) {
+        for (; len >= 8; buf += 8, len -= 8) {
+            uint64_t a = load_le64(buf) ^ crc;
+            crc = t[7][a & 0xFF]         ^ t[6][(a >> 8) & 0xFF]  ^ t[5][(a >> 16) & 0xFF] ^
+                  t[4][(a >> 24) & 0xFF] ^ t[3][(a >> 32) & 0xFF] ^ t[2][(a >> 40) & 0xFF] ^
+                  t[1][(a >> 48) & 0xFF] ^ t[0][a >> 56];
+        }
+        while (len--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *buf++) & 0xFF];
+    } else {
+        for (; len >= 8; buf += 8, len -= 8) {
+            uint64_t a = load_be64(buf) ^ crc;
+            crc = t[7][a >> 56]          ^ t[6][(a >> 48) & 0xFF] ^ t[5][(a >> 40) & 0xFF] ^
+                  t[4][(a >> 32) & 0xFF] ^ t[3][(a >> 24) & 0xFF] ^ t[2][(a >> 16) & 0xFF] ^
+                  t[1][(a >> 8) & 0xFF]  ^ t[0][a & 0xFF];
+        }
+        while (len--)
+            crc = (crc << 8) ^ t[0][(crc >> 56) ^ *buf++];
+    }
+    return crc;
+}
+
+#if LIBCRC_X86
+#define CRC_MODEL_KERNEL(isa, TARGET, fold)                                                   \
+TARGET static uint64_t model_##isa(int m, uint64_t crc, const uint8_t *buf, size_t len) {    \
+    if (len >= FOLD_MIN_LEN) {                                                               \
+        size_t n = len & ~(size_t)15;                                                        \
+        uint8_t r[16];                                                                       \
+        const struct fold_consts *c = &crc_model_fold[m];                                    \
+        if (crc_models[m].refin)                                                             \
+            _mm_storeu_si128((__m128i *)r, fold(c, _mm_set_epi64x(0, (long long)crc), buf, n, 0)); \
+        else                                                                                 \
+            _mm_storeu_si128((__m128i *)r, bswap128(fold(c, _mm_set_epi64x((long long)crc, 0), buf, n, 1))); \
+        crc = model_update(m, 0, r, 16);                                                     \
+        buf += n;                                                                            \
+        len -= n;                                                                            \
+    }                                                                                        \
+    return model_update(m, crc, buf, len);                                                   \
+}
+
+CRC_MODEL_KERNEL(pclmul, TARGET_PCLMUL,     fold_pclmul)
+CRC_MODEL_KERNEL(avx2,   TARGET_VPCLMUL256, fold_vpclmul256)
+CRC_MODEL_KERNEL(avx512, TARGET_VPCLMUL512, fold_vpclmul512)
+
+#elif LIBCRC_ARM64
+/* CRC-32/ISO-HDLC and CRC-32/ISCSI run on the CRC32 instructions, their registers are the same */
+TARGET_ARMCRC static uint64_t model_armv8(int m, uint64_t crc, const uint8_t *buf, size_t len) {
+    if (crc_models[m].width == 32 && crc_models[m].refin) {
+        if (crc_models[m].poly == CRC32_POLY)  return crc32_iso_armv8((uint32_t)crc, buf, len);
+        if (crc_models[m].poly == CRC32C_POLY) return crc32_armv8((uint32_t)crc, buf, len);
+    }
+    return model_update(m, crc, buf, len);
+}
+
+TARGET_PMULL static uint64_t model_pmull(int m, uint64_t crc, const uint8_t *buf, size_t len) {
+    if (len >= FOLD_MIN_LEN) {
+        size_t n = len & ~(size_t)15;
+        uint8_t r[16];
+        const struct fold_consts *c = &crc_model_fold[m];
+        if (crc_models[m].refin)
+            fold_store_neon(r, fold_pmull(c, fold_pair_neon(crc, 0), buf, n, 0), 0);
+        else
+            fold_store_neon(r, fold_pmull(c, fold_pair_neon(0, crc), buf, n, 1), 1);
+        crc = model_armv8(m, 0, r, 16);
+        buf += n;
+        len -= n;
+    }
+    return model_armv8(m, crc, buf, len);
+}
+#endif
+
+/* ================= XXH3 ACCUMULATORS ================= */
+/*
+    The long-input core of XXH3: 8 x 64-bit accumulators fed one 64-byte
+    stripe at a time, scrambled once per 1 KB block. Only these two steps are
+    ISA specific, everything else in XXH3 is scalar. Each variant below
+    produces bit-identical accumulators.
+*/
+#define XXH3_STRIPE_LEN    64
+#define XXH3_SECRET_SIZE   192
+#define XXH3_CONSUME_RATE  8
+#define XXH3_STRIPES_BLOCK ((XXH3_SECRET_SIZE - XXH3_STRIPE_LEN) / XXH3_CONSUME_RATE)
+#define XXH3_BLOCK_LEN     (XXH3_STRIPE_LEN * XXH3_STRIPES_BLOCK)
+#define XXH3_MIDSIZE_MAX   240
+
+#define XXH_P32_1 0x9E3779B1u
+#define XXH_P32_2 0x85EBCA77u
+#define XXH_P32_3 0xC2B2AE3Du
+
+static const uint8_t xxh3_secret[XXH3_SECRET_SIZE] __attribute__((aligned(64))) = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+typedef void (*xxh3_accumulate_fn)(uint64_t *acc, const uint8_t *in, const uint8_t *secret, size_t stripes);
+typedef void (*xxh3_scramble_fn)(uint64_t *acc, const uint8_t *secret);
+
+/* ---------- scalar ---------- */
+static void xxh3_accumulate_scalar(uint64_t *acc, const uint8_t *in, const uint8_t *secret, size_t stripes) {
+    for (size_t s = 0; s < stripes; s++, in += XXH3_STRIPE_LEN, secret += XXH3_CONSUME_RATE)
+        for (int i = 0; i < 8; i++) {
+            uint64_t v = load_le64(in + 8 * i);
+            uint64_t k = v ^ load_le64(secret + 8 * i);
+            acc[i ^ 1] += v;
+            acc[i] += (k & 0xFFFFFFFF) * (k >> 32);
+        }
+}
+
+static void xxh3_scramble_scalar(uint64_t *acc, const uint8_t *secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= load_le64(secret + 8 * i);
+        acc[i] = a * XXH_P32_1;
+    }
+}
+
+#if LIBCRC_X86
+/* ---------- SSE2 ---------- */
+TARGET_SSE2 static void xxh3_accumulate_sse2(uint64_t *acc, const uint8_t *in, const uint8_t *secret, size_t stripes) {
+    __m128i a[4];
+    for (int i = 0; i < 4; i++) a[i] = _mm_loadu_si128((const __m128i *)acc + i);
+
+    for (size_t s = 0; s < stripes; s++, in += XXH3_STRIPE_LEN, secret += XXH3_CONSUME_RATE)
+        for (int i = 0; i < 4; i++) {
+            __m128i d  = _mm_loadu_si128((const __m128i *)in + i);
+            __m128i k  = _mm_xor_si128(d, _mm_loadu_si128((const __m128i *)secret + i));
+            __m128i p  = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m128i sw = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm_add_epi64(a[i], _mm_add_epi64(p, sw));
+        }
+
+    for (int i = 0; i < 4; i++) _mm_storeu_si128((__m128i *)acc + i, a[i]);
+}
+
+TARGET_SSE2 static void xxh3_scramble_sse2(uint64_t *acc, const uint8_t *secret) {
+    const __m128i prime = _mm_set1_epi32((int)XXH_P32_1);
+    for (int i = 0; i < 4; i++) {
+        __m128i a = _mm_loadu_si128((const __m128i *)acc + i);
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *)secret + i));
+        __m128i lo = _mm_mul_epu32(a, prime);
+        __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm_storeu_si128((__m128i *)acc + i, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
+
+/* ---------- AVX2 ---------- */
+TARGET_AVX2 static void xxh3_accumulate_avx2(uint64_t *acc, const uint8_t *in, const uint8_t *secret, size_t stripes) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i *)acc);
+    __m256i a1 = _mm256_loadu_si256((const __m256i *)acc + 1);
+
+    for (size_t s = 0; s < stripes; s++, in += XXH3_STRIPE_LEN, secret += XXH3_CONSUME_RATE) {
+        __m256i d0 = _mm256_loadu_si256((const __m256i *)in);
+        __m256i d1 = _mm256_loadu_si256((const __m256i *)in + 1);
+        __m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i *)secret));
+        __m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i *)secret + 1));
+        __m256i p0 = _mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32));
+        __m256i p1 = _mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32));
+        a0 = _mm256_add_epi64(a0, _mm256_add_epi64(p0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+        a1 = _mm256_add_epi64(a1, _mm256_add_epi64(p1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+
+    _mm256_storeu_si256((__m256i *)acc, a0);
+    _mm256_storeu_si256((__m256i *)acc + 1, a1);
+}
+
+TARGET_AVX2 static void xxh3_scramble_avx2(uint64_t *acc, const uint8_t *secret) {
+    const __m256i prime = _mm256_set1_epi32((int)XXH_P32_1);
+    for (int i = 0; i < 2; i++) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)acc + i);
+        a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *)secret + i));
+        __m256i lo = _mm256_mul_epu32(a, prime);
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        _mm256_storeu_si256((__m256i *)acc + i, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+    }
+}
+
+/* ---------- AVX-512 ---------- */
+TARGET_AVX512 static void xxh3_accumulate_avx512(uint64_t *acc, const uint8_t *in, const uint8_t *secret, size_t stripes) {
+    __m512i a = _mm512_loadu_si512((const void *)acc);
+
+    for (size_t s = 0; s < stripes; s++, in += XXH3_STRIPE_LEN, secret += XXH3_CONSUME_RATE) {
+        __m512i d = _mm512_loadu_si512((const void *)in);
+        __m512i k = _mm512_xor_si512(d, _mm512_loadu_si512((const void *)secret));
+        __m512i p = _mm512_mul_epu32(k, _mm512_srli_epi64(k, 32));
+        a = _mm512_add_epi64(a, _mm512_add_epi64(p, _mm512_shuffle_epi32(d, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2))));
+    }
+
+    _mm512_storeu_si512((void *)acc, a);
+}
+
+TARGET_AVX512 static void xxh3_scramble_avx512(uint64_t *acc, const uint8_t *secret) {
+    const __m512i prime = _mm512_set1_epi32((int)XXH_P32_1);
+    __m512i a = _mm512_loadu_si512((const void *)acc);
+    a = _mm512_ternarylogic_epi64(a, _mm512_srli_epi64(a, 47), _mm512_loadu_si512((const void *)secret), 0x96);
+    __m512i lo = _mm512_mul_epu32(a, prime);
+    __m512i hi = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), prime);
+    _mm512_storeu_si512((void *)acc, _mm512_add_epi64(lo, _mm512_slli_epi64(hi, 32)));
+}
+
+#elif LIBCRC_ARM64
+/* ---------- NEON (part of the aarch64 base ISA) ---------- */
+static void xxh3_accumulate_neon(uint64_t *acc, const uint8_t *in, const uint8_t *secret, size_t stripes) {
+    uint64x2_t a[4];
+    for (int i = 0; i < 4; i++) a[i] = vld1q_u64(acc + 2 * i);
+
+    for (size_t s = 0; s < stripes; s++, in += XXH3_STRIPE_LEN, secret += XXH3_CONSUME_RATE)
+        for (int i = 0; i < 4; i++) {
+            uint64x2_t d  = vreinterpretq_u64_u8(vld1q_u8(in + 16 * i));
+            uint64x2_t k  = veorq_u64(d, vreinterpretq_u64_u8(vld1q_u8(secret + 16 * i)));
+            uint32x2_t lo = vmovn_u64(k);
+            uint32x2_t hi = vshrn_n_u64(k, 32);
+            a[i] = vaddq_u64(a[i], vextq_u64(d, d, 1));
+            a[i] = vmlal_u32(a[i], lo, hi);
+        }
+
+    for (int i = 0; i < 4; i++) vst1q_u64(acc + 2 * i, a[i]);
+}
+
+static void xxh3_scramble_neon(uint64_t *acc, const uint8_t *secret) {
+    const uint32x2_t prime = vdup_n_u32(XXH_P32_1);
+    for (int i = 0; i < 4; i++) {
+        uint64x2_t a = vld1q_u64(acc + 2 * i);
+        a = veorq_u64(a, vshrq_n_u64(a, 47));
+        a = veorq_u64(a, vreinterpretq_u64_u8(vld1q_u8(secret + 16 * i)));
+        uint64x2_t hi = vshlq_n_u64(vmull_u32(vshrn_n_u64(a, 32), prime), 32);
+        vst1q_u64(acc + 2 * i, vmlal_u32(hi, vmovn_u64(a), prime));
+    }
+}
+#endif
+
+/* ================= CPU FEATURES (CPUID / HWCAP) ================= */
+static struct cpu_features cpu_caps;
+
+#if LIBCRC_X86
+/* XCR0: which register states the OS saves on context switch */
+static uint64_t read_xcr0(void) {
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static void detect_cpu(void) {
+    unsigned a, b, c, d;
+    memset(&cpu_caps, 0, sizeof(cpu_caps));
+
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return;
+    cpu_caps.ssse3  = (c >> 9) & 1;
+    cpu_caps.sse42  = (c >> 20) & 1;
+    cpu_caps.pclmul = (c >> 1) & 1;
+    cpu_caps.fma    = (c >> 12) & 1;
+
+    int osxsave = (c >> 27) & 1;
+    uint64_t xcr0 = osxsave ? read_xcr0() : 0;
+    int os_avx    = (xcr0 & 0x06) == 0x06;       /* XMM + YMM */
+    int os_avx512 = (xcr0 & 0xE6) == 0xE6;       /* + opmask, ZMM0-15, ZMM16-31 */
+    cpu_caps.avx = os_avx && ((c >> 28) & 1);
+    if (!cpu_caps.avx) cpu_caps.fma = 0;
+
+    if (__get_cpuid_max(0, NULL) < 7) return;
+    __cpuid_count(7, 0, a, b, c, d);
+    cpu_caps.bmi1       = (b >> 3) & 1;
+    cpu_caps.bmi2       = (b >> 8) & 1;
+    cpu_caps.avx2       = cpu_caps.avx && ((b >> 5) & 1);
+    cpu_caps.vpclmulqdq = cpu_caps.avx && ((c >> 10) & 1);
+    cpu_caps.avx512f    = os_avx512 && ((b >> 16) & 1);
+    cpu_caps.avx512bw   = cpu_caps.avx512f && ((b >> 30) & 1);
+    cpu_caps.avx512vl   = cpu_caps.avx512f && ((b >> 31) & 1);
+}
+
+#elif LIBCRC_ARM64
+/* The kernel reports the optional ARMv8 extensions in the auxiliary vector */
+#ifndef HWCAP_ASIMD
+#define HWCAP_ASIMD (1 << 1)
+#endif
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+
+static void detect_cpu(void) {
+    unsigned long hw = getauxval(AT_HWCAP);
+    memset(&cpu_caps, 0, sizeof(cpu_caps));
+
+    cpu_caps.neon      = (hw & HWCAP_ASIMD) != 0;
+    cpu_caps.arm_crc32 = (hw & HWCAP_CRC32) != 0;
+    cpu_caps.pmull     = (hw & HWCAP_PMULL) != 0;
+}
+
+#else
+static void detect_cpu(void) {
+    memset(&cpu_caps, 0, sizeof(cpu_caps));
+}
+#endif
+
+/* ================= RUNTIME DISPATCH ================= */
+static const char *const isa_names[ISA_COUNT] = { "scalar", "sse4.2", "pclmul", "avx2", "avx512", "armv8", "pmull" };
+
+struct hash_engines {
+    enum isa_level isa;
+    uint16_t (*crc16)(uint16_t crc, const uint8_t *buf, size_t len);
+    uint32_t (*crc32)(uint32_t crc, const uint8_t *buf, size_t len);
+    uint64_t (*crc64)(uint64_t crc, const uint8_t *buf, size_t len);
+    xxh3_accumulate_fn xxh3_accumulate;
+    xxh3_scramble_fn xxh3_scramble;
+    int fused;              /* multi-hash masks use the fused kernels */
+    /* calls of up to crcN_max bytes go to crcN_small (tuning profile) */
+    uint16_t (*crc16_small)(uint16_t crc, const uint8_t *buf, size_t len);
+    uint32_t (*crc32_small)(uint32_t crc, const uint8_t *buf, size_t len);
+    uint64_t (*crc64_small)(uint64_t crc, const uint8_t *buf, size_t len);
+    size_t crc16_max, crc32_max, crc64_max;
+    uint64_t (*model)(int m, uint64_t crc, const uint8_t *buf, size_t len);   /* the catalogue */
+};
+
+static struct hash_engines engines = {
+    ISA_SCALAR, crc16_update, crc32_update, crc64_update, xxh3_accumulate_scalar, xxh3_scramble_scalar, 0,
+    crc16_update, crc32_update, crc64_update, 0, 0, 0, model_update
+};
+
+/*
+    The fused kernels carry their own AVX-512 folds and XXH3 rounds, so they
+    only stand in for the separate engines when those are the same kernels.
+    Buffers under FUSED_MIN go to the separate engines anyway, so small-call
+    kernels below that size do not get in the way.
+*/
+#define FUSED_MIN 4096
+
+static void update_fused(void) {
+#if LIBCRC_X86
+    engines.fused = cpu_caps.vpclmulqdq &&
+                    engines.crc16 == crc16_avx512 && engines.crc32 == crc32_avx512 &&
+                    engines.crc64 == crc64_avx512 && engines.xxh3_accumulate == xxh3_accumulate_avx512 &&
+                    engines.crc16_max < FUSED_MIN && engines.crc32_max < FUSED_MIN && engines.crc64_max < FUSED_MIN;
+#endif
+}
+
+/*
+    A level is usable when the CPU has its base ISA. Each hash then takes its
+    best kernel within that level: the 256/512-bit CRC folding also needs
+    VPCLMULQDQ and drops to the 128-bit PCLMUL kernels without it. The x86
+    levels are never supported on aarch64 and the other way round; any
+    other architecture only has the scalar level.
+*/
+int isa_supported(enum isa_level isa) {
+    switch (isa) {
+        case ISA_SCALAR: return 1;
+        case ISA_SSE42:  return cpu_caps.sse42;
+        case ISA_PCLMUL: return cpu_caps.sse42 && cpu_caps.ssse3 && cpu_caps.pclmul;
+        case ISA_AVX2:   return isa_supported(ISA_PCLMUL) && cpu_caps.avx2;
+        case ISA_AVX512: return isa_supported(ISA_AVX2) && cpu_caps.avx512f && cpu_caps.avx512bw &&
+                                cpu_caps.avx512vl;
+        case ISA_ARMV8:  return cpu_caps.neon && cpu_caps.arm_crc32;
+        case ISA_PMULL:  return isa_supported(ISA_ARMV8) && cpu_caps.pmull;
+        default:         return 0;
+    }
+}
+
+const char *isa_name(enum isa_level isa) {
+    return isa < ISA_COUNT ? isa_names[isa] : "unknown";
+}
+
+enum isa_level current_isa(void) {
+    return engines.isa;
+}
+
+const struct cpu_features *libcrc_cpu(void) {
+    return &cpu_caps;
+}
+
+int isa_from_name(const char *name) {
+    for (int i = 0; i < ISA_COUNT; i++)
+        if (!strcmp(name, isa_names[i])) return i;
+    return -1;
+}
+
+enum isa_level best_isa(void) {
+    for (int i = ISA_COUNT - 1; i > ISA_SCALAR; i--)
+        if (isa_supported((enum isa_level)i)) return (enum isa_level)i;
+    return ISA_SCALAR;
+}
+
+void select_engines(enum isa_level isa) {
+    engines.isa = isa;
+    engines.crc16 = crc16_update; engines.crc32 = crc32_update; engines.crc64 = crc64_update;
+    engines.model = model_update;
+    engines.xxh3_accumulate = xxh3_accumulate_scalar; engines.xxh3_scramble = xxh3_scramble_scalar;
+
+#if LIBCRC_X86
+    switch (isa) {
+        case ISA_SSE42:
+            engines.crc32 = crc32_simd;
+            break;
+        case ISA_PCLMUL:
+            engines.crc16 = crc16_pclmul; engines.crc32 = crc32_pclmul; engines.crc64 = crc64_pclmul;
+            break;
+        case ISA_AVX2:
+            if (cpu_caps.vpclmulqdq) {
+                engines.crc16 = crc16_avx2;   engines.crc32 = crc32_avx2;   engines.crc64 = crc64_avx2;
+            } else {
+                engines.crc16 = crc16_pclmul; engines.crc32 = crc32_pclmul; engines.crc64 = crc64_pclmul;
+            }
+            break;
+        case ISA_AVX512:
+            if (cpu_caps.vpclmulqdq) {
+                engines.crc16 = crc16_avx512; engines.crc32 = crc32_avx512; engines.crc64 = crc64_avx512;
+            } else {
+                engines.crc16 = crc16_pclmul; engines.crc32 = crc32_pclmul; engines.crc64 = crc64_pclmul;
+            }
+            break;
+        default:
+            break;
+    }
+
+    switch (isa) {
+        case ISA_PCLMUL: engines.model = model_pclmul; break;
+        case ISA_AVX2:   engines.model = cpu_caps.vpclmulqdq ? model_avx2 : model_pclmul; break;
+        case ISA_AVX512: engines.model = cpu_caps.vpclmulqdq ? model_avx512 : model_pclmul; break;
+        default:         break;
+    }
+
+    /* SSE2 is part of x86-64, so every level above scalar has it */
+    switch (isa) {
+        case ISA_SSE42:
+        case ISA_PCLMUL:
+            engines.xxh3_accumulate = xxh3_accumulate_sse2;   engines.xxh3_scramble = xxh3_scramble_sse2;
+            break;
+        case ISA_AVX2:
+            engines.xxh3_accumulate = xxh3_accumulate_avx2;   engines.xxh3_scramble = xxh3_scramble_avx2;
+            break;
+        case ISA_AVX512:
+            engines.xxh3_accumulate = xxh3_accumulate_avx512; engines.xxh3_scramble = xxh3_scramble_avx512;
+            break;
+        default:
+            break;
+    }
+#elif LIBCRC_ARM64
+    switch (isa) {
+        case ISA_ARMV8:
+            engines.crc32 = crc32_armv8;
+            engines.model = model_armv8;
+            engines.xxh3_accumulate = xxh3_accumulate_neon; engines.xxh3_scramble = xxh3_scramble_neon;
+            break;
+        case ISA_PMULL:
+            engines.crc16 = crc16_pmull; engines.crc32 = crc32_pmull; engines.crc64 = crc64_pmull;
+            engines.model = model_pmull;
+            engines.xxh3_accumulate = xxh3_accumulate_neon; engines.xxh3_scramble = xxh3_scramble_neon;
+            break;
+        default:
+            break;
+    }
+#endif
+
+    engines.crc16_small = engines.crc16; engines.crc32_small = engines.crc32; engines.crc64_small = engines.crc64;
+    engines.crc16_max = engines.crc32_max = engines.crc64_max = 0;
+    update_fused();
+}
+
+/* ================= BEST CRC ENGINES ================= */
+uint16_t crc16_hash(uint16_t crc, const uint8_t *buf, size_t len) {
+    return len <= engines.crc16_max ? engines.crc16_small(crc, buf, len) : engines.crc16(crc, buf, len);
+}
+
+uint32_t crc32_hash(uint32_t crc, const uint8_t *buf, size_t len) {
+    return len <= engines.crc32_max ? engines.crc32_small(crc, buf, len) : engines.crc32(crc, buf, len);
+}
+
+uint64_t crc64_hash(uint64_t crc, const uint8_t *buf, size_t len) {
+    return len <= engines.crc64_max ? engines.crc64_small(crc, buf, len) : engines.crc64(crc, buf, len);
+}
+
+/* ================= CRC CATALOGUE ================= */
+int crc_model_count(void) {
+    return CRC_MODELS;
+}
+
+const struct crc_model *crc_model_get(int i) {
+    return i >= 0 && i < CRC_MODELS ? &crc_models[i] : NULL;
+}
+
+const struct crc_model *crc_model_find(const char *name) {
+    for (int i = 0; i < CRC_MODELS; i++)
+        if (!strcasecmp(name, crc_models[i].name) || (crc_models[i].alias && !strcasecmp(name, crc_models[i].alias)))
+            return &crc_models[i];
+    return NULL;
+}
+
+/* The low width bits of v in reverse order */
+static uint64_t model_reflect(uint64_t v, int width) {
+    uint64_t r = 0;
+    for (int i = 0; i < width; i++, v >>= 1)
+        r = (r << 1) | (v & 1);
+    return r;
+}
+
+uint64_t crc_model_init(const struct crc_model *m) {
+    return m->refin ? model_reflect(m->init, m->width) : m->init << (64 - m->width);
+}
+
+uint64_t crc_model_update(const struct crc_model *m, uint64_t reg, const void *buf, size_t len) {
+    return engines.model((int)(m - crc_models), reg, buf, len);
+}
+
+uint64_t crc_model_final(const struct crc_model *m, uint64_t reg) {
+    uint64_t v = m->refin ? reg : reg >> (64 - m->width);
+    if (m->refin != m->refout) v = model_reflect(v, m->width);
+    return v ^ m->xorout;
+}
+
+uint64_t crc_model_hash(const struct crc_model *m, const void *buf, size_t len) {
+    return crc_model_final(m, crc_model_update(m, crc_model_init(m), buf, len));
+}
+
+/* The register as a width-bit polynomial in normal bit order, multiplied by x^(8 * len) */
+uint64_t crc_model_shift(const struct crc_model *m, uint64_t reg, uint64_t len) {
+    int w = m->width;
+    uint64_t v = m->refin ? model_reflect(reg, w) : reg >> (64 - w);
+    uint64_t x = crc_msb_x2nmodp(crc_model_x2n_table[m - crc_models], len, 3, m->poly, w);
+    v = crc_msb_multmodp(x, v, m->poly, w);
+    return m->refin ? model_reflect(v, w) : v << (64 - w);
+}
+
+/* reg(A || B) = shift(reg(A) ^ init, len(B)) ^ reg(B), the registers of the final values */
+uint64_t crc_model_combine(const struct crc_model *m, uint64_t crc1, uint64_t crc2, uint64_t len2) {
+    uint64_t r[2] = { crc1 ^ m->xorout, crc2 ^ m->xorout };
+    for (int i = 0; i < 2; i++) {
+        if (m->refin != m->refout) r[i] = model_reflect(r[i], m->width);
+        if (!m->refin) r[i] <<= 64 - m->width;
+    }
+    return crc_model_final(m, crc_model_shift(m, r[0] ^ crc_model_init(m), len2) ^ r[1]);
+}
+
+/* ================= xxHash CONSTANTS ================= */
+#define XX_P1 11400714785074694791ULL
+#define XX_P2 14029467366897019727ULL
+#define XX_P3 1609587929392839161ULL
+#define XX_P4 9650029242287828579ULL
+#define XX_P5 2870177450012600261ULL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/* ================= xxHash64 ================= */
+/*
+    Reference XXH64: four independent lanes over 32-byte stripes, then the
+    merge, tail and avalanche steps. Output matches xxhsum -H64 (seed 0).
+    The state is streaming, so the hash can be fed block by block.
+*/
+static inline uint64_t load_le32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * XX_P2;
+    acc = rotl64(acc, 31);
+    return acc * XX_P1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t h, uint64_t v) {
+    h ^= xxh64_round(0, v);
+    return h * XX_P1 + XX_P4;
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h) {
+    h ^= h >> 33; h *= XX_P2;
+    h ^= h >> 29; h *= XX_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+void xxh64_reset(struct xxh64_state *st, uint64_t seed) {
+    memset(st, 0, sizeof(*st));
+    st->seed = seed;
+    st->v[0] = seed + XX_P1 + XX_P2;
+    st->v[1] = seed + XX_P2;
+    st->v[2] = seed;
+    st->v[3] = seed - XX_P1;
+}
+
+/* Whole stripes only, returns the number of bytes consumed */
+static size_t xxh64_stripes(uint64_t v[4], const uint8_t *p, size_t len) {
+    uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+    size_t done = 0;
+    for (; len - done >= 32; done += 32) {
+        v1 = xxh64_round(v1, load_le64(p + done));
+        v2 = xxh64_round(v2, load_le64(p + done + 8));
+        v3 = xxh64_round(v3, load_le64(p + done + 16));
+        v4 = xxh64_round(v4, load_le64(p + done + 24));
+    }
+    v[0] = v1; v[1] = v2; v[2] = v3; v[3] = v4;
+    return done;
+}
+
+void xxh64_update(struct xxh64_state *st, const uint8_t *p, size_t len) {
+    st->total_len += len;
+
+    if (st->memsize + len < 32) {
+        memcpy(st->mem + st->memsize, p, len);
+        st->memsize += (uint32_t)len;
+        return;
+    }
+
+    if (st->memsize) {
+        size_t fill = 32 - st->memsize;
+        memcpy(st->mem + st->memsize, p, fill);
+        xxh64_stripes(st->v, st->mem, 32);
+        p += fill;
+        len -= fill;
+        st->memsize = 0;
+    }
+
+    size_t done = xxh64_stripes(st->v, p, len);
+    if (len > done) {
+        memcpy(st->mem, p + done, len - done);
+        st->memsize = (uint32_t)(len - done);
+    }
+}
+
+/* len zero bytes: a lane round on zero input is rotl(v, 31) * P1, nothing to load */
+static void xxh64_update_zeros(struct xxh64_state *st, uint64_t len) {
+    st->total_len += len;
+
+    if (st->memsize + len < 32) {
+        memset(st->mem + st->memsize, 0, len);
+        st->memsize += (uint32_t)len;
+        return;
+    }
+
+    if (st->memsize) {
+        size_t fill = 32 - st->memsize;
+        memset(st->mem + st->memsize, 0, fill);
+        xxh64_stripes(st->v, st->mem, 32);
+        len -= fill;
+        st->memsize = 0;
+    }
+
+    uint64_t v1 = st->v[0], v2 = st->v[1], v3 = st->v[2], v4 = st->v[3];
+    for (uint64_t n = len / 32; n; n--) {
+        v1 = rotl64(v1, 31) * XX_P1;
+        v2 = rotl64(v2, 31) * XX_P1;
+        v3 = rotl64(v3, 31) * XX_P1;
+        v4 = rotl64(v4, 31) * XX_P1;
+    }
+    st->v[0] = v1; st->v[1] = v2; st->v[2] = v3; st->v[3] = v4;
+
+    memset(st->mem, 0, len % 32);
+    st->memsize = (uint32_t)(len % 32);
+}
+
+uint64_t xxh64_digest(const struct xxh64_state *st) {
+    uint64_t h;
+
+    if (st->total_len >= 32) {
+        h = rotl64(st->v[0], 1) + rotl64(st->v[1], 7) + rotl64(st->v[2], 12) + rotl64(st->v[3], 18);
+        for (int i = 0; i < 4; i++)
+            h = xxh64_merge(h, st->v[i]);
+    } else {
+        h = st->seed + XX_P5;
+    }
+    h += st->total_len;
+
+    const uint8_t *p = st->mem;
+    size_t len = st->memsize;
+    for (; len >= 8; p += 8, len -= 8) {
+        h ^= xxh64_round(0, load_le64(p));
+        h = rotl64(h, 27) * XX_P1 + XX_P4;
+    }
+    if (len >= 4) {
+        h ^= load_le32(p) * XX_P1;
+        h = rotl64(h, 23) * XX_P2 + XX_P3;
+        p += 4;
+        len -= 4;
+    }
+    for (; len; p++, len--) {
+        h ^= *p * XX_P5;
+        h = rotl64(h, 11) * XX_P1;
+    }
+
+    return xxh64_avalanche(h);
+}
+
+uint64_t xxh64(const uint8_t *p, size_t len, uint64_t seed) {
+    struct xxh64_state st;
+    xxh64_reset(&st, seed);
+    xxh64_update(&st, p, len);
+    return xxh64_digest(&st);
+}
+
+/* ================= XXH3 (64 / 128) ================= */
+/*
+    Reference XXH3 with the default secret (seed 0). Output matches
+    xxhsum -H3 and -H2. Inputs up to 240 bytes take the short paths; longer
+    inputs go through the accumulators above, picked by the dispatcher. The
+    streaming state gives both the 64- and the 128-bit digest.
+*/
+static const uint64_t xxh3_init_acc[8] = {
+    XXH_P32_3, XX_P1, XX_P2, XX_P3, XX_P4, XXH_P32_2, XX_P5, XXH_P32_1
+};
+
+static inline uint64_t xxh3_mul128_fold64(uint64_t a, uint64_t b) {
+    unsigned __int128 p = (unsigned __int128)a * b;
+    return (uint64_t)p ^ (uint64_t)(p >> 64);
+}
+
+static inline uint64_t xxh3_avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len) {
+    h ^= rotl64(h, 49) ^ rotl64(h, 24);
+    h *= 0x9FB21C651E98DF25ULL;
+    h ^= (h >> 35) + len;
+    h *= 0x9FB21C651E98DF25ULL;
+    return h ^ (h >> 28);
+}
+
+static inline uint64_t xxh3_mix16(const uint8_t *p, const uint8_t *s) {
+    return xxh3_mul128_fold64(load_le64(p) ^ load_le64(s), load_le64(p + 8) ^ load_le64(s + 8));
+}
+
+static uint64_t xxh3_64_0to16(const uint8_t *p, size_t len) {
+    const uint8_t *s = xxh3_secret;
+    if (len > 8) {
+        uint64_t lo = (load_le64(s + 24) ^ load_le64(s + 32)) ^ load_le64(p);
+        uint64_t hi = (load_le64(s + 40) ^ load_le64(s + 48)) ^ load_le64(p + len - 8);
+        uint64_t acc = len + __builtin_bswap64(lo) + hi + xxh3_mul128_fold64(lo, hi);
+        return xxh3_avalanche(acc);
+    }
+    if (len >= 4) {
+        uint64_t in = load_le32(p + len - 4) + (load_le32(p) << 32);
+        uint64_t key = load_le64(s + 8) ^ load_le64(s + 16);
+        return xxh3_rrmxmx(in ^ key, len);
+    }
+    if (len) {
+        uint32_t c = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) | p[len - 1] | ((uint32_t)len << 8);
+        uint64_t key = load_le32(s) ^ load_le32(s + 4);
+        return xxh64_avalanche(c ^ key);
+    }
+    return xxh64_avalanche(load_le64(s + 56) ^ load_le64(s + 64));
+}
+
+static uint64_t xxh3_64_17to128(const uint8_t *p, size_t len) {
+    const uint8_t *s = xxh3_secret;
+    uint64_t acc = len * XX_P1;
+    if (len > 32) {
+        if (len > 64) {
+            if (len > 96) {
+                acc += xxh3_mix16(p + 48, s + 96);
+                acc += xxh3_mix16(p + len - 64, s + 112);
+            }
+            acc += xxh3_mix16(p + 32, s + 64);
+            acc += xxh3_mix16(p + len - 48, s + 80);
+        }
+        acc += xxh3_mix16(p + 16, s + 32);
+        acc += xxh3_mix16(p + len - 32, s + 48);
+    }
+    acc += xxh3_mix16(p, s);
+    acc += xxh3_mix16(p + len - 16, s + 16);
+    return xxh3_avalanche(acc);
+}
+
+static uint64_t xxh3_64_129to240(const uint8_t *p, size_t len) {
+    const uint8_t *s = xxh3_secret;
+    uint64_t acc = len * XX_P1;
+    size_t rounds = len / 16;
+    for (size_t i = 0; i < 8; i++)
+        acc += xxh3_mix16(p + 16 * i, s + 16 * i);
+    acc = xxh3_avalanche(acc);
+    for (size_t i = 8; i < rounds; i++)
+        acc += xxh3_mix16(p + 16 * i, s + 16 * (i - 8) + 3);
+    acc += xxh3_mix16(p + len - 16, s + 136 - 17);
+    return xxh3_avalanche(acc);
+}
+
+static uint64_t xxh3_64_short(const uint8_t *p, size_t len) {
+    if (len <= 16)  return xxh3_64_0to16(p, len);
+    if (len <= 128) return xxh3_64_17to128(p, len);
+    return xxh3_64_129to240(p, len);
+}
+
+/* 128-bit results are kept as two halves, printed hi then lo like xxhsum */
+static struct xxh128 xxh3_128_0to16(const uint8_t *p, size_t len) {
+    const uint8_t *s = xxh3_secret;
+    struct xxh128 r;
+
+    if (len > 8) {
+        uint64_t flip_lo = load_le64(s + 32) ^ load_le64(s + 40);
+        uint64_t flip_hi = load_le64(s + 48) ^ load_le64(s + 56);
+        uint64_t in_lo = load_le64(p);
+        uint64_t in_hi = load_le64(p + len - 8) ^ flip_hi;
+        unsigned __int128 m = (unsigned __int128)(in_lo ^ load_le64(p + len - 8) ^ flip_lo) * XX_P1;
+        uint64_t m_lo = (uint64_t)m + ((uint64_t)(len - 1) << 54);
+        uint64_t m_hi = (uint64_t)(m >> 64) + in_hi + (in_hi & 0xFFFFFFFF) * (XXH_P32_2 - 1);
+        m_lo ^= __builtin_bswap64(m_hi);
+        unsigned __int128 h = (unsigned __int128)m_lo * XX_P2;
+        r.lo = xxh3_avalanche((uint64_t)h);
+        r.hi = xxh3_avalanche((uint64_t)(h >> 64) + m_hi * XX_P2);
+        return r;
+    }
+    if (len >= 4) {
+        uint64_t in = load_le32(p) + (load_le32(p + len - 4) << 32);
+        uint64_t key = load_le64(s + 16) ^ load_le64(s + 24);
+        unsigned __int128 m = (unsigned __int128)(in ^ key) * (XX_P1 + ((uint64_t)len << 2));
+        uint64_t lo = (uint64_t)m;
+        uint64_t hi = (uint64_t)(m >> 64) + (lo << 1);
+        lo ^= hi >> 3;
+        lo ^= lo >> 35;
+        lo *= 0x9FB21C651E98DF25ULL;
+        r.lo = lo ^ (lo >> 28);
+        r.hi = xxh3_avalanche(hi);
+        return r;
+    }
+    if (len) {
+        uint32_t c_lo = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) | p[len - 1] | ((uint32_t)len << 8);
+        uint32_t c_hi = __builtin_bswap32(c_lo);
+        c_hi = (c_hi << 13) | (c_hi >> 19);
+        r.lo = xxh64_avalanche(c_lo ^ (load_le32(s) ^ load_le32(s + 4)));
+        r.hi = xxh64_avalanche(c_hi ^ (load_le32(s + 8) ^ load_le32(s + 12)));
+        return r;
+    }
+    r.lo = xxh64_avalanche(load_le64(s + 64) ^ load_le64(s + 72));
+    r.hi = xxh64_avalanche(load_le64(s + 80) ^ load_le64(s + 88));
+    return r;
+}
+
+static inline void xxh3_mix32(uint64_t *lo, uint64_t *hi, const uint8_t *a, const uint8_t *b, const uint8_t *s) {
+    *lo += xxh3_mix16(a, s);
+    *lo ^= load_le64(b) + load_le64(b + 8);
+    *hi += xxh3_mix16(b, s + 16);
+    *hi ^= load_le64(a) + load_le64(a + 8);
+}
+
+static struct xxh128 xxh3_128_finish(uint64_t lo, uint64_t hi, size_t len) {
+    struct xxh128 r;
+    r.lo = xxh3_avalanche(lo + hi);
+    r.hi = 0 - xxh3_avalanche(lo * XX_P1 + hi * XX_P4 + len * XX_P2);
+    return r;
+}
+
+static struct xxh128 xxh3_128_17to128(const uint8_t *p, size_t len) {
+    const uint8_t *s = xxh3_secret;
+    uint64_t lo = len * XX_P1, hi = 0;
+    if (len > 32) {
+        if (len > 64) {
+            if (len > 96)
+                xxh3_mix32(&lo, &hi, p + 48, p + len - 64, s + 96);
+            xxh3_mix32(&lo, &hi, p + 32, p + len - 48, s + 64);
+        }
+        xxh3_mix32(&lo, &hi, p + 16, p + len - 32, s + 32);
+    }
+    xxh3_mix32(&lo, &hi, p, p + len - 16, s);
+    return xxh3_128_finish(lo, hi, len);
+}
+
+static struct xxh128 xxh3_128_129to240(const uint8_t *p, size_t len) {
+    const uint8_t *s = xxh3_secret;
+    uint64_t lo = len * XX_P1, hi = 0;
+    size_t rounds = len / 32, i;
+    for (i = 0; i < 4; i++)
+        xxh3_mix32(&lo, &hi, p + 32 * i, p + 32 * i + 16, s + 32 * i);
+    lo = xxh3_avalanche(lo);
+    hi = xxh3_avalanche(hi);
+    for (; i < rounds; i++)
+        xxh3_mix32(&lo, &hi, p + 32 * i, p + 32 * i + 16, s + 32 * (i - 4) + 3);
+    xxh3_mix32(&lo, &hi, p + len - 16, p + len - 32, s + 136 - 17 - 16);
+    return xxh3_128_finish(lo, hi, len);
+}
+
+static struct xxh128 xxh3_128_short(const uint8_t *p, size_t len) {
+    if (len <= 16)  return xxh3_128_0to16(p, len);
+    if (len <= 128) return xxh3_128_17to128(p, len);
+    return xxh3_128_129to240(p, len);
+}
+
+/* ---------- long inputs ---------- */
+static uint64_t xxh3_merge_accs(const uint64_t *acc, const uint8_t *s, uint64_t start) {
+    for (int i = 0; i < 4; i++)
+        start += xxh3_mul128_fold64(acc[2 * i] ^ load_le64(s + 16 * i), acc[2 * i + 1] ^ load_le64(s + 16 * i + 8));
+    return xxh3_avalanche(start);
+}
+
+static void xxh3_last_stripe(uint64_t *acc, const uint8_t *stripe) {
+    engines.xxh3_accumulate(acc, stripe, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - 7, 1);
+}
+
+/* len > XXH3_MIDSIZE_MAX, with the given accumulator kernels */
+static void xxh3_hash_long_with(uint64_t *acc, const uint8_t *p, size_t len,
+                                xxh3_accumulate_fn accumulate, xxh3_scramble_fn scramble) {
+    size_t blocks = (len - 1) / XXH3_BLOCK_LEN;
+
+    memcpy(acc, xxh3_init_acc, sizeof(xxh3_init_acc));
+    for (size_t b = 0; b < blocks; b++) {
+        accumulate(acc, p + b * XXH3_BLOCK_LEN, xxh3_secret, XXH3_STRIPES_BLOCK);
+        scramble(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+    }
+
+    size_t stripes = ((len - 1) - blocks * XXH3_BLOCK_LEN) / XXH3_STRIPE_LEN;
+    accumulate(acc, p + blocks * XXH3_BLOCK_LEN, xxh3_secret, stripes);
+    accumulate(acc, p + len - XXH3_STRIPE_LEN, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - 7, 1);
+}
+
+static void xxh3_hash_long(uint64_t *acc, const uint8_t *p, size_t len) {
+    xxh3_hash_long_with(acc, p, len, engines.xxh3_accumulate, engines.xxh3_scramble);
+}
+
+static struct xxh128 xxh3_long_digest(const uint64_t *acc, uint64_t len, int want_hi) {
+    struct xxh128 r;
+    r.lo = xxh3_merge_accs(acc, xxh3_secret + 11, len * XX_P1);
+    r.hi = want_hi ? xxh3_merge_accs(acc, xxh3_secret + XXH3_SECRET_SIZE - 64 - 11, ~(len * XX_P2)) : 0;
+    return r;
+}
+
+uint64_t xxh3_64(const uint8_t *p, size_t len) {
+    uint64_t acc[8] __attribute__((aligned(64)));
+    if (len <= XXH3_MIDSIZE_MAX) return xxh3_64_short(p, len);
+    xxh3_hash_long(acc, p, len);
+    return xxh3_long_digest(acc, len, 0).lo;
+}
+
+struct xxh128 xxh3_128(const uint8_t *p, size_t len) {
+    uint64_t acc[8] __attribute__((aligned(64)));
+    if (len <= XXH3_MIDSIZE_MAX) return xxh3_128_short(p, len);
+    xxh3_hash_long(acc, p, len);
+    return xxh3_long_digest(acc, len, 1);
+}
+
+/* ---------- streaming ---------- */
+#define XXH3_BUFFER_STRIPES (sizeof(((struct xxh3_state *)0)->buffer) / XXH3_STRIPE_LEN)
+
+void xxh3_reset(struct xxh3_state *st) {
+    memcpy(st->acc, xxh3_init_acc, sizeof(xxh3_init_acc));
+    st->buffered = 0;
+    st->stripes_acc = 0;
+    st->total_len = 0;
+}
+
+/* Feeds whole stripes, scrambling whenever a 1 KB block of secret is used up */
+static size_t xxh3_consume_stripes(uint64_t *acc, size_t stripes, size_t stripes_acc, const uint8_t *p) {
+    while (stripes) {
+        size_t n = XXH3_STRIPES_BLOCK - stripes_acc;
+        if (stripes < n) {
+            engines.xxh3_accumulate(acc, p, xxh3_secret + stripes_acc * XXH3_CONSUME_RATE, stripes);
+            return stripes_acc + stripes;
+        }
+        engines.xxh3_accumulate(acc, p, xxh3_secret + stripes_acc * XXH3_CONSUME_RATE, n);
+        engines.xxh3_scramble(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+        p += n * XXH3_STRIPE_LEN;
+        stripes -= n;
+        stripes_acc = 0;
+    }
+    return stripes_acc;
+}
+
+void xxh3_update(struct xxh3_state *st, const uint8_t *p, size_t len) {
+    const size_t bufsize = sizeof(st->buffer);
+    st->total_len += len;
+
+    if (st->buffered + len <= bufsize) {
+        memcpy(st->buffer + st->buffered, p, len);
+        st->buffered += (uint32_t)len;
+        return;
+    }
+
+    if (st->buffered) {
+        size_t fill = bufsize - st->buffered;
+        memcpy(st->buffer + st->buffered, p, fill);
+        st->stripes_acc = xxh3_consume_stripes(st->acc, XXH3_BUFFER_STRIPES, st->stripes_acc, st->buffer);
+        p += fill;
+        len -= fill;
+        st->buffered = 0;
+    }
+
+    /* Large inputs run straight from the caller's memory, always keeping at
+       least one byte back so the digest has a last stripe to work on. The
+       last consumed stripe is saved at the end of the buffer for that case. */
+    if (len > bufsize) {
+        size_t stripes = (len - 1) / XXH3_STRIPE_LEN;
+        st->stripes_acc = xxh3_consume_stripes(st->acc, stripes, st->stripes_acc, p);
+        p += stripes * XXH3_STRIPE_LEN;
+        len -= stripes * XXH3_STRIPE_LEN;
+        memcpy(st->buffer + bufsize - XXH3_STRIPE_LEN, p - XXH3_STRIPE_LEN, XXH3_STRIPE_LEN);
+    }
+
+    memcpy(st->buffer, p, len);
+    st->buffered = (uint32_t)len;
+}
+
+static const uint8_t xxh3_zeros[XXH3_BLOCK_LEN] __attribute__((aligned(64)));
+
+/*
+    xxh3_consume_stripes() over zero input. A zero stripe only adds
+    lo32(key) * hi32(key) to each lane, so a whole 1 KB block is eight
+    constant adds and a scramble; partial blocks run the kernel on zeros.
+*/
+static size_t xxh3_consume_zero_stripes(uint64_t *acc, uint64_t stripes, size_t stripes_acc) {
+    if (stripes_acc) {
+        size_t n = XXH3_STRIPES_BLOCK - stripes_acc;
+        if (stripes < n) {
+            engines.xxh3_accumulate(acc, xxh3_zeros, xxh3_secret + stripes_acc * XXH3_CONSUME_RATE, stripes);
+            return stripes_acc + stripes;
+        }
+        engines.xxh3_accumulate(acc, xxh3_zeros, xxh3_secret + stripes_acc * XXH3_CONSUME_RATE, n);
+        engines.xxh3_scramble(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+        stripes -= n;
+    }
+
+    if (stripes >= XXH3_STRIPES_BLOCK) {
+        uint64_t block[8] = { 0 };
+        for (size_t s = 0; s < XXH3_STRIPES_BLOCK; s++)
+            for (int i = 0; i < 8; i++) {
+                uint64_t k = load_le64(xxh3_secret + s * XXH3_CONSUME_RATE + 8 * i);
+                block[i] += (k & 0xFFFFFFFF) * (k >> 32);
+            }
+        for (; stripes >= XXH3_STRIPES_BLOCK; stripes -= XXH3_STRIPES_BLOCK) {
+            for (int i = 0; i < 8; i++) acc[i] += block[i];
+            engines.xxh3_scramble(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+        }
+    }
+
+    if (stripes)
+        engines.xxh3_accumulate(acc, xxh3_zeros, xxh3_secret, (size_t)stripes);
+    return (size_t)stripes;
+}
+
+/* xxh3_update() of len zero bytes, step for step */
+static void xxh3_update_zeros(struct xxh3_state *st, uint64_t len) {
+    const size_t bufsize = sizeof(st->buffer);
+    st->total_len += len;
+
+    if (st->buffered + len <= bufsize) {
+        memset(st->buffer + st->buffered, 0, len);
+        st->buffered += (uint32_t)len;
+        return;
+    }
+
+    if (st->buffered) {
+        size_t fill = bufsize - st->buffered;
+        memset(st->buffer + st->buffered, 0, fill);
+        st->stripes_acc = xxh3_consume_stripes(st->acc, XXH3_BUFFER_STRIPES, st->stripes_acc, st->buffer);
+        len -= fill;
+        st->buffered = 0;
+    }
+
+    if (len > bufsize) {
+        uint64_t stripes = (len - 1) / XXH3_STRIPE_LEN;
+        st->stripes_acc = xxh3_consume_zero_stripes(st->acc, stripes, st->stripes_acc);
+        len -= stripes * XXH3_STRIPE_LEN;
+        memset(st->buffer + bufsize - XXH3_STRIPE_LEN, 0, XXH3_STRIPE_LEN);
+    }
+
+    memset(st->buffer, 0, len);
+    st->buffered = (uint32_t)len;
+}
+
+static void xxh3_digest_long(const struct xxh3_state *st, uint64_t *acc) {
+    memcpy(acc, st->acc, sizeof(st->acc));
+    if (st->buffered >= XXH3_STRIPE_LEN) {
+        size_t stripes = (st->buffered - 1) / XXH3_STRIPE_LEN;
+        xxh3_consume_stripes(acc, stripes, st->stripes_acc, st->buffer);
+        xxh3_last_stripe(acc, st->buffer + st->buffered - XXH3_STRIPE_LEN);
+    } else {
+        uint8_t last[XXH3_STRIPE_LEN];
+        size_t catchup = XXH3_STRIPE_LEN - st->buffered;
+        memcpy(last, st->buffer + sizeof(st->buffer) - catchup, catchup);
+        memcpy(last + catchup, st->buffer, st->buffered);
+        xxh3_last_stripe(acc, last);
+    }
+}
+
+uint64_t xxh3_64_digest(const struct xxh3_state *st) {
+    uint64_t acc[8] __attribute__((aligned(64)));
+    if (st->total_len <= XXH3_MIDSIZE_MAX) return xxh3_64_short(st->buffer, st->buffered);
+    xxh3_digest_long(st, acc);
+    return xxh3_long_digest(acc, st->total_len, 0).lo;
+}
+
+struct xxh128 xxh3_128_digest(const struct xxh3_state *st) {
+    uint64_t acc[8] __attribute__((aligned(64)));
+    if (st->total_len <= XXH3_MIDSIZE_MAX) return xxh3_128_short(st->buffer, st->buffered);
+    xxh3_digest_long(st, acc);
+    return xxh3_long_digest(acc, st->total_len, 1);
+}
+
+/* ================= IMPLEMENTATIONS ================= */
+/*
+    The registry behind struct hash_impl: each entry is a kernel with what it
+    needs from the CPU. The public part comes first, so the pointers handed
+    out by impl_get() lead back to their entry.
+*/
+struct impl_entry {
+    struct hash_impl pub;
+    int vpclmul;                /* also needs VPCLMULQDQ */
+    union {
+        uint16_t (*crc16)(uint16_t crc, const uint8_t *buf, size_t len);
+        uint32_t (*crc32)(uint32_t crc, const uint8_t *buf, size_t len);
+        uint64_t (*crc64)(uint64_t crc, const uint8_t *buf, size_t len);
+        struct { xxh3_accumulate_fn accumulate; xxh3_scramble_fn scramble; } xxh3;
+    } k;
+};
+
+static const struct impl_entry crc16_impls[] = {
+    { { "table",   ALGO_CRC16, ISA_SCALAR }, 0, { .crc16 = crc16_bytewise } },
+    { { "slice16", ALGO_CRC16, ISA_SCALAR }, 0, { .crc16 = crc16_update } },
+#if LIBCRC_X86
+    { { "pclmul",  ALGO_CRC16, ISA_PCLMUL }, 0, { .crc16 = crc16_pclmul } },
+    { { "avx2",    ALGO_CRC16, ISA_AVX2 },   1, { .crc16 = crc16_avx2 } },
+    { { "avx512",  ALGO_CRC16, ISA_AVX512 }, 1, { .crc16 = crc16_avx512 } },
+#elif LIBCRC_ARM64
+    { { "pmull",   ALGO_CRC16, ISA_PMULL },  0, { .crc16 = crc16_pmull } },
+#endif
+};
+
+static const struct impl_entry crc32_impls[] = {
+    { { "table",   ALGO_CRC32, ISA_SCALAR }, 0, { .crc32 = crc32_bytewise } },
+    { { "slice16", ALGO_CRC32, ISA_SCALAR }, 0, { .crc32 = crc32_update } },
+#if LIBCRC_X86
+    { { "sse4.2",  ALGO_CRC32, ISA_SSE42 },  0, { .crc32 = crc32_simd } },
+    { { "pclmul",  ALGO_CRC32, ISA_PCLMUL }, 0, { .crc32 = crc32_pclmul } },
+    { { "avx2",    ALGO_CRC32, ISA_AVX2 },   1, { .crc32 = crc32_avx2 } },
+    { { "avx512",  ALGO_CRC32, ISA_AVX512 }, 1, { .crc32 = crc32_avx512 } },
+#elif LIBCRC_ARM64
+    { { "armv8",   ALGO_CRC32, ISA_ARMV8 },  0, { .crc32 = crc32_armv8 } },
+    { { "pmull",   ALGO_CRC32, ISA_PMULL },  0, { .crc32 = crc32_pmull } },
+#endif
+};
+
+static const struct impl_entry crc64_impls[] = {
+    { { "table",   ALGO_CRC64, ISA_SCALAR }, 0, { .crc64 = crc64_bytewise } },
+    { { "slice16", ALGO_CRC64, ISA_SCALAR }, 0, { .crc64 = crc64_update } },
+#if LIBCRC_X86
+    { { "pclmul",  ALGO_CRC64, ISA_PCLMUL }, 0, { .crc64 = crc64_pclmul } },
+    { { "avx2",    ALGO_CRC64, ISA_AVX2 },   1, { .crc64 = crc64_avx2 } },
+    { { "avx512",  ALGO_CRC64, ISA_AVX512 }, 1, { .crc64 = crc64_avx512 } },
+#elif LIBCRC_ARM64
+    { { "pmull",   ALGO_CRC64, ISA_PMULL },  0, { .crc64 = crc64_pmull } },
+#endif
+};
+
+static const struct impl_entry xxh64_impls[] = {
+    { { "scalar",  ALGO_XXH64, ISA_SCALAR }, 0, { .crc16 = NULL } },
+};
+
+static const struct impl_entry xxh3_impls[] = {
+    { { "scalar",  ALGO_XXH3, ISA_SCALAR }, 0, { .xxh3 = { xxh3_accumulate_scalar, xxh3_scramble_scalar } } },
+#if LIBCRC_X86
+    { { "sse2",    ALGO_XXH3, ISA_SSE42 },  0, { .xxh3 = { xxh3_accumulate_sse2,   xxh3_scramble_sse2 } } },
+    { { "avx2",    ALGO_XXH3, ISA_AVX2 },   0, { .xxh3 = { xxh3_accumulate_avx2,   xxh3_scramble_avx2 } } },
+    { { "avx512",  ALGO_XXH3, ISA_AVX512 }, 0, { .xxh3 = { xxh3_accumulate_avx512, xxh3_scramble_avx512 } } },
+#elif LIBCRC_ARM64
+    { { "neon",    ALGO_XXH3, ISA_ARMV8 },  0, { .xxh3 = { xxh3_accumulate_neon,   xxh3_scramble_neon } } },
+#endif
+};
+
+#define IMPLS(a) { a, sizeof(a) / sizeof(a[0]) }
+static const struct { const struct impl_entry *list; int count; } impl_lists[ALGO_COUNT] = {
+    IMPLS(crc16_impls), IMPLS(crc32_impls), IMPLS(crc64_impls), IMPLS(xxh64_impls), IMPLS(xxh3_impls)
+};
+#undef IMPLS
+
+static const char *const algo_names[ALGO_COUNT] = { "crc16", "crc32", "crc64", "xxh64", "xxh3" };
+
+const char *algo_name(enum hash_algo algo) {
+    return algo < ALGO_COUNT ? algo_names[algo] : "unknown";
+}
+
+int impl_count(enum hash_algo algo) {
+    return algo < ALGO_COUNT ? impl_lists[algo].count : 0;
+}
+
+const struct hash_impl *impl_get(enum hash_algo algo, int i) {
+    if (algo >= ALGO_COUNT || i < 0 || i >= impl_lists[algo].count) return NULL;
+    return &impl_lists[algo].list[i].pub;
+}
+
+const struct hash_impl *impl_find(enum hash_algo algo, const char *name) {
+    for (int i = 0; i < impl_count(algo); i++)
+        if (!strcmp(impl_lists[algo].list[i].pub.name, name)) return &impl_lists[algo].list[i].pub;
+    return NULL;
+}
+
+int impl_supported(const struct hash_impl *impl) {
+    const struct impl_entry *e = (const struct impl_entry *)impl;
+    return isa_supported(impl->isa) && (!e->vpclmul || cpu_caps.vpclmulqdq);
+}
+
+uint64_t impl_hash(const struct hash_impl *impl, const uint8_t *p, size_t len) {
+    const struct impl_entry *e = (const struct impl_entry *)impl;
+    uint64_t acc[8] __attribute__((aligned(64)));
+
+    switch (impl->algo) {
+        case ALGO_CRC16: return e->k.crc16(0xFFFF, p, len);
+        case ALGO_CRC32: return e->k.crc32(0xFFFFFFFF, p, len) ^ 0xFFFFFFFF;
+        case ALGO_CRC64: return e->k.crc64(0, p, len);
+        case ALGO_XXH64: return xxh64(p, len, 0);
+        default:
+            if (len <= XXH3_MIDSIZE_MAX) return xxh3_64_short(p, len);
+            xxh3_hash_long_with(acc, p, len, e->k.xxh3.accumulate, e->k.xxh3.scramble);
+            return xxh3_long_digest(acc, len, 0).lo;
+    }
+}
+
+/* select_impl() without libcrc_init(), which the profile loader runs under */
+static int set_impl(const struct hash_impl *impl, size_t small_max) {
+    const struct impl_entry *e = (const struct impl_entry *)impl;
+
+    if (!impl_supported(impl)) return -1;
+    if (small_max && impl->algo >= ALGO_XXH64) return -1;
+
+    switch (impl->algo) {
+        case ALGO_CRC16:
+            if (small_max) engines.crc16_small = e->k.crc16, engines.crc16_max = small_max;
+            else engines.crc16 = engines.crc16_small = e->k.crc16, engines.crc16_max = 0;
+            break;
+        case ALGO_CRC32:
+            if (small_max) engines.crc32_small = e->k.crc32, engines.crc32_max = small_max;
+            else engines.crc32 = engines.crc32_small = e->k.crc32, engines.crc32_max = 0;
+            break;
+        case ALGO_CRC64:
+            if (small_max) engines.crc64_small = e->k.crc64, engines.crc64_max = small_max;
+            else engines.crc64 = engines.crc64_small = e->k.crc64, engines.crc64_max = 0;
+            break;
+        case ALGO_XXH64:
+            break;
+        default:
+            engines.xxh3_accumulate = e->k.xxh3.accumulate;
+            engines.xxh3_scramble = e->k.xxh3.scramble;
+            break;
+    }
+    update_fused();
+    return 0;
+}
+
+int select_impl(const struct hash_impl *impl, size_t small_max) {
+    libcrc_init();
+    return set_impl(impl, small_max);
+}
+
+const struct hash_impl *current_impl(enum hash_algo algo, size_t len) {
+    libcrc_init();
+    for (int i = 0; i < impl_count(algo); i++) {
+        const struct impl_entry *e = &impl_lists[algo].list[i];
+        int match;
+        switch (algo) {
+            case ALGO_CRC16: match = e->k.crc16 == (len <= engines.crc16_max ? engines.crc16_small : engines.crc16); break;
+            case ALGO_CRC32: match = e->k.crc32 == (len <= engines.crc32_max ? engines.crc32_small : engines.crc32); break;
+            case ALGO_CRC64: match = e->k.crc64 == (len <= engines.crc64_max ? engines.crc64_small : engines.crc64); break;
+            case ALGO_XXH64: match = 1; break;
+            default:         match = e->k.xxh3.accumulate == engines.xxh3_accumulate; break;
+        }
+        if (match) return &e->pub;
+    }
+    return NULL;
+}
+
+/* ================= TUNING PROFILE ================= */
+static int algo_from_name(const char *name) {
+    for (int i = 0; i < ALGO_COUNT; i++)
+        if (!strcmp(name, algo_names[i])) return i;
+    return -1;
+}
+
+static int load_profile(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256], algo[16], big[16], small[16];
+    unsigned long long small_max;
+    int applied = 0;
+
+    if (!f) return -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        int n = sscanf(line, "%15s %15s %15s %llu", algo, big, small, &small_max);
+        if (n != 2 && n != 4) continue;
+
+        int a = algo_from_name(algo);
+        if (a < 0) continue;
+        const struct hash_impl *impl = impl_find((enum hash_algo)a, big);
+        if (!impl || set_impl(impl, 0)) continue;
+        applied++;
+        if (n == 4 && (impl = impl_find((enum hash_algo)a, small)) && !set_impl(impl, (size_t)small_max))
+            applied++;
+    }
+    fclose(f);
+    return applied;
+}
+
+int libcrc_load_profile(const char *path) {
+    libcrc_init();
+    return load_profile(path);
+}
+
+int libcrc_save_profile(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    fprintf(f, "# libcrc tuning profile: <algo> <kernel> [<small kernel> <small max bytes>]\n");
+    for (int a = 0; a < ALGO_COUNT; a++) {
+        const struct hash_impl *big = current_impl((enum hash_algo)a, SIZE_MAX);
+        size_t max = a == ALGO_CRC16 ? engines.crc16_max : a == ALGO_CRC32 ? engines.crc32_max :
+                     a == ALGO_CRC64 ? engines.crc64_max : 0;
+        if (!big) continue;
+        if (max)
+            fprintf(f, "%s %s %s %zu\n", algo_names[a], big->name, current_impl((enum hash_algo)a, max)->name, max);
+        else
+            fprintf(f, "%s %s\n", algo_names[a], big->name);
+    }
+    return fclose(f) ? -1 : 0;
+}
+
+/* ================= SINGLE-PASS KERNELS ================= */
+/*
+    Every combination of hashes gets its own kernel. sp_update() is always
+    inlined with a constant mask, so the compiler drops the disabled hashes and
+    the kernels contain no per-byte branches. xxH3 and xxH128 are two digests
+    of the same XXH3 state, so both only need HASH_XXH3.
+
+    The block is walked in SP_CHUNK pieces that stay in L1 while each enabled
+    hash runs its best engine over them, so memory is still read only once.
+    hash_init() picks the kernel for the mask once, hash_update() just calls it.
+*/
+
+#define SP_CHUNK (8 * 1024)
+
+typedef void (*sp_kernel_fn)(struct hash_state *h, const uint8_t *buf, size_t len);
+
+static inline __attribute__((always_inline))
+void sp_update(struct hash_state *h, const uint8_t *buf, size_t len, const unsigned mask) {
+    uint16_t crc16 = h->crc16;
+    uint32_t crc32 = h->crc32;
+    uint64_t crc64 = h->crc64;
+
+    for (size_t off = 0; off < len; off += SP_CHUNK) {
+        size_t n = len - off < SP_CHUNK ? len - off : SP_CHUNK;
+        const uint8_t *p = buf + off;
+        if (mask & HASH_CRC16) crc16 = crc16_hash(crc16, p, n);
+        if (mask & HASH_CRC32) crc32 = crc32_hash(crc32, p, n);
+        if (mask & HASH_CRC64) crc64 = crc64_hash(crc64, p, n);
+        if (mask & HASH_XXH64) xxh64_update(&h->xxh64, p, n);
+        if (mask & HASH_XXH3)  xxh3_update(&h->xxh3, p, n);
+    }
+
+    h->crc16 = crc16;
+    h->crc32 = crc32;
+    h->crc64 = crc64;
+}
+
+#define SP_KERNEL_LIST(X) \
+    X(0)  X(1)  X(2)  X(3)  X(4)  X(5)  X(6)  X(7) \
+    X(8)  X(9)  X(10) X(11) X(12) X(13) X(14) X(15) \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) \
+    X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)
+
+#define SP_KERNEL_DEFINE(m) \
+    static void sp_kernel_##m(struct hash_state *h, const uint8_t *buf, size_t len) { \
+        sp_update(h, buf, len, m); \
+    }
+#define SP_KERNEL_ENTRY(m) [m] = sp_kernel_##m,
+
+SP_KERNEL_LIST(SP_KERNEL_DEFINE)
+
+static const sp_kernel_fn sp_kernels[HASH_MASKS] = { SP_KERNEL_LIST(SP_KERNEL_ENTRY) };
+
+/* ================= FUSED KERNELS (AVX-512 + VPCLMULQDQ) ================= */
+/*
+    sp_update() runs the hashes one after the other over each chunk. XXH64
+    is four chains of dependent multiplies that leave most execution ports
+    idle, and an 8 KB chunk is far too long for the out-of-order core to
+    overlap the next hash with it, so running several hashes costs about the
+    sum of their times.
+
+    The fused kernels walk 256-byte blocks instead. The four 64-byte loads of
+    a block feed the folds of all three CRCs (4 x 512-bit accumulators each,
+    CRC-16 and CRC-64 share the byte swap) and the XXH3 accumulator, and the
+    eight XXH64 stripes of the same block run in the same loop body, so the
+    vector work is scheduled under the XXH64 latency.
+
+    xxHash wants whole stripes: the bytes up to the next 64-byte stream
+    position and the tail of the buffer go through the single-pass kernel,
+    and so does any buffer under FUSED_MIN. CRC-32C is folded like the other
+    two rather than run through the crc32 instruction, which shares its port
+    with the XXH64 multiplies.
+*/
+#if LIBCRC_X86
+#define FUSED_BLOCK 256
+
+/* Empties the XXH3 buffer (a multiple of 64 bytes here) so stripes can come straight from the input */
+static void xxh3_drain(struct xxh3_state *st) {
+    if (st->buffered)
+        st->stripes_acc = xxh3_consume_stripes(st->acc, st->buffered / XXH3_STRIPE_LEN, st->stripes_acc, st->buffer);
+    st->buffered = 0;
+}
+
+TARGET_VPCLMUL512 static inline __m128i fused_reduce(const struct fold_consts *c, const __m512i z[4]) {
+    const __m512i k512 = _mm512_broadcast_i32x4(fold_kvec(c, FOLD_512));
+    const __m128i k128 = fold_kvec(c, FOLD_128);
+    __m512i z0 = fold512_xor(z[0], k512, z[1]);
+    z0 = fold512_xor(z0, k512, z[2]);
+    z0 = fold512_xor(z0, k512, z[3]);
+
+    __m128i acc = _mm512_extracti32x4_epi32(z0, 0);
+    acc = _mm_xor_si128(fold128(acc, k128), _mm512_extracti32x4_epi32(z0, 1));
+    acc = _mm_xor_si128(fold128(acc, k128), _mm512_extracti32x4_epi32(z0, 2));
+    return _mm_xor_si128(fold128(acc, k128), _mm512_extracti32x4_epi32(z0, 3));
+}
+
+TARGET_VPCLMUL512 static inline __attribute__((always_inline))
+void fused_update(struct hash_state *h, const uint8_t *buf, size_t len, const unsigned mask) {
+    const unsigned msb = HASH_CRC16 | HASH_CRC64;
+    const unsigned xxh = HASH_XXH64 | HASH_XXH3;
+
+    if (mask & xxh) {
+        uint64_t pos = (mask & HASH_XXH3) ? h->xxh3.total_len : h->xxh64.total_len;
+        size_t pre = (size_t)(-pos & (XXH3_STRIPE_LEN - 1));
+        if (pre > len) pre = len;
+        sp_kernels[mask](h, buf, pre);
+        buf += pre;
+        len -= pre;
+    }
+    if (len < FUSED_MIN) {
+        sp_kernels[mask](h, buf, len);
+        return;
+    }
+
+    /* whole blocks, always keeping at least one byte back for the XXH3 tail */
+    size_t n = (len - 1) / FUSED_BLOCK * FUSED_BLOCK;
+    const __m512i bswap = _mm512_broadcast_i32x4(_mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    const __m512i k16 = _mm512_broadcast_i32x4(fold_kvec(&crc16_fold, FOLD_2048));
+    const __m512i k32 = _mm512_broadcast_i32x4(fold_kvec(&crc32_fold, FOLD_2048));
+    const __m512i k64 = _mm512_broadcast_i32x4(fold_kvec(&crc64_fold, FOLD_2048));
+    __m512i c16[4], c32[4], c64[4], d[4], w[4];
+
+    for (int i = 0; i < 4; i++) {
+        d[i] = _mm512_loadu_si512((const void *)(buf + 64 * i));
+        w[i] = (mask & msb) ? _mm512_shuffle_epi8(d[i], bswap) : d[i];
+        c16[i] = w[i];
+        c32[i] = d[i];
+        c64[i] = w[i];
+    }
+    c16[0] = _mm512_xor_si512(c16[0], _mm512_zextsi128_si512(_mm_set_epi64x((long long)((uint64_t)h->crc16 << 48), 0)));
+    c32[0] = _mm512_xor_si512(c32[0], _mm512_zextsi128_si512(_mm_cvtsi32_si128((int)h->crc32)));
+    c64[0] = _mm512_xor_si512(c64[0], _mm512_zextsi128_si512(_mm_set_epi64x((long long)h->crc64, 0)));
+
+    if (mask & HASH_XXH3) xxh3_drain(&h->xxh3);
+    __m512i acc3 = _mm512_loadu_si512((const void *)h->xxh3.acc);
+    size_t sacc = h->xxh3.stripes_acc;
+    uint64_t v1 = h->xxh64.v[0], v2 = h->xxh64.v[1], v3 = h->xxh64.v[2], v4 = h->xxh64.v[3];
+
+    for (size_t off = 0;;) {
+        const uint8_t *p = buf + off;
+
+        if (mask & HASH_XXH3)
+            for (int i = 0; i < 4; i++) {
+                __m512i k = _mm512_xor_si512(d[i], _mm512_loadu_si512((const void *)(xxh3_secret + sacc * XXH3_CONSUME_RATE)));
+                __m512i m = _mm512_mul_epu32(k, _mm512_srli_epi64(k, 32));
+                acc3 = _mm512_add_epi64(acc3, _mm512_add_epi64(m, _mm512_shuffle_epi32(d[i], (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2))));
+                if (++sacc == XXH3_STRIPES_BLOCK) {
+                    const __m512i prime = _mm512_set1_epi32((int)XXH_P32_1);
+                    const __m512i key = _mm512_loadu_si512((const void *)(xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN));
+                    __m512i a = _mm512_ternarylogic_epi64(acc3, _mm512_srli_epi64(acc3, 47), key, 0x96);
+                    __m512i lo = _mm512_mul_epu32(a, prime);
+                    __m512i hi = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), prime);
+                    acc3 = _mm512_add_epi64(lo, _mm512_slli_epi64(hi, 32));
+                    sacc = 0;
+                }
+            }
+
+        if (mask & HASH_XXH64)
+            for (int i = 0; i < FUSED_BLOCK; i += 32) {
+                v1 = xxh64_round(v1, load_le64(p + i));
+                v2 = xxh64_round(v2, load_le64(p + i + 8));
+                v3 = xxh64_round(v3, load_le64(p + i + 16));
+                v4 = xxh64_round(v4, load_le64(p + i + 24));
+            }
+
+        off += FUSED_BLOCK;
+        if (off == n) break;
+        p = buf + off;
+
+        for (int i = 0; i < 4; i++) {
+            d[i] = _mm512_loadu_si512((const void *)(p + 64 * i));
+            if (mask & msb) w[i] = _mm512_shuffle_epi8(d[i], bswap);
+            if (mask & HASH_CRC16) c16[i] = fold512_xor(c16[i], k16, w[i]);
+            if (mask & HASH_CRC32) c32[i] = fold512_xor(c32[i], k32, d[i]);
+            if (mask & HASH_CRC64) c64[i] = fold512_xor(c64[i], k64, w[i]);
+        }
+    }
+
+    uint8_t r[16];
+    if (mask & HASH_CRC16) {
+        _mm_storeu_si128((__m128i *)r, bswap128(fused_reduce(&crc16_fold, c16)));
+        h->crc16 = crc16_update(0, r, 16);
+    }
+    if (mask & HASH_CRC32) {
+        _mm_storeu_si128((__m128i *)r, fused_reduce(&crc32_fold, c32));
+        h->crc32 = crc32_simd(0, r, 16);
+    }
+    if (mask & HASH_CRC64) {
+        _mm_storeu_si128((__m128i *)r, bswap128(fused_reduce(&crc64_fold, c64)));
+        h->crc64 = crc64_update(0, r, 16);
+    }
+    if (mask & HASH_XXH3) {
+        /* as after xxh3_update(): the last stripe is kept at the end of the buffer */
+        _mm512_storeu_si512((void *)h->xxh3.acc, acc3);
+        h->xxh3.stripes_acc = sacc;
+        h->xxh3.total_len += n;
+        memcpy(h->xxh3.buffer + sizeof(h->xxh3.buffer) - XXH3_STRIPE_LEN, buf + n - XXH3_STRIPE_LEN, XXH3_STRIPE_LEN);
+    }
+    if (mask & HASH_XXH64) {
+        h->xxh64.v[0] = v1; h->xxh64.v[1] = v2; h->xxh64.v[2] = v3; h->xxh64.v[3] = v4;
+        h->xxh64.total_len += n;
+    }
+
+    sp_kernels[mask](h, buf + n, len - n);
+}
+
+#define FUSED_KERNEL_DEFINE(m) \
+    TARGET_VPCLMUL512 static void fused_kernel_##m(struct hash_state *h, const uint8_t *buf, size_t len) { \
+        fused_update(h, buf, len, m); \
+    }
+#define FUSED_KERNEL_ENTRY(m) [m] = fused_kernel_##m,
+
+SP_KERNEL_LIST(FUSED_KERNEL_DEFINE)
+
+static const sp_kernel_fn fused_kernels[HASH_MASKS] = { SP_KERNEL_LIST(FUSED_KERNEL_ENTRY) };
+#endif
+
+/* ================= MULTI-HASH CONTEXT ================= */
+void hash_init(struct hash_state *h, unsigned mask) {
+    libcrc_init();
+    h->mask = mask & HASH_ALL;
+    /* a single hash is already at its best in its own engine */
+#if LIBCRC_X86
+    h->kernel = engines.fused && (h->mask & (h->mask - 1)) ? fused_kernels[h->mask] : sp_kernels[h->mask];
+#else
+    h->kernel = sp_kernels[h->mask];
+#endif
+    h->crc16 = 0xFFFF;
+    h->crc32 = 0xFFFFFFFF;
+    h->crc64 = 0;
+    xxh64_reset(&h->xxh64, 0);
+    xxh3_reset(&h->xxh3);
+}
+
+void hash_update(struct hash_state *h, const void *buf, size_t len) {
+    h->kernel(h, buf, len);
+}
+
+void hash_update_zeros(struct hash_state *h, uint64_t len) {
+    if (h->mask & HASH_CRC16) h->crc16 = crc16_shift(h->crc16, len);
+    if (h->mask & HASH_CRC32) h->crc32 = crc32_shift(h->crc32, len);
+    if (h->mask & HASH_CRC64) h->crc64 = crc64_shift(h->crc64, len);
+    if (h->mask & HASH_XXH64) xxh64_update_zeros(&h->xxh64, len);
+    if (h->mask & HASH_XXH3)  xxh3_update_zeros(&h->xxh3, len);
+}
+
+void hash_final(const struct hash_state *h, struct hash_digest *d) {
+    d->crc16 = h->crc16;
+    d->crc32 = h->crc32 ^ 0xFFFFFFFF;
+    d->crc64 = h->crc64;
+    d->xxh64 = xxh64_digest(&h->xxh64);
+    d->xxh3 = xxh3_64_digest(&h->xxh3);
+    d->xxh128 = xxh3_128_digest(&h->xxh3);
+}
+
+/* ================= LIBRARY INIT ================= */
+static pthread_once_t libcrc_once = PTHREAD_ONCE_INIT;
+
+static void libcrc_setup(void) {
+    detect_cpu();
+    select_engines(best_isa());
+
+    const char *profile = getenv(LIBCRC_PROFILE_ENV);
+    load_profile(profile ? profile : LIBCRC_PROFILE_PATH);
+}
+
+void libcrc_init(void) {
+    pthread_once(&libcrc_once, libcrc_setup);
+}
+
@@ -0,0 +1,242 @@
+/*
+
+libcrc. Copyright (C) 2026 Ino Jacob. All rights reserved.
+
+The hashing engines of CRC Checker as a library: CRC-16 (CCITT), CRC-32C,
+CRC-64 (ECMA-182), xxHash64, XXH3 and XXH3-128, each with the best kernel
+the CPU supports, picked at runtime.
+
+    struct hash_state h;
+    struct hash_digest d;
+
+    hash_init(&h, HASH_CRC32 | HASH_XXH3);
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        hash_update(&h, buf, n);
+    hash_final(&h, &d);
+
+Contexts live wherever the caller puts them, nothing is ever allocated.
+hash_init() sets up the dispatch on first use (the tables are built in);
+call libcrc_init() up front to keep that cost out of the first hash. Every
+function is thread-safe on distinct contexts. select_engines() switches
+the kernels for the whole process and must not run while other threads
+are hashing.
+
+Build: make (libcrc.a, libcrc.so and the crc tool).
+
+*/
+#ifndef LIBCRC_H
+#define LIBCRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIBCRC_API_VERSION 1
+
+#if defined(__GNUC__)
+    #define LIBCRC_API __attribute__((visibility("default")))
+#else
+    #define LIBCRC_API
+#endif
+
+/* ================= HASH SELECTION ================= */
+/* xxH3 and xxH128 are two digests of the same XXH3 state */
+#define HASH_CRC16 0x1u
+#define HASH_CRC32 0x2u
+#define HASH_CRC64 0x4u
+#define HASH_XXH64 0x8u
+#define HASH_XXH3  0x10u
+#define HASH_ALL   0x1Fu
+#define HASH_MASKS 32
+
+/* ================= STATES ================= */
+struct xxh64_state {
+    uint64_t total_len;
+    uint64_t v[4];
+    uint8_t mem[32];
+    uint32_t memsize;
+    uint64_t seed;
+};
+
+struct xxh3_state {
+    uint64_t acc[8] __attribute__((aligned(64)));
+    uint8_t buffer[256] __attribute__((aligned(64)));   /* 4 stripes */
+    uint32_t buffered;
+    size_t stripes_acc;
+    uint64_t total_len;
+};
+
+struct xxh128 {
+    uint64_t lo, hi;
+};
+
+/*
+    Multi-hash context: every hash in mask is computed in one pass over the
+    data. The CRC fields are the raw registers (CRC-32C is not inverted yet).
+*/
+struct hash_state {
+    unsigned mask;
+    void (*kernel)(struct hash_state *h, const uint8_t *buf, size_t len);
+    uint16_t crc16;
+    uint32_t crc32;
+    uint64_t crc64;
+    struct xxh64_state xxh64;
+    struct xxh3_state xxh3;
+};
+
+/* Final values. Hashes outside the mask hold the digest of no data */
+struct hash_digest {
+    uint16_t crc16;
+    uint32_t crc32;
+    uint64_t crc64, xxh64, xxh3;
+    struct xxh128 xxh128;
+};
+
+LIBCRC_API void hash_init(struct hash_state *h, unsigned mask);
+LIBCRC_API void hash_update(struct hash_state *h, const void *buf, size_t len);
+/*
+    As hash_update() over len zero bytes, without the bytes: the CRCs step
+    over them in O(log len), xxHash runs its rounds on no input. For holes.
+*/
+LIBCRC_API void hash_update_zeros(struct hash_state *h, uint64_t len);
+LIBCRC_API void hash_final(const struct hash_state *h, struct hash_digest *d);
+
+/* ================= CRC ================= */
+/*
+    Raw register updates. Start from 0xFFFF (CRC-16), 0xFFFFFFFF (CRC-32C,
+    xor the result with 0xFFFFFFFF) or 0 (CRC-64).
+*/
+LIBCRC_API uint16_t crc16_hash(uint16_t crc, const uint8_t *buf, size_t len);
+LIBCRC_API uint32_t crc32_hash(uint32_t crc, const uint8_t *buf, size_t len);
+LIBCRC_API uint64_t crc64_hash(uint64_t crc, const uint8_t *buf, size_t len);
+
+/* Register after len zero bytes, O(log len) */
+LIBCRC_API uint16_t crc16_shift(uint16_t crc, uint64_t len);
+LIBCRC_API uint32_t crc32_shift(uint32_t crc, uint64_t len);
+LIBCRC_API uint64_t crc64_shift(uint64_t crc, uint64_t len);
+
+/* crc(A || B) from the final crc(A), crc(B) and len(B) */
+LIBCRC_API uint16_t crc16_combine(uint16_t crc1, uint16_t crc2, uint64_t len2);
+LIBCRC_API uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+LIBCRC_API uint64_t crc64_combine(uint64_t crc1, uint64_t crc2, uint64_t len2);
+
+/* ================= CRC CATALOGUE ================= */
+/*
+    Named Rocksoft parameter sets, each with its own generated tables and
+    folding constants, so an uncommon CRC runs as fast as the three above.
+    Names and aliases match case-insensitively ("crc-32/iso-hdlc", "CRC-32").
+    The register is opaque: start from crc_model_init(), feed it through
+    crc_model_update() and turn it into the value with crc_model_final().
+*/
+struct crc_model {
+    const char *name, *alias;   /* alias may be NULL */
+    int width, refin, refout;   /* width 8 to 64 */
+    uint64_t poly, init, xorout;
+    uint64_t check;             /* the CRC of "123456789" */
+};
+
+LIBCRC_API int crc_model_count(void);
+LIBCRC_API const struct crc_model *crc_model_get(int i);
+LIBCRC_API const struct crc_model *crc_model_find(const char *name);
+
+/* m must come from crc_model_get() or crc_model_find() */
+LIBCRC_API uint64_t crc_model_init(const struct crc_model *m);
+LIBCRC_API uint64_t crc_model_update(const struct crc_model *m, uint64_t reg, const void *buf, size_t len);
+LIBCRC_API uint64_t crc_model_final(const struct crc_model *m, uint64_t reg);
+LIBCRC_API uint64_t crc_model_hash(const struct crc_model *m, const void *buf, size_t len);
+
+/* Register after len zero bytes, O(log len); the final crc(A || B) as crcN_combine() */
+LIBCRC_API uint64_t crc_model_shift(const struct crc_model *m, uint64_t reg, uint64_t len);
+LIBCRC_API uint64_t crc_model_combine(const struct crc_model *m, uint64_t crc1, uint64_t crc2, uint64_t len2);
+
+/* ================= xxHash ================= */
+LIBCRC_API void xxh64_reset(struct xxh64_state *st, uint64_t seed);
+LIBCRC_API void xxh64_update(struct xxh64_state *st, const uint8_t *p, size_t len);
+LIBCRC_API uint64_t xxh64_digest(const struct xxh64_state *st);
+LIBCRC_API uint64_t xxh64(const uint8_t *p, size_t len, uint64_t seed);
+
+LIBCRC_API void xxh3_reset(struct xxh3_state *st);
+LIBCRC_API void xxh3_update(struct xxh3_state *st, const uint8_t *p, size_t len);
+LIBCRC_API uint64_t xxh3_64_digest(const struct xxh3_state *st);
+LIBCRC_API struct xxh128 xxh3_128_digest(const struct xxh3_state *st);
+LIBCRC_API uint64_t xxh3_64(const uint8_t *p, size_t len);
+LIBCRC_API struct xxh128 xxh3_128(const uint8_t *p, size_t len);
+
+/* ================= CPU / DISPATCH ================= */
+struct cpu_features {
+    int sse42, ssse3, pclmul, avx, avx2, fma, bmi1, bmi2;
+    int avx512f, avx512bw, avx512vl, vpclmulqdq;
+    int neon, arm_crc32, pmull;                 /* aarch64 */
+};
+
+/* x86 levels, then aarch64 ones: armv8 is NEON + the CRC32 instructions, pmull adds the folding */
+enum isa_level { ISA_SCALAR, ISA_SSE42, ISA_PCLMUL, ISA_AVX2, ISA_AVX512, ISA_ARMV8, ISA_PMULL, ISA_COUNT };
+
+/* CPU detection, the best engines and the tuning profile; runs once */
+LIBCRC_API void libcrc_init(void);
+
+LIBCRC_API const struct cpu_features *libcrc_cpu(void);
+LIBCRC_API int isa_supported(enum isa_level isa);
+LIBCRC_API enum isa_level best_isa(void);
+LIBCRC_API enum isa_level current_isa(void);
+LIBCRC_API const char *isa_name(enum isa_level isa);
+LIBCRC_API int isa_from_name(const char *name);
+LIBCRC_API void select_engines(enum isa_level isa);
+
+/* ================= IMPLEMENTATIONS ================= */
+/*
+    Every kernel of every hash, for benchmarks and per-host tuning. The
+    algorithms are in HASH_* bit order (HASH_CRC16 == 1 << ALGO_CRC16).
+    select_impl() switches one hash like select_engines() switches them
+    all, with the same threading rule. With small_max set, the kernel only
+    takes the calls of up to small_max bytes and the main kernel keeps the
+    rest (CRCs only: XXH3 inputs up to 240 bytes never reach a kernel).
+*/
+enum hash_algo { ALGO_CRC16, ALGO_CRC32, ALGO_CRC64, ALGO_XXH64, ALGO_XXH3, ALGO_COUNT };
+
+struct hash_impl {
+    const char *name;           /* "table", "slice16", "sse4.2", "pclmul", "avx2", "avx512", ... */
+    enum hash_algo algo;
+    enum isa_level isa;         /* the dispatch level that uses it */
+};
+
+LIBCRC_API const char *algo_name(enum hash_algo algo);
+LIBCRC_API int impl_count(enum hash_algo algo);
+LIBCRC_API const struct hash_impl *impl_get(enum hash_algo algo, int i);
+LIBCRC_API const struct hash_impl *impl_find(enum hash_algo algo, const char *name);
+LIBCRC_API int impl_supported(const struct hash_impl *impl);
+
+/* Final digest of p with this kernel (CRC-32C inverted, xxH3 64-bit) */
+LIBCRC_API uint64_t impl_hash(const struct hash_impl *impl, const uint8_t *p, size_t len);
+
+/* 0, or -1 when the CPU lacks the kernel or small_max does not apply */
+LIBCRC_API int select_impl(const struct hash_impl *impl, size_t small_max);
+
+/* Kernel that a call of len bytes runs right now */
+LIBCRC_API const struct hash_impl *current_impl(enum hash_algo algo, size_t len);
+
+/* ================= TUNING PROFILE ================= */
+/*
+    One line per hash: "<algo> <kernel> [<small kernel> <small max>]", as
+    written by crc --benchmark --all-impls --save-profile. libcrc_init()
+    loads $LIBCRC_PROFILE, or LIBCRC_PROFILE_PATH when it is unset (an
+    empty value skips the profile). Kernels this CPU lacks are ignored, so
+    one profile can be shared by hosts of different types.
+*/
+#define LIBCRC_PROFILE_ENV  "LIBCRC_PROFILE"
+#define LIBCRC_PROFILE_PATH "/etc/libcrc.profile"
+
+/* Number of selections applied, or -1 when the file cannot be read */
+LIBCRC_API int libcrc_load_profile(const char *path);
+
+/* Writes the current selection, 0 or -1 with errno set */
+LIBCRC_API int libcrc_save_profile(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif